@@ -42,6 +42,8 @@ public class EDU_CORE : ModuleRules
 				"EnhancedInput",
 				"CommonUI",
 				"PhysicsCore",
+				"NetCore",
+				"ReplicationGraph",
 				"NavigationSystem" 
 				// ... add private dependencies that you statically link with here ...	
 			}
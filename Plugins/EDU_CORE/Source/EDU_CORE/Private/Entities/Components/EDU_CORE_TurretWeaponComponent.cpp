@@ -84,7 +84,8 @@ void UTurretWeaponComponent::BeginPlay()
 	// Server Tick
 	if(GetNetMode() != NM_Client)
 	{
-		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode());
+		if (GameMode)
 		{
 			GameMode->AddToTurretComponentArray(this);
 
@@ -97,6 +98,20 @@ void UTurretWeaponComponent::BeginPlay()
 	}
 }
 
+void UTurretWeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Server Tick
+	if(GetNetMode() != NM_Client)
+	{
+		if (GameMode)
+		{
+			GameMode->RemoveFromTurretComponentArray(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -220,84 +235,102 @@ void UTurretWeaponComponent::ServerTurretExec(float AsyncDeltaTime)
 
 void UTurretWeaponComponent::ServerTimeGatedTurretExec(float AsyncDeltaTime)
 {
+	/*---------------------------------------------------------------------
+	  Priority targets are checked before viable targets. The LOS traces
+	  are batched with every other request this frame, and the callback
+	  engages the first target in sight, before the next Exec.
+	  See EDU_CORE_LineOfSightService.h
+	---------------------------------------------------------------------*/
+	const FVector MyPos = GetOwner()->GetActorLocation();
+
+	TArray<AEDU_CORE_SelectableEntity*> Candidates;
+	TArray<FLineOfSightTarget> Targets;
+
 	if(PriorityTargetsArray.Num() > 0)
 	{
 		// Always do this on the main thread.
-		AsyncTask(ENamedThreads::GameThread, [this]
+		TickLaneAsyncTask([this]
 		{
 			SortTargets(PriorityTargetsArray);
 		});
-		
-		const FVector MyPos = GetOwner()->GetActorLocation();
-		const float MaxRangeSquared = MaxRange * MaxRange; // Squared for a proper comparison with squared distances.
-
-		for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Target : PriorityTargetsArray)
-		{
-			// Forgett the Target if it is Deleted.
-			if(!Target)	{ PriorityTargetsArray.RemoveSingleSwap(Target); continue; }
-			if(!Target->GetStatusComponent()->GetVisibleForTeam(OurTeam)) continue;
-			
-			const FVector TargetPos = Target->GetActorLocation();
-			const float Distance = FVector::DistSquared(MyPos, TargetPos);
-
-			// Forgett the Target if it is outside our combat range.
-			if(Distance > MaxRangeSquared)	{ PriorityTargetsArray.RemoveSingleSwap(Target); continue; }
-
-			// Move on to the next target if we don't have LOS.
-			if(!HasLineOfSight(MyPos, TargetPos, Target)) { continue; }
-			LastKnownTargetPosition = TargetPos;
 
-			AsyncTask(ENamedThreads::GameThread, [this, Target]()
-			{
-				TargetEntity = Target;
-				TurretStatus = EWeaponStatus::Engaged;
-				NoTargetTimer = 0;
-			});
-
-			// Valid Priority Target, exit.
-			return;
-		}
-		// No Valid Priority Target
+		GatherLineOfSightTargets(PriorityTargetsArray, MyPos, Candidates, Targets);
 	}
+	const int32 NumPriorityCandidates = Candidates.Num();
 
 	if(ViableTargetsArray.Num() > 0)
 	{
 	// Always do this on the main thread.
-		AsyncTask(ENamedThreads::GameThread, [this]
+		TickLaneAsyncTask([this]
 		{
 			SortTargets(ViableTargetsArray);
 		});
-		
-		const FVector MyPos = GetOwner()->GetActorLocation();
-		const float MaxRangeSquared = MaxRange * MaxRange; // Squared for a proper comparison with squared distances.
 
-		for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Target : ViableTargetsArray)
-		{
-			// Forgett the Target if it is Deleted.
-			if(!Target)	{ ViableTargetsArray.RemoveSingleSwap(Target); continue; }
-			if(!Target->GetStatusComponent()->GetVisibleForTeam(OurTeam)) continue;
-			
-			const FVector TargetPos = Target->GetActorLocation();
-			const float Distance = FVector::DistSquared(MyPos, TargetPos);
+		GatherLineOfSightTargets(ViableTargetsArray, MyPos, Candidates, Targets);
+	}
 
-			// Forgett the Target if it is outside our combat range.
-			if(Distance > MaxRangeSquared)	{ ViableTargetsArray.RemoveSingleSwap(Target); continue; }
+	if(Candidates.Num() == 0 || !GameMode)
+	{
+		// Always do this on the main thread.
+		TickLaneAsyncTask([this]
+		{
+			OnNoTargetFound();
+		});
+		return;
+	}
 
-			// Move on to the next target if we don't have LOS.
-			if(!HasLineOfSight(MyPos, TargetPos, Target)) { continue; }
+	// A hit within 100 units of the target counts, the target may be behind light cover.
+	GameMode->GetLineOfSightService().RequestFirstVisible(this, GetOwner(), ECC_Visibility, 100.f, MoveTemp(Targets),
+		[this, MyPos, Candidates = MoveTemp(Candidates), NumPriorityCandidates](const int32 FirstVisibleIndex)
+		{
+			if(FirstVisibleIndex == INDEX_NONE || !IsValid(Candidates[FirstVisibleIndex]))
+			{
+				OnNoTargetFound();
+				return;
+			}
 
-			AsyncTask(ENamedThreads::GameThread, [this, Target]()
+			AEDU_CORE_SelectableEntity* Target = Candidates[FirstVisibleIndex];
+			if(FirstVisibleIndex < NumPriorityCandidates)
 			{
-				TargetEntity = Target;
-				TurretStatus = EWeaponStatus::Engaged;
-				NoTargetTimer = 0;
-			});
-			// Valid Target, exit.
-			return;
-		}
-		// No Valid Target
-	} 
-	
+				LastKnownTargetPosition = Target->GetActorLocation();
+			}
+
+			TargetEntity = Target;
+			TurretStatus = EWeaponStatus::Engaged;
+			NoTargetTimer = 0;
+
+		#if WITH_EDITOR
+			// Emerald line indicates confirmation.
+			DrawDebugLine(GetWorld(), MyPos, Target->GetActorLocation(), FColor::Emerald, false, 1.0f, 0, 1.0f);
+		#endif
+		});
+}
+
+void UTurretWeaponComponent::GatherLineOfSightTargets(TArray<TObjectPtr<AEDU_CORE_SelectableEntity>>& TargetArray, const FVector& MyPos,
+	TArray<AEDU_CORE_SelectableEntity*>& OutCandidates, TArray<FLineOfSightTarget>& OutTargets)
+{
+	const float MaxRangeSquared = MaxRange * MaxRange; // Squared for a proper comparison with squared distances.
+
+	for(int32 Index = 0; Index < TargetArray.Num(); ++Index)
+	{
+		AEDU_CORE_SelectableEntity* Target = TargetArray[Index];
+
+		// Forgett the Target if it is Deleted.
+		if(!Target)	{ TargetArray.RemoveAt(Index--); continue; }
+		if(!Target->GetStatusComponent()->GetVisibleForTeam(OurTeam)) continue;
+
+		const FVector TargetPos = Target->GetActorLocation();
+
+		// Forgett the Target if it is outside our combat range.
+		if(FVector::DistSquared(MyPos, TargetPos) > MaxRangeSquared) { TargetArray.RemoveAt(Index--); continue; }
+
+		OutCandidates.Add(Target);
+		OutTargets.Add({ Target, MyPos, TargetPos });
+	}
+}
+
+void UTurretWeaponComponent::OnNoTargetFound()
+{
 	NoTargetTimer++;
 	TurretStatus = EWeaponStatus::Searching;
 	if(NoTargetTimer > 10)
@@ -434,58 +467,4 @@ void UTurretWeaponComponent::SortTargets(TArray<TObjectPtr<AEDU_CORE_SelectableE
 		break;
 	default: ;
 	}
-}
-
-bool UTurretWeaponComponent::HasLineOfSight(const FVector& StartPos, const FVector& EndPos, const TObjectPtr<AEDU_CORE_SelectableEntity>& Target) const
-{
-	// Define collision parameters (ignore the owner or any specific actors if needed)
-	FCollisionQueryParams TraceParams;
-	TraceParams.AddIgnoredActor(GetOwner()); // Ignore the weapon owner (e.g., the player or entity)
-
-	// Perform the line trace
-	FHitResult HitResult;
-	bool bHit = GetWorld()->LineTraceSingleByChannel(
-		HitResult,        // Out hit result
-		StartPos,         // Trace start position
-		EndPos,           // Trace end position
-		ECC_Visibility,   // Collision channel (visibility channel)
-		TraceParams       // Collision query parameters
-	);
-
-	// If a hit occurs, check if it's the target or an obstacle
-	if (bHit)
-	{
-		// Check if the hit actor is the target
-		if(HitResult.GetActor() && HitResult.GetActor() == Target)
-		{
-			#if WITH_EDITOR
-			//if(bDrawSightDebugLine)
-			{
-				// Green line indicates confirmation.
-				if(!IsInGameThread())
-				{
-					// If not, queue the function to run on the main thread
-					AsyncTask(ENamedThreads::GameThread, [this, StartPos, EndPos]
-					{
-						DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Emerald, false, 1.0f, 0, 1.0f);
-					});
-				}
-				else
-				{
-					DrawDebugLine(GetWorld(), StartPos, EndPos, FColor::Emerald, false, 1.0f, 0, 1.0f);
-				}
-			}
-			#endif
-			return true; // The target is hit directly
-		}
-
-		// If no hit occurs, check the distance to the target position
-		const float DistanceFromImpactSquared = FVector::DistSquared(EndPos, HitResult.ImpactPoint);
-		if(DistanceFromImpactSquared < FMath::Square(100.f))
-		{
-			return true; // Close enough to the target, return true (i.e., line of sight exists)
-		}
-	}
-	
-	return false; // No hit and not within range of the target
 }
\ No newline at end of file
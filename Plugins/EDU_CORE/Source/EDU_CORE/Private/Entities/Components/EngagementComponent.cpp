@@ -85,6 +85,17 @@ void UEngagementComponent::BeginPlay()
 	EnsureStatusComponent();
 }
 
+void UEngagementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Server Tick
+	if(GameMode)
+	{
+		GameMode->RemoveFromEngagementComponentArray(this);
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -139,51 +150,28 @@ void UEngagementComponent::ServerEngagementComponentExec(float AsyncDeltaTime)
 void UEngagementComponent::SearchForTargets(float SearchRange)
 {  // FLOW_LOG
 	/*---------------------------------------------------------------------
-	  This function checks for actors of a certain objectype in a sphere.
+	  This function checks for entities in a sphere around us, using the
+	  Spatial Grid in the GameMode.
 	  
-	  The actors don't need or have "generate overlap events" enabled,
-	  nor do they need to block any specific channel. They only have
-	  to be of the object type we search for.
-
-	  #include "Engine/OverlapResult.h"
+	  The entities don't need to "generate overlap events", they only need
+	  a StatusComponent to be in the grid. Like the old overlap, entities
+	  whose root collides as another object than TargetObjectType are skipped.
 	---------------------------------------------------------------------*/
 	
-	// Define object types to check, add more as needed
-	FCollisionObjectQueryParams ObjectQueryParams;
-	ObjectQueryParams.AddObjectTypesToQuery(TargetObjectType);
-	
-	// Team 0 is used here unless a team is specified.
-	FCollisionQueryParams CollisionQueryParams;
-	const TArray<AActor*>& HiddenActors = GameMode->GetTeamHiddenActorsArray(OurTeam);
-	const TArray<AActor*>& TeamActors = GameMode->GetTeamArray(OurTeam);
-
-	CollisionQueryParams.AddIgnoredActors(HiddenActors);
-	CollisionQueryParams.AddIgnoredActors(TeamActors);
-	
-	FQuat Rotation = FQuat::Identity;
-	
-	FCollisionShape Shape = FCollisionShape::MakeSphere(SearchRange);
 	FVector Center = GetOwner()->GetActorLocation();
 
 	// Make ready the DetectedTargetsArray for new targets.
-	TArray<FOverlapResult> TargetsInRangeArray;
-
-	// Perform the shape overlap
-	GetWorld()->OverlapMultiByObjectType(
-		TargetsInRangeArray,		// Array to hold results
-		Center,						// Center of the sphere
-		Rotation,					// Rotation
-		ObjectQueryParams,			// Object types to overlap (e.g., ECC_Destructible)
-		Shape,						// Shape to check (FieldOfVisionType)
-		CollisionQueryParams		// Collision filter
-	);
+	TArray<AActor*> TargetsInRangeArray;
+
+	// Friendly and hidden entities are skipped by team.
+	GameMode->QueryEntitiesInRadius(Center, SearchRange, OurTeam, ETeamQueryFilter::Friendly | ETeamQueryFilter::Hidden, TargetObjectType, TargetsInRangeArray);
 
 	// Optional: Draw a debug sphere (only in debug mode)
 	#if WITH_EDITOR
 		if (bDrawSearchForTargetsDebugShape)
 		{
 			// Always do this on the main thread.
-			AsyncTask(ENamedThreads::GameThread, [this, Center]()
+			TickLaneAsyncTask([this, Center]()
 			{
 				DrawDebugSphere(GetWorld(), Center, MaxRange, 24, FColor::Emerald, false, 0.5f);
 			});
@@ -227,7 +215,7 @@ void UEngagementComponent::EnsureStatusComponent()
 }
 
 template <typename WeaponComponentType>
-int8 UEngagementComponent::EvaluateTargetsInRange(TObjectPtr<WeaponComponentType>& WeaponMount, const TArray<FOverlapResult>& TargetsInRangeArray)
+int8 UEngagementComponent::EvaluateTargetsInRange(TObjectPtr<WeaponComponentType>& WeaponMount, const TArray<AActor*>& TargetsInRangeArray)
 {
 	int8 EffectiveWeapons = 0;
 	// WeaponMount->ViableTargetsArray.Reset();
@@ -240,9 +228,8 @@ int8 UEngagementComponent::EvaluateTargetsInRange(TObjectPtr<WeaponComponentType
 	for (const FProjectileWeaponInformation& Weapon : WeaponInfoStruct)
 	{
 		// Iterate over all targets in range
-		for (const FOverlapResult& OverlapResult : TargetsInRangeArray)
+		for (AActor* OverlappingActor : TargetsInRangeArray)
 		{
-			TObjectPtr<AActor> OverlappingActor = OverlapResult.GetActor();
 			if (!OverlappingActor) continue;
 
 			TObjectPtr<AEDU_CORE_SelectableEntity> Target = Cast<AEDU_CORE_SelectableEntity>(OverlappingActor);
@@ -46,7 +46,8 @@ void UFixedWeaponComponent::BeginPlay()
 	// Server Tick
 	if(GetNetMode() != NM_Client)
 	{
-		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode());
+		if (GameMode)
 		{
 			GameMode->AddToFixedWeaponComponentArray(this);
 
@@ -58,6 +59,20 @@ void UFixedWeaponComponent::BeginPlay()
 	}
 }
 
+void UFixedWeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Server Tick
+	if(GetNetMode() != NM_Client)
+	{
+		if (GameMode)
+		{
+			GameMode->RemoveFromFixedWeaponComponentArray(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -83,43 +98,65 @@ void UFixedWeaponComponent::ServerTimeGatedFixedWeaponExec(float AsyncDeltaTime)
 	if(PriorityTargetsArray.Num() > 0)
 	{
 		SortTargets(TargetPriority, PriorityTargetsArray);
-
-		const FVector MyPos = GetOwner()->GetActorLocation();
-		for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Target: PriorityTargetsArray)
-		{
-			FVector TargetPos = Target->GetActorLocation();
-			if(FVector::DistSquared(MyPos,Target->GetActorLocation()) > MaxRange) continue;
-			
-			if(!HasLineOfSight(MyPos, TargetPos, Target)) continue;
-
-			TargetEntity = Target;
-			FixedWeaponStatus = EWeaponStatus::Engaged;
-			return;
-		}
+		RequestTargetInSight(PriorityTargetsArray, EWeaponStatus::Engaged);
+	}
+	else if(ViableTargetsArray.Num() > 0)
+	{
+		SortTargets(TargetPriority, ViableTargetsArray);
+		RequestTargetInSight(ViableTargetsArray, EWeaponStatus::Supporting);
 	}
 	else
 	{
-		if(ViableTargetsArray.Num() > 0)
-		{
-			SortTargets(TargetPriority, ViableTargetsArray);
+		if(FixedWeaponStatus > EWeaponStatus::Ready)
+		FixedWeaponStatus = EWeaponStatus::Ready;
+	}
+}
 
-			const FVector MyPos = GetOwner()->GetActorLocation();
-			for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Target: PriorityTargetsArray)
-			{
-				FVector TargetPos = Target->GetActorLocation();
-				if(FVector::DistSquared(MyPos,Target->GetActorLocation()) > MaxRange) continue;
-				
-				if(!HasLineOfSight(MyPos, TargetPos, Target)) continue;
+void UFixedWeaponComponent::RequestTargetInSight(const TArray<TObjectPtr<AEDU_CORE_SelectableEntity>>& TargetArray, const EWeaponStatus NewStatus)
+{
+	/*---------------------------------------------------------------------
+	  The LOS traces are batched with every other request this frame, and
+	  the callback engages the first target in sight before the next Exec.
+	  See EDU_CORE_LineOfSightService.h
+	---------------------------------------------------------------------*/
+	const FVector MyPos = GetOwner()->GetActorLocation();
+	const float MaxRangeSquared = MaxRange * MaxRange; // Squared for a proper comparison with squared distances.
+
+	TArray<AEDU_CORE_SelectableEntity*> Candidates;
+	TArray<FLineOfSightTarget> Targets;
+
+	for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Target : TargetArray)
+	{
+		if(!Target) continue;
 
-				TargetEntity = Target;
-				FixedWeaponStatus = EWeaponStatus::Supporting;
+		const FVector TargetPos = Target->GetActorLocation();
+		if(FVector::DistSquared(MyPos, TargetPos) > MaxRangeSquared) continue;
+
+		Candidates.Add(Target);
+		Targets.Add({ Target, MyPos, TargetPos });
+	}
+
+	if(Candidates.Num() == 0 || !GameMode)
+	{
+		if(FixedWeaponStatus > EWeaponStatus::Ready)
+		FixedWeaponStatus = EWeaponStatus::Ready;
+		return;
+	}
+
+	// A hit within 100 units of the target counts, the target may be behind light cover.
+	GameMode->GetLineOfSightService().RequestFirstVisible(this, GetOwner(), ECC_Visibility, 100.f, MoveTemp(Targets),
+		[this, Candidates = MoveTemp(Candidates), NewStatus](const int32 FirstVisibleIndex)
+		{
+			if(FirstVisibleIndex != INDEX_NONE && IsValid(Candidates[FirstVisibleIndex]))
+			{
+				TargetEntity = Candidates[FirstVisibleIndex];
+				FixedWeaponStatus = NewStatus;
 				return;
 			}
-		}
-	}
 
-	if(FixedWeaponStatus > EWeaponStatus::Ready)
-	FixedWeaponStatus = EWeaponStatus::Ready;
+			if(FixedWeaponStatus > EWeaponStatus::Ready)
+			FixedWeaponStatus = EWeaponStatus::Ready;
+		});
 }
 
 //------------------------------------------------------------------------------
@@ -252,39 +289,3 @@ void UFixedWeaponComponent::SortTargets(const ETargetPriority InTargetPriority,
 	default: ;
 	}
 }
-
-bool UFixedWeaponComponent::HasLineOfSight(const FVector& StartPos, const FVector& EndPos, const TObjectPtr<AEDU_CORE_SelectableEntity>& Target) const
-{
-	// Define collision parameters (ignore the owner or any specific actors if needed)
-	FCollisionQueryParams TraceParams;
-	TraceParams.AddIgnoredActor(GetOwner()); // Ignore the weapon owner (e.g., the player or entity)
-
-	// Perform the line trace
-	FHitResult HitResult;
-	bool bHit = GetWorld()->LineTraceSingleByChannel(
-		HitResult,        // Out hit result
-		StartPos,         // Trace start position
-		EndPos,           // Trace end position
-		ECC_Visibility,   // Collision channel (visibility channel)
-		TraceParams       // Collision query parameters
-	);
-
-	// If a hit occurs, check if it's the target or an obstacle
-	if (bHit)
-	{
-		// Check if the hit actor is the target
-		if(HitResult.GetActor() && HitResult.GetActor() == Target)
-		{
-			return true; // The target is hit directly
-		}
-
-		// If no hit occurs, check the distance to the target position
-		const float DistanceFromImpactSquared = FVector::DistSquared(EndPos, HitResult.ImpactPoint);
-		if(DistanceFromImpactSquared < FMath::Square(100.f))
-		{
-			return true; // Close enough to the target, return true (i.e., line of sight exists)
-		}
-	}
-	
-	return false; // No hit and not within range of the target
-}
@@ -69,6 +69,17 @@ void USenseComponent::BeginPlay()
 	}
 }
 
+void USenseComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{	FLOW_LOG
+	// Server Tick
+	if(GameMode)
+	{
+		GameMode->RemoveFromSightComponentArray(this);
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -116,13 +127,12 @@ void USenseComponent::UpdateBatchIndex(const int32 ServerBatchIndex)
 void USenseComponent::DetectActorsInFOV()
 { // FLOW_LOG
 	/*---------------------------------------------------------------------
-	  This function checks for actors of a certain objectype in a sphere.
+	  This function checks for entities in a sphere, or a capsule in front
+	  of us, using the Spatial Grid in the GameMode.
 	  
-	  The actors don't need or have "generate overlap events" enabled,
-	  nor do they need to block any specific channel. They only have
-	  to be of the object type we search for.
-
-	  #include "Engine/OverlapResult.h"
+	  The entities don't need to "generate overlap events", they only need
+	  a StatusComponent to be in the grid. Like the old overlap, entities
+	  whose root collides as another object than SenseObjectType are skipped.
 	---------------------------------------------------------------------*/
 	EEDU_CORE_Team OurTeam = StatusComponent->GetActiveTeam();
 
@@ -141,46 +151,46 @@ void USenseComponent::DetectActorsInFOV()
 	FVector ForwardVector = CombinedTransform.GetRotation().GetForwardVector();
 	FVector LOSCenterLocation = ComponentLocation + (ForwardVector * SightFocusLength);
 
-	// Define object types to check, add more as needed
-	FCollisionObjectQueryParams ObjectQueryParams;
-	ObjectQueryParams.AddObjectTypesToQuery(SenseObjectType);
-
-	FCollisionQueryParams CollisionQueryParams;
-	CollisionQueryParams.AddIgnoredActor(Owner);
-
-	// Team 0 is used here unless a team is specified.
-	CollisionQueryParams.AddIgnoredActors(GameMode->GetTeamVisibleActorsArray(OurTeam));
-	CollisionQueryParams.AddIgnoredActors(GameMode->GetTeamArray(OurTeam));
-
 	FQuat Rotation = FQuat::Identity;
+	const ETeamQueryFilter QueryFilter = ETeamQueryFilter::Friendly | ETeamQueryFilter::Visible;
 
-	FCollisionShape Shape;
 	if (FieldOfVisionType == EFieldOfVisionType::EFOV_Sphere)
 	{
-		Shape = FCollisionShape::MakeSphere(SightRadius);
+		GameMode->QueryEntitiesInRadius(LOSCenterLocation, SightRadius, OurTeam, QueryFilter, SenseObjectType, SensedActorsArray);
+
+		if(GameMode->IsFogOfWarEnabled())
+		{
+			GameMode->GetFogOfWar().StampCircle(ComponentLocation, LOSCenterLocation, SightRadius, OurTeam);
+		}
 	}
 	else
 	{
 		Rotation = FRotationMatrix::MakeFromZX(ForwardVector, Owner->GetActorUpVector()).ToQuat();
-		Shape = FCollisionShape::MakeCapsule(SightRadius, SightFocusLength);
-	}
 
-	// Perform the shape overlap
-	GetWorld()->OverlapMultiByObjectType(
-		SensedActorsArray,		// Array to hold results
-		LOSCenterLocation,		// Center of the sphere
-		Rotation,				// Rotation
-		ObjectQueryParams,		// Object types to overlap (e.g., ECC_Destructible)
-		Shape,					// Shape to check (FieldOfVisionType)
-		CollisionQueryParams	// Collision filter
-	);
+		// A capsule with its axis along ForwardVector, SightFocusLength is the half height including the caps.
+		const float HalfSegmentLength = FMath::Max(SightFocusLength - SightRadius, 0.f);
+		const FVector SegmentStart = LOSCenterLocation - ForwardVector * HalfSegmentLength;
+		const FVector SegmentEnd = LOSCenterLocation + ForwardVector * HalfSegmentLength;
+		const float SightRadiusSquared = FMath::Square(SightRadius);
+
+		GameMode->QueryEntitiesInRadius(LOSCenterLocation, FMath::Max(SightFocusLength, SightRadius), OurTeam, QueryFilter, SenseObjectType, SensedActorsArray);
+		SensedActorsArray.RemoveAllSwap([&](const AActor* Actor)
+		{
+			return FMath::PointDistToSegmentSquared(Actor->GetActorLocation(), SegmentStart, SegmentEnd) > SightRadiusSquared;
+		}, EAllowShrinking::No);
+
+		if(GameMode->IsFogOfWarEnabled())
+		{
+			GameMode->GetFogOfWar().StampCapsule(ComponentLocation, SegmentStart, SegmentEnd, SightRadius, OurTeam);
+		}
+	}
 
 	// Optional: Draw a debug sphere (only in debug mode)
 	#if WITH_EDITOR
 		if (bDrawSightDebugShape)
 		{
 			// Always do this on the main thread.
-			AsyncTask(ENamedThreads::GameThread, [this, LOSCenterLocation, Rotation]()
+			TickLaneAsyncTask([this, LOSCenterLocation, Rotation]()
 			{
 				if (FieldOfVisionType == EFieldOfVisionType::EFOV_Sphere)
 				{
@@ -197,9 +207,9 @@ void USenseComponent::DetectActorsInFOV()
 	// Log overlapping actors if any
 	if (SensedActorsArray.Num() > 0)
 	{
-		for (const FOverlapResult& OverlapResult : SensedActorsArray)
+		for (AActor* OverlappingActor : SensedActorsArray)
 		{
-			if(AActor* OverlappingActor = OverlapResult.GetActor())
+			if(OverlappingActor)
 			{
 				if(AEDU_CORE_SelectableEntity* SelectableEntity = Cast<AEDU_CORE_SelectableEntity>(OverlappingActor))
 				{
@@ -216,15 +226,9 @@ void USenseComponent::DetectActorsInFOV()
 						// If DetectionChance is positive, check it
 							if (DetectionChance > 0 && FMath::RandRange(1, 100) <= DetectionChance)
 							{
-								if (GetVisualConfirmation(ComponentLocation, SelectableEntity->GetActorLocation(), SelectableEntity))
-								{
-									AsyncTask(ENamedThreads::GameThread, [this, SelectableEntity, OurTeam, TargetStatusComponent]()
-									{
-										// Make sure the entity is invisible to avoid duplicates.
-										SetEntityTeamVisibility(SelectableEntity, OurTeam, TargetStatusComponent);
-									});
-									continue; // Continue for loop if thermal detection is successful.
-								}
+								// Sight would trace the same line, so there is nothing left to check.
+								RequestVisualConfirmation(ComponentLocation, SelectableEntity, OurTeam, TargetStatusComponent);
+								continue; // Continue for loop if thermal detection is successful.
 							}
 						// Fall through to Sight detection if no detection yet.
 							
@@ -235,13 +239,7 @@ void USenseComponent::DetectActorsInFOV()
 						// If DetectionChance is positive, check it
 							if (DetectionChance > 0 && FMath::RandRange(1, 100) <= DetectionChance)
 							{
-								if (GetVisualConfirmation(ComponentLocation, SelectableEntity->GetActorLocation(), SelectableEntity))
-								{
-									AsyncTask(ENamedThreads::GameThread, [this, SelectableEntity, OurTeam, TargetStatusComponent]()
-									{
-										SetEntityTeamVisibility(SelectableEntity, OurTeam, TargetStatusComponent);
-									});
-								}
+								RequestVisualConfirmation(ComponentLocation, SelectableEntity, OurTeam, TargetStatusComponent);
 							}
 							break;
 						default:;
@@ -256,119 +254,71 @@ void USenseComponent::DetectActorsInFOV()
 	SensedActorsArray.Reset();
 }
 
-bool USenseComponent::GetVisualConfirmation(const FVector& StartLocation, const FVector& EndLocation, const AActor* ActorToConfirm) const
+void USenseComponent::RequestVisualConfirmation(const FVector& StartLocation, AEDU_CORE_SelectableEntity* SelectableEntity, const EEDU_CORE_Team OurTeam, UStatusComponent* TargetStatusComponent)
 {
 	// FLOW_LOG
-	// Check if we have a valid world context
-	UWorld* World = GetWorld();
-	if (!World)
-	{
-		return false;
-	}
-
-	// Set up the trace parameters (collision settings)
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(Owner); // Optionally ignore the actor to confirm
-
-	// Set up the collision channel (ECC_Visibility or another suitable channel)
-	FHitResult HitResult;
-
-	// Perform the line trace (single hit)
-	World->LineTraceSingleByChannel(
-		HitResult,					// The result of the trace
-		StartLocation,				// Starting location of the trace
-		EndLocation,				// Ending location of the trace
-		SenseObjectType,			// Collision channel to trace for
-		QueryParams					// Query parameters
-	);
+	/*---------------------------------------------------------------------
+	  With Fog of War, the entity is confirmed if its cell is visible to
+	  our team, see EDU_CORE_FogOfWarGrid.h.
+	  
+	  Otherwise the trace is batched with every other LOS request this
+	  frame, see EDU_CORE_LineOfSightService.h. The callback runs on the
+	  game thread, so it can set visibility and draw directly.
+	---------------------------------------------------------------------*/
+	const FVector EndLocation = SelectableEntity->GetActorLocation();
 
-	// Optional: draw a debug line for visualization
-	if (HitResult.GetActor() == ActorToConfirm)
+	if(GameMode->IsFogOfWarEnabled())
 	{
-	#if WITH_EDITOR
-		if(bDrawSightDebugLine)
+		if(GameMode->IsLocationVisibleToTeam(EndLocation, OurTeam))
 		{
-			// Green line indicates confirmation.
-			if(!IsInGameThread())
-			{
-				// If not, queue the function to run on the main thread
-				AsyncTask(ENamedThreads::GameThread, [this, World, EndLocation, StartLocation]
-				{
-					DrawDebugLine(World, StartLocation, EndLocation, FColor::Green, false, 1.0f, 0, 1.0f);
-				});
-			}
-			else
+			TickLaneAsyncTask([this, SelectableEntity, OurTeam, TargetStatusComponent]()
 			{
-				DrawDebugLine(World, StartLocation, EndLocation, FColor::Green, false, 1.0f, 0, 1.0f);
-			}
+				SetEntityTeamVisibility(SelectableEntity, OurTeam, TargetStatusComponent);
+			});
 		}
-	#endif
-		
-		return true;
+		return;
 	}
-	
-	#if WITH_EDITOR
-	if (bDrawSightDebugLine)
-	{
-		// Red line indicates fail.
-		if(!IsInGameThread())
+
+	// ECC_Visibility like the weapons, so their traces can be shared. SenseObjectType only filters what we sense.
+	GameMode->GetLineOfSightService().RequestLineOfSight(this, Owner, ECC_Visibility, 0.f, { SelectableEntity, StartLocation, EndLocation },
+		[this, StartLocation, EndLocation, SelectableEntity, OurTeam, TargetStatusComponent](const bool bHasLineOfSight)
 		{
-			// If not, queue the function to run on the main thread
-			AsyncTask(ENamedThreads::GameThread, [this, World, EndLocation, StartLocation]
+		#if WITH_EDITOR
+			if(bDrawSightDebugLine)
 			{
-				DrawDebugLine(World, StartLocation, EndLocation, FColor::Red, false, 1.0f, 0, 1.0f);
-			});
-		}
-		else
-		{
-			DrawDebugLine(World, StartLocation, EndLocation, FColor::Red, false, 1.0f, 0, 1.0f);
-		}
-	}
-	#endif
-	
-	return false;
+				// Green line indicates confirmation, red indicates fail.
+				DrawDebugLine(GetWorld(), StartLocation, EndLocation, bHasLineOfSight ? FColor::Green : FColor::Red, false, 1.0f, 0, 1.0f);
+			}
+		#endif
+
+			if(bHasLineOfSight && IsValid(SelectableEntity) && IsValid(TargetStatusComponent))
+			{
+				// Make sure the entity is invisible to avoid duplicates.
+				SetEntityTeamVisibility(SelectableEntity, OurTeam, TargetStatusComponent);
+			}
+		});
 }
 
 void USenseComponent::Listen()
 { // FLOW_LOG
 	/*---------------------------------------------------------------------
-	  This function checks for actors of a certain objectype in a sphere.
+	  This function checks for entities in a sphere around us, using the
+	  Spatial Grid in the GameMode.
 	  
-	  The actors don't need or have "generate overlap events" enabled,
-	  nor do they need to block any specific channel. They only have
-	  to be of the object type we search for.
-
-	  #include "Engine/OverlapResult.h"
+	  The entities don't need to "generate overlap events", they only need
+	  a StatusComponent to be in the grid. Like the old overlap, entities
+	  whose root collides as another object than SenseObjectType are skipped.
 	---------------------------------------------------------------------*/
 	EEDU_CORE_Team OurTeam = StatusComponent->GetActiveTeam();
 
-	// Define object types to check, add more as needed
-	FCollisionObjectQueryParams ObjectQueryParams;
-	ObjectQueryParams.AddObjectTypesToQuery(SenseObjectType);
-
-	FCollisionQueryParams CollisionQueryParams;
-	CollisionQueryParams.AddIgnoredActor(Owner);
-
-	// Team 0 is used here unless a team is specified.
-	CollisionQueryParams.AddIgnoredActors(GameMode->GetTeamVisibleActorsArray(OurTeam));
-	CollisionQueryParams.AddIgnoredActors(GameMode->GetTeamArray(OurTeam));
-
-	// Perform the shape overlap
-	GetWorld()->OverlapMultiByObjectType(
-		SensedActorsArray, // Array to hold results
-		Owner->GetActorLocation(), // Center of the sphere
-		FQuat::Identity, // Rotation
-		ObjectQueryParams, // Object types to overlap (e.g., ECC_Destructible)
-		FCollisionShape::MakeSphere(HearingRadius), // Shape to check
-		CollisionQueryParams // Collision filter
-	);
+	GameMode->QueryEntitiesInRadius(Owner->GetActorLocation(), HearingRadius, OurTeam, ETeamQueryFilter::Friendly | ETeamQueryFilter::Visible, SenseObjectType, SensedActorsArray);
 
 	// Optional: Draw a debug sphere (only in debug mode)
 #if WITH_EDITOR
 	if (bDrawHearningDebugShape)
 	{
 		// Always do this on the main thread.
-		AsyncTask(ENamedThreads::GameThread, [this]()
+		TickLaneAsyncTask([this]()
 		{
 			DrawDebugSphere(GetWorld(), Owner->GetActorLocation(), HearingRadius, 24, FColor::Orange, false, 0.5f);
 		});
@@ -378,9 +328,9 @@ void USenseComponent::Listen()
 	// Log overlapping actors if any
 	if (SensedActorsArray.Num() > 0)
 	{
-		for (const FOverlapResult& OverlapResult : SensedActorsArray)
+		for (AActor* OverlappingActor : SensedActorsArray)
 		{
-			if (AActor* OverlappingActor = OverlapResult.GetActor())
+			if (OverlappingActor)
 			{
 				if (AEDU_CORE_SelectableEntity* SelectableEntity = Cast<AEDU_CORE_SelectableEntity>(OverlappingActor))
 				{
@@ -398,7 +348,7 @@ void USenseComponent::Listen()
 						// Generate a random failure between 1 and 100 and pray it's less than DetectionChance
 						if (FMath::RandRange(1, 100) <= DetectionChance)
 						{
-							AsyncTask(ENamedThreads::GameThread, [this, SelectableEntity, OurTeam, TargetStatusComponent]()
+							TickLaneAsyncTask([this, SelectableEntity, OurTeam, TargetStatusComponent]()
 							{
 								SetEntityTeamVisibility(SelectableEntity, OurTeam, TargetStatusComponent);
 							});	
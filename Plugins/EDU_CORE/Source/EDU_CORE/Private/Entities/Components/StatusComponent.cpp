@@ -7,10 +7,14 @@
 // CORE
 #include "Framework/Data/FLOWLOGS/FLOWLOG_COMPONENTS.h"
 #include "Framework/Managers/GameModes/EDU_CORE_GameMode.h"
+#include "Entities/EDU_CORE_MobileEntity.h"
 
 // UE
 #include "Framework/Pawns/EDU_CORE_C2_Camera.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+static_assert(sizeof(FTeamVisibility::FTeamMask) == sizeof(uint16), "VisibleToTeams is declared as uint16 for UHT.");
 
 //------------------------------------------------------------------------------
 // Construction & Init
@@ -22,7 +26,11 @@ UStatusComponent::UStatusComponent(const FObjectInitializer& ObjectInitializer)
     // Never Tick!
     PrimaryComponentTick.bCanEverTick = false;
     PrimaryComponentTick.bStartWithTickEnabled = false;
-    
+
+    for(float& LastSeen : LastSeenByTeam)
+    {
+        LastSeen = -UE_BIG_NUMBER;
+    }
 }
 
 void UStatusComponent::OnRegister()
@@ -56,6 +64,21 @@ void UStatusComponent::BeginPlay()
 
     // This doesn't seem strictly necessary, but it's good practice.
     ChangeTeam(ActiveTeam);
+
+    // Every other team sees us for SpawnVisibilityTime, counted down like any sighting.
+    if(GameMode && SpawnVisibilityTime > 0)
+    {
+        const float Clock = GameMode->GetAsyncedClock();
+        for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+        {
+            const EEDU_CORE_Team Team = static_cast<EEDU_CORE_Team>(TeamIndex);
+            if(Team == ActiveTeam) continue;
+
+            SetVisibleForTeam(Team, true);
+            LastSeenByTeam[TeamIndex] = Clock - (VisibilityTimer - FMath::Min(SpawnVisibilityTime, VisibilityTimer));
+            QueueVisibilityExpiry(Team, Clock);
+        }
+    }
     
     if(ActiveTeam != EEDU_CORE_Team::Spectator)
     {
@@ -64,22 +87,29 @@ void UStatusComponent::BeginPlay()
     }
 }
 
+void UStatusComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{ FLOW_LOG
+    // Server Tick
+    if(GameMode)
+    {
+        GameMode->RemoveFromStatusComponentArray(this);
+
+        // Other teams shouldn't be able to see, ignore or target us anymore.
+        GameMode->RemoveActorFromTeamArray(GetOwner(), ActiveTeam);
+        GameMode->RemoveActorFromAllVisibilityArrays(GetOwner());
+    }
+    
+    Super::EndPlay(EndPlayReason);
+}
+
 void UStatusComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
     Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-    // Replicating each visibility variable for each team
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_0);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_1);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_2);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_3);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_4);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_5);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_6);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_7);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_8);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_9);
-    DOREPLIFETIME(ThisClass, VisibilityForTeam_10);
+    // Push model, only compared when SetVisibleForTeam changed a bit.
+    FDoRepLifetimeParams Params;
+    Params.bIsPushBased = true;
+    DOREPLIFETIME_WITH_PARAMS_FAST(ThisClass, VisibleToTeams, Params);
 }
 
 //------------------------------------------------------------------------------
@@ -93,9 +123,6 @@ void UStatusComponent::ServerStatusCalc(float DeltaTime)
 
 void UStatusComponent::ServerStatusExec(float DeltaTime)
 {
-    // Decrement Visibility
-    VisibilityTick();
-
     // Regenerate
     if(CurrentHealth < MaxHealth)
     {
@@ -141,6 +168,12 @@ void UStatusComponent::ApplyDamage(const float DamageAmount, const float Penetra
         return; // Early exit if no valid damage amount
     }
 
+    // Getting shot is reason enough to wake up, even if we dodge.
+    if(AEDU_CORE_MobileEntity* MobileEntity = Cast<AEDU_CORE_MobileEntity>(GetOwner()))
+    {
+        MobileEntity->ServerWake();
+    }
+
     if(bCanDodge && FMath::FRand() < EvasionRating)
     {
         UE_LOG(LogTemp, Warning, TEXT("Lucky dice!"));
@@ -636,6 +669,8 @@ void UStatusComponent::ChangeTeam(EEDU_CORE_Team NewTeam)
     // Only the server should be allowed to do this.
     if(!HasAuthority()) return;
 
+    const EEDU_CORE_Team OldTeam = ActiveTeam;
+
     GameMode->RemoveActorFromTeamArray(GetOwner(), ActiveTeam);
     ActiveTeam = NewTeam;
     GameMode->AddActorToTeamArray(GetOwner(), ActiveTeam);
@@ -644,6 +679,12 @@ void UStatusComponent::ChangeTeam(EEDU_CORE_Team NewTeam)
     
     ResetVisibilityForTeam(ActiveTeam);
 
+    // Our old team starts forgetting us like any other team.
+    if(OldTeam != ActiveTeam)
+    {
+        ResetVisibilityForTeam(OldTeam);
+    }
+
 }
 
 void UStatusComponent::UpdateHostileTeams()
@@ -665,44 +706,30 @@ void UStatusComponent::UpdateHostileTeams()
     }
 }
 
-void UStatusComponent::SetVisibleForTeam(EEDU_CORE_Team TeamIndex, uint8 Time)
+void UStatusComponent::SetVisibleForTeam(EEDU_CORE_Team TeamIndex, bool bVisible)
 {
-    switch (TeamIndex)
-    {
-        case EEDU_CORE_Team::None:		VisibilityForTeam_0 = Time;     break;
-        case EEDU_CORE_Team::Team_1:	VisibilityForTeam_1 = Time;     break;
-        case EEDU_CORE_Team::Team_2:	VisibilityForTeam_2 = Time;     break;
-        case EEDU_CORE_Team::Team_3:	VisibilityForTeam_3 = Time;     break;
-        case EEDU_CORE_Team::Team_4:	VisibilityForTeam_4 = Time;     break;
-        case EEDU_CORE_Team::Team_5:	VisibilityForTeam_5 = Time;     break;
-        case EEDU_CORE_Team::Team_6:	VisibilityForTeam_6 = Time;     break;
-        case EEDU_CORE_Team::Team_7:	VisibilityForTeam_7 = Time;     break;
-        case EEDU_CORE_Team::Team_8:	VisibilityForTeam_8 = Time;     break;
-        case EEDU_CORE_Team::Team_9:	VisibilityForTeam_9 = Time;     break;
-        case EEDU_CORE_Team::Team_10:	VisibilityForTeam_10 = Time;    break;
-			        
-    default: ;
-    }
+    if(!FTeamVisibility::IsValidTeam(TeamIndex)) return;
+
+    const FTeamVisibility::FTeamMask TeamBit = FTeamVisibility::GetTeamBit(TeamIndex);
+    const FTeamVisibility::FTeamMask NewVisibleToTeams = bVisible ? (VisibleToTeams | TeamBit) : (VisibleToTeams & ~TeamBit);
+    if(NewVisibleToTeams == VisibleToTeams) return;
+
+    VisibleToTeams = NewVisibleToTeams;
+    MARK_PROPERTY_DIRTY_FROM_NAME(ThisClass, VisibleToTeams, this);
+
+    // Sleeping entities are dormant, send this one change without waking them.
+    if(GetOwner()->NetDormancy > DORM_Awake) GetOwner()->FlushNetDormancy();
 }
 
 uint8 UStatusComponent::GetVisibleForTeam(EEDU_CORE_Team TeamIndex) const
 {
-    switch (TeamIndex)
-    {
-        case EEDU_CORE_Team::None:		return VisibilityForTeam_0;     
-        case EEDU_CORE_Team::Team_1:	return VisibilityForTeam_1;     
-        case EEDU_CORE_Team::Team_2:	return VisibilityForTeam_2;    
-        case EEDU_CORE_Team::Team_3:	return VisibilityForTeam_3;
-        case EEDU_CORE_Team::Team_4:	return VisibilityForTeam_4;
-        case EEDU_CORE_Team::Team_5:	return VisibilityForTeam_5;
-        case EEDU_CORE_Team::Team_6:	return VisibilityForTeam_6;
-        case EEDU_CORE_Team::Team_7:	return VisibilityForTeam_7;
-        case EEDU_CORE_Team::Team_8:	return VisibilityForTeam_8; 
-        case EEDU_CORE_Team::Team_9:	return VisibilityForTeam_9;
-        case EEDU_CORE_Team::Team_10:	return VisibilityForTeam_10;
-			        
-    default: return VisibilityForTeam_0;
-    }
+    if(!FTeamVisibility::IsValidTeam(TeamIndex) || !(VisibleToTeams & FTeamVisibility::GetTeamBit(TeamIndex))) return 0;
+
+    // Clients and our own team only have the bit, the server counts down from the last sighting.
+    if(!GameMode || TeamIndex == ActiveTeam) return VisibilityTimer;
+
+    const float Elapsed = GameMode->GetAsyncedClock() - LastSeenByTeam[static_cast<int32>(TeamIndex)];
+    return static_cast<uint8>(FMath::Clamp(VisibilityTimer - FMath::FloorToInt32(Elapsed), 0, static_cast<int32>(VisibilityTimer)));
 }
 
 float UStatusComponent::GetDefenceAgainst(EDamageType DamageType) const
@@ -763,22 +790,65 @@ float UStatusComponent::GetDefenceAgainst(EDamageType DamageType) const
 void UStatusComponent::ResetVisibilityForTeam(EEDU_CORE_Team TeamIndex)
 { // FLOW_LOG
 
-    switch (TeamIndex)
-    {
-        case EEDU_CORE_Team::None:		VisibilityForTeam_0 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_1:	VisibilityForTeam_1 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_2:	VisibilityForTeam_2 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_3:	VisibilityForTeam_3 = VisibilityTimer;  break;
-        case EEDU_CORE_Team::Team_4:	VisibilityForTeam_4 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_5:	VisibilityForTeam_5 = VisibilityTimer;  break;
-        case EEDU_CORE_Team::Team_6:	VisibilityForTeam_6 = VisibilityTimer;  break;
-        case EEDU_CORE_Team::Team_7:	VisibilityForTeam_7 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_8:	VisibilityForTeam_8 = VisibilityTimer; 	break;
-        case EEDU_CORE_Team::Team_9:	VisibilityForTeam_9 = VisibilityTimer;  break;
-        case EEDU_CORE_Team::Team_10:	VisibilityForTeam_10 = VisibilityTimer;	break;
-			        
-    default: ;
+    SetVisibleForTeam(TeamIndex, true);
+
+    if(!GameMode || TeamIndex == ActiveTeam || !FTeamVisibility::IsValidTeam(TeamIndex)) return;
+
+    const float Clock = GameMode->GetAsyncedClock();
+    LastSeenByTeam[static_cast<int32>(TeamIndex)] = Clock;
+    QueueVisibilityExpiry(TeamIndex, Clock + (VisibilityTimer - (VisibilityTimer >> 1)));
+}
+
+void UStatusComponent::QueueVisibilityExpiry(EEDU_CORE_Team TeamIndex, float DueAt)
+{
+    const FTeamVisibility::FTeamMask TeamBit = FTeamVisibility::GetTeamBit(TeamIndex);
+    if(QueuedVisibilityExpiry & TeamBit) return;
+
+    // Already queued teams are pushed back by UpdateVisibilityExpiry, when their entry comes up.
+    QueuedVisibilityExpiry |= TeamBit;
+    GameMode->ScheduleVisibilityExpiry(this, TeamIndex, DueAt);
+}
+
+float UStatusComponent::UpdateVisibilityExpiry(EEDU_CORE_Team TeamIndex, float Clock)
+{ // FLOW_LOG
+    /*---------------------------------------------------------------------
+      Same stages the old per tick countdown had:
+        ForgetAt:   Half the VisibilityTimer without a sighting, the team
+                    moves us from its Visible to its Hidden array.
+        HideAt:     The full VisibilityTimer, the team bit is cleared and
+                    clients of the team hide us.
+    ---------------------------------------------------------------------*/
+    const FTeamVisibility::FTeamMask TeamBit = FTeamVisibility::GetTeamBit(TeamIndex);
+    if(TeamIndex == ActiveTeam)
+    {
+        QueuedVisibilityExpiry &= ~TeamBit;
+        return -1.f;
     }
+
+    const float LastSeen = LastSeenByTeam[static_cast<int32>(TeamIndex)];
+    const float ForgetAt = LastSeen + (VisibilityTimer - (VisibilityTimer >> 1));
+    const float HideAt = LastSeen + VisibilityTimer;
+
+    // Seen again since this entry was queued.
+    if(Clock < ForgetAt) return ForgetAt;
+
+    GameMode->RemoveActorFromTeamVisibleActorsArray(GetOwner(), TeamIndex);
+    if(Clock < HideAt) return HideAt;
+
+    SetVisibleForTeam(TeamIndex, false);
+    QueuedVisibilityExpiry &= ~TeamBit;
+
+    Server_VisibilityForTeamUpdate();
+    return -1.f;
+}
+
+bool UStatusComponent::IsNetRelevantForTeam(EEDU_CORE_Team TeamIndex, float GracePeriod) const
+{ // FLOW_LOG
+    if(TeamIndex == ActiveTeam || !FTeamVisibility::IsValidTeam(TeamIndex)) return true;
+    if(VisibleToTeams & FTeamVisibility::GetTeamBit(TeamIndex)) return true;
+
+    // The cleared bit still has to reach the team's clients, and a quick glance back shouldn't reopen the channel.
+    return GameMode && GameMode->GetAsyncedClock() - LastSeenByTeam[static_cast<int32>(TeamIndex)] < VisibilityTimer + GracePeriod;
 }
 
 //--------------------------------------------------------------------------
@@ -801,82 +871,27 @@ void UStatusComponent::CheckLocalPlayer()
     }
 }
 
-void UStatusComponent::VisibilityTick()
-{    
-    if(!HasAuthority()) return;
-
-    /*------------------------- Dividing by Bitwise shift -----------------------------------
-      In normal arithmetic, dividing a number by 2 gives you half of that number.
-
-      A bitwise right shift (using the >> operator) shifts the bits of a number to the right
-      by a specified number of positions. When you shift a number by 1 position (as in >> 1),
-      it divides the number by 2 (for integers).
-    --------------------------------------------------------------------------------------*/
-
-    // Inlined lambda for removing an actor if visibility is greater than half
-    auto Remove = [&](const uint8& VisibilityForTeam, const EEDU_CORE_Team Team) {
-        if (VisibilityForTeam < (VisibilityTimer >> 1)) // Divide by 2
-        {
-            // UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("VisibilityForTeam %d = %d"), ActiveTeam, VisibilityForTeam);
-            GameMode->RemoveActorFromTeamVisibleActorsArray(GetOwner(), Team);
-        }
-    };
-    
-    if(VisibilityForTeam_0 > 0 && ActiveTeam != EEDU_CORE_Team::None){ --VisibilityForTeam_0; Remove(VisibilityForTeam_0, EEDU_CORE_Team::None); }
-    if(VisibilityForTeam_1 > 0 && ActiveTeam != EEDU_CORE_Team::Team_1){ --VisibilityForTeam_1; Remove(VisibilityForTeam_1, EEDU_CORE_Team::Team_1); }
-    if(VisibilityForTeam_2 > 0 && ActiveTeam != EEDU_CORE_Team::Team_2){ --VisibilityForTeam_2; Remove(VisibilityForTeam_2, EEDU_CORE_Team::Team_2); }
-    if(VisibilityForTeam_3 > 0 && ActiveTeam != EEDU_CORE_Team::Team_3){ --VisibilityForTeam_3; Remove(VisibilityForTeam_3, EEDU_CORE_Team::Team_3); }
-    if(VisibilityForTeam_4 > 0 && ActiveTeam != EEDU_CORE_Team::Team_4){ --VisibilityForTeam_4; Remove(VisibilityForTeam_4, EEDU_CORE_Team::Team_4); }
-    if(VisibilityForTeam_5 > 0 && ActiveTeam != EEDU_CORE_Team::Team_5){ --VisibilityForTeam_5; Remove(VisibilityForTeam_5, EEDU_CORE_Team::Team_5); }
-    if(VisibilityForTeam_6 > 0 && ActiveTeam != EEDU_CORE_Team::Team_6){ --VisibilityForTeam_6; Remove(VisibilityForTeam_6, EEDU_CORE_Team::Team_6); }
-    if(VisibilityForTeam_7 > 0 && ActiveTeam != EEDU_CORE_Team::Team_7){ --VisibilityForTeam_7; Remove(VisibilityForTeam_7, EEDU_CORE_Team::Team_7); }
-    if(VisibilityForTeam_8 > 0 && ActiveTeam != EEDU_CORE_Team::Team_8){ --VisibilityForTeam_8; Remove(VisibilityForTeam_8, EEDU_CORE_Team::Team_8); }
-    if(VisibilityForTeam_9 > 0 && ActiveTeam != EEDU_CORE_Team::Team_9){ --VisibilityForTeam_9; Remove(VisibilityForTeam_9, EEDU_CORE_Team::Team_9); }
-    if(VisibilityForTeam_10 > 0 && ActiveTeam != EEDU_CORE_Team::Team_10){ --VisibilityForTeam_10; Remove(VisibilityForTeam_10, EEDU_CORE_Team::Team_10); }
-
-    Server_VisibilityForTeamUpdate();
-}
-
 void UStatusComponent::Server_VisibilityForTeamUpdate_Implementation() const
 {
     if(GetNetMode() == NM_ListenServer || GetNetMode() == NM_Standalone)
     {
-        switch (LocalCamera->GetTeam())
-        {
-            case EEDU_CORE_Team::None: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_0 == 0); break;
-            case EEDU_CORE_Team::Team_1: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_1 == 0); break;
-            case EEDU_CORE_Team::Team_2: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_2 == 0); break;
-            case EEDU_CORE_Team::Team_3: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_3 == 0); break;
-            case EEDU_CORE_Team::Team_4: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_4 == 0); break;
-            case EEDU_CORE_Team::Team_5: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_5 == 0); break;
-            case EEDU_CORE_Team::Team_6: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_6 == 0); break;
-            case EEDU_CORE_Team::Team_7: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_7 == 0); break;
-            case EEDU_CORE_Team::Team_8: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_8 == 0); break;
-            case EEDU_CORE_Team::Team_9: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_9 == 0); break;
-            case EEDU_CORE_Team::Team_10: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_10 == 0); break;
-        
-        default: ;
-        }
+        ApplyLocalVisibility();
     }
 }
 
-void UStatusComponent::OnRep_VisibilityForTeamUpdate() const
+void UStatusComponent::OnRep_VisibleToTeams() const
 { FLOW_LOG
     
     // <!> Client only
-    switch (LocalCamera->GetTeam())
-    {
-        case EEDU_CORE_Team::None: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_0 == 0); break;
-        case EEDU_CORE_Team::Team_1: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_1 == 0); break;
-        case EEDU_CORE_Team::Team_2: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_2 == 0); break;
-        case EEDU_CORE_Team::Team_3: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_3 == 0); break;
-        case EEDU_CORE_Team::Team_4: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_4 == 0); break;
-        case EEDU_CORE_Team::Team_5: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_5 == 0); break;
-        case EEDU_CORE_Team::Team_6: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_6 == 0); break;
-        case EEDU_CORE_Team::Team_7: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_7 == 0); break;
-        case EEDU_CORE_Team::Team_8: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_8 == 0); break;
-        case EEDU_CORE_Team::Team_9: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_9 == 0); break;
-        case EEDU_CORE_Team::Team_10: GetOwner()->SetActorHiddenInGame(VisibilityForTeam_10 == 0); break;
-    default: ;
-    }
+    ApplyLocalVisibility();
+}
+
+void UStatusComponent::ApplyLocalVisibility() const
+{
+    if(!LocalCamera) return;
+
+    const EEDU_CORE_Team LocalTeam = LocalCamera->GetTeam();
+    if(!FTeamVisibility::IsValidTeam(LocalTeam)) return;
+
+    GetOwner()->SetActorHiddenInGame(!(VisibleToTeams & FTeamVisibility::GetTeamBit(LocalTeam)));
 }
\ No newline at end of file
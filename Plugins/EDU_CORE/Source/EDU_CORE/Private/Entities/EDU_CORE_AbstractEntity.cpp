@@ -32,6 +32,19 @@ void AEDU_CORE_AbstractEntity::BeginPlay()
 	}
 }
 
+void AEDU_CORE_AbstractEntity::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{ FLOW_LOG
+	if(bServerTickEnabled && GetNetMode() != NM_Client)
+	{
+		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GameMode->RemoveFromAbstractEntityArray(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Construction & Object Lifetime Management
 //------------------------------------------------------------------------------
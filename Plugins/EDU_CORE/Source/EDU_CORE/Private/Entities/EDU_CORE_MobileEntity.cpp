@@ -6,8 +6,11 @@
 #include "EDU_CORE/Public/Entities/Waypoints/EDU_CORE_Waypoint.h"
 #include "Framework/Data/FLOWLOGS/FLOWLOG_ENTITIES.h"
 #include "Framework/Managers/GameModes/EDU_CORE_GameMode.h"
+#include "Framework/Managers/GameModes/EDU_CORE_FlowFieldService.h"
+#include "Framework/Managers/GameModes/EDU_CORE_NavPathCache.h"
 #include "Framework/Data/DataTypes/EDU_CORE_DataTypes.h"
 #include "FunctionLibrary/UtilityLibrary.h"
+#include "Entities/Components/TurretWeaponComponent.h"
 
 // Navigation
 #include "NavigationPath.h"
@@ -82,9 +85,17 @@ void AEDU_CORE_MobileEntity::BeginPlay()
 		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
 		{
 			GameMode->AddToMobileEntityArray(this);
+			FlowFields = &GameMode->GetFlowFields();
+			PathCache = &GameMode->GetPathCache();
 		}
 		
 		// CreateCollisionSphere();
+
+		GetComponents(TurretComponents);
+
+		// Impulses and collisions wake the body before they move us.
+		PhysicsComponent->BodyInstance.bGenerateWakeEvents = true;
+		PhysicsComponent->OnComponentWake.AddDynamic(this, &AEDU_CORE_MobileEntity::OnPhysicsWake);
 	}
 
 	// Initiate PhysicsBodyInstance pointer
@@ -105,6 +116,20 @@ void AEDU_CORE_MobileEntity::BeginPlay()
 	
 }
 
+void AEDU_CORE_MobileEntity::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{ FLOW_LOG
+	// Server Tick
+	if(GetNetMode() != NM_Client)
+	{
+		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GameMode->RemoveFromMobileEntityArray(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -125,6 +150,14 @@ void AEDU_CORE_MobileEntity::ServerMobileCalc(float DeltaTime, int32 CurrentBatc
 	const FRotator& CurrentRotation = GetActorRotation();
 	
 	Distance = CalculateDistance(CurrentPos); // Pass position to avoid creating another FVector
+
+	// Steer by the flow field until we're close, the last stretch goes straight to FormationLocation.
+	bHasFlowFieldDirection = FlowFieldOwner
+		&& FlowFields
+		&& MovementOrder == EMovementOrder::MoveTo
+		&& NavPointArray.Num() == 0
+		&& Distance > FlowFieldExitDistance
+		&& FlowFields->GetDirection(FlowFieldOwner, CurrentPos, FlowFieldDirection);
 	
 	CalculateCurrentSpeed(CurrentPos, DeltaTime); // Pass position to avoid redundant calls
 	switch (MovementOrder)
@@ -170,7 +203,7 @@ void AEDU_CORE_MobileEntity::ServerMobileCalc(float DeltaTime, int32 CurrentBatc
 		{
 			if(CurrentSpeedVector.Z < -1000.f && (CurrentPos.Z < 0.f))
 			{
-				AsyncTask(ENamedThreads::GameThread, [this]()
+				TickLaneAsyncTask([this]()
 				{
 					// Ground should never be below 0.
 					SetActorLocation(LastValidLocation, false, nullptr, ETeleportType::ResetPhysics);
@@ -363,6 +396,84 @@ void AEDU_CORE_MobileEntity::ServerMobileExec(float DeltaTime, int32 CurrentBatc
 			break;
 		}
 	}
+
+	//----------------------------------------------------------------------------------------------------
+	// Sleep when we've been idle long enough
+	//----------------------------------------------------------------------------------------------------
+	if(bCanSleep && CanSleep())
+	{
+		IdleTime += DeltaTime;
+		if(IdleTime >= TimeBeforeSleep) ServerSleep();
+	}
+	else
+	{
+		IdleTime = 0.f;
+	}
+}
+
+void AEDU_CORE_MobileEntity::ServerSleepingExec()
+{ // FLOW_LOG
+	if(FVector::DistSquared(GetActorLocation(), SleepLocation) > FMath::Square(WakeDisplacement) || HasArmedTurret())
+	{
+		ServerWake();
+	}
+}
+
+//------------------------------------------------------------------------------
+// Sleep
+//------------------------------------------------------------------------------
+
+bool AEDU_CORE_MobileEntity::CanSleep() const
+{
+	// Climbers hold on with a force every frame.
+	return (MovementOrder == EMovementOrder::Idle || MovementOrder == EMovementOrder::None)
+		&& WaypointArray.Num() == 0
+		&& !bShouldAlign
+		&& !bCanClimb
+		&& ActualSpeed <= SleepSpeedThreshold
+		&& CurrentSpeed <= SleepSpeedThreshold
+		&& !HasArmedTurret();
+}
+
+bool AEDU_CORE_MobileEntity::HasArmedTurret() const
+{
+	for(const UTurretWeaponComponent* TurretComponent : TurretComponents)
+	{
+		if(TurretComponent && TurretComponent->GetTurretStatus() >= EWeaponStatus::Searching) return true;
+	}
+	return false;
+}
+
+void AEDU_CORE_MobileEntity::ServerSleep()
+{ FLOW_LOG
+	bServerSleeping = true;
+	SleepLocation = GetActorLocation();
+
+	if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->RequestSleepStateChange(this);
+	}
+}
+
+void AEDU_CORE_MobileEntity::ServerWake()
+{ // FLOW_LOG
+	IdleTime = 0.f;
+	if(!bServerSleeping) return;
+	
+	bServerSleeping = false;
+
+	// Don't read the time asleep as speed on the first frame back.
+	LastPos = GetActorLocation();
+
+	if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->RequestSleepStateChange(this);
+	}
+}
+
+void AEDU_CORE_MobileEntity::OnPhysicsWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{ // FLOW_LOG
+	ServerWake();
 }
 
 //------------------------------------------------------------------------------
@@ -575,6 +686,8 @@ void AEDU_CORE_MobileEntity::Align()
 
 void AEDU_CORE_MobileEntity::AddWaypoint(const FWaypointParams& Params)
 { FLOW_LOG
+	ServerWake();
+	
 	if(!Params.bQueue && WaypointArray.Num() > 0) // Always clear the array if anything is in it and the waypoint is not queued.
 	{
 		ClearAllWaypoints();
@@ -619,8 +732,25 @@ void AEDU_CORE_MobileEntity::RemoveWaypoint(AEDU_CORE_Waypoint* Waypoint)
 		if(Waypoint == WaypointArray[0]) bRetrieveNewWaypointOrders = true;
 		
 		// Unsubscribe from updates, the waypoint will destroy itself when no one longer listens.
-		Waypoint->RemoveActorFromWaypoint(this);
+		// The last listener returns it to the pool, which is game thread only, so from a lane Calc it waits for the game thread.
+		if(IsInGameThread())
+		{
+			Waypoint->RemoveActorFromWaypoint(this);
+		}
+		else
+		{
+			TickLaneAsyncTask([this, WeakWaypoint = TWeakObjectPtr<AEDU_CORE_Waypoint>(Waypoint)]()
+			{
+				if(WeakWaypoint.IsValid())
+				{
+					WeakWaypoint->RemoveActorFromWaypoint(this);
+				}
+			});
+		}
 		WaypointArray.Remove(Waypoint);
+
+		// Pooled waypoints come back with new fields.
+		if(Waypoint == FlowFieldOwner) FlowFieldOwner = nullptr;
 		FLOW_LOG_WARNING("Removing Waypoint")
 	}
 
@@ -643,6 +773,7 @@ void AEDU_CORE_MobileEntity::ClearAllWaypoints()
 		}
 	}
 	WaypointArray.Reset();
+	FlowFieldOwner = nullptr;
 }
 
 //------------------------------------------------------------------------------
@@ -841,6 +972,8 @@ void AEDU_CORE_MobileEntity::UpdateBatchIndex(const int32 ServerBatchIndex)
 
 void AEDU_CORE_MobileEntity::ExecuteOrders(const FWaypointParams& Params)
 { // FLOW_LOG
+	ServerWake();
+	
 
 	// Default until change
 	MovementOrder = EMovementOrder::MoveTo;
@@ -849,7 +982,7 @@ void AEDU_CORE_MobileEntity::ExecuteOrders(const FWaypointParams& Params)
 	FormationRotation = Params.WaypointRotation;
 	
 	UpdateFormationLocation(Params);
-	RequestPathAsync(GetActorLocation(), FormationLocation);
+	RequestFormationPath();
 	
 }
 
@@ -885,7 +1018,7 @@ bool AEDU_CORE_MobileEntity::OnSurface(const FVector& CurrentPos)
 
 	/*// Always do debug on the main thread.
 	#if WITH_EDITOR
-		AsyncTask(ENamedThreads::GameThread, [this, TraceStartLocation, TraceEndLocation]()
+		TickLaneAsyncTask([this, TraceStartLocation, TraceEndLocation]()
 		{
 			DrawDebugLine(GetWorld(), TraceStartLocation, TraceEndLocation, FColor::Green, false, 0.1f, 0, 1.0f);
 		});
@@ -933,7 +1066,7 @@ void AEDU_CORE_MobileEntity::CheckAlignment(const FRotator& CurrentPos)
 				{
 					FVector NavPointPos = NavPointArray[0]; // Making sure it's threadsafe.
 					// Always do this on the main thread.
-					AsyncTask(ENamedThreads::GameThread, [this, NavPointPos]()
+					TickLaneAsyncTask([this, NavPointPos]()
 					{
 						// Draw a debug square at the location of each path point
 						DrawDebugSphere(
@@ -949,6 +1082,11 @@ void AEDU_CORE_MobileEntity::CheckAlignment(const FRotator& CurrentPos)
 				}
 			#endif
 		}
+		else if(bHasFlowFieldDirection)
+		{
+			// UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("Aligning with FlowFieldDirection."));
+			AlignEndRotation.Yaw = FlowFieldDirection.Rotation().Yaw;
+		}
 		else if(bShouldAim)
 		{
 			// UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("Aligning with NavPointArray[0]."));
@@ -1395,7 +1533,7 @@ bool AEDU_CORE_MobileEntity::IsPathClear(const FVector& TraceStartLocation, cons
 		if(bShowCollisionDebug)
 		{
 			// Always do this on the main thread.
-			AsyncTask(ENamedThreads::GameThread, [this, TraceEndLocation]()
+			TickLaneAsyncTask([this, TraceEndLocation]()
 			{
 				DrawDebugSphere(GetWorld(), TraceEndLocation, CollisionDetectionVolumeRadius, 12, FColor::Red, false, 0.05f); // End position			
 			});
@@ -1414,7 +1552,7 @@ bool AEDU_CORE_MobileEntity::IsPathClear(const FVector& TraceStartLocation, cons
 				if(bShowDynamicCollisionSphere)
 				{
 					// Always do this on the main thread.
-					AsyncTask(ENamedThreads::GameThread, [this, TraceEndLocation]()
+					TickLaneAsyncTask([this, TraceEndLocation]()
 					{
 						DrawDebugSphere(GetWorld(), TraceEndLocation, CollisionDetectionVolumeRadius, 12, FColor::Red, false, 0.05f); // End position			
 					});
@@ -1429,7 +1567,7 @@ bool AEDU_CORE_MobileEntity::IsPathClear(const FVector& TraceStartLocation, cons
 		if(bShowCollisionDebug)
 		{
 			// Always do this on the main thread.
-			AsyncTask(ENamedThreads::GameThread, [this, TraceStartLocation, TraceEndLocation]()
+			TickLaneAsyncTask([this, TraceStartLocation, TraceEndLocation]()
 			{
 				// Visualize the trace start, end, and the path between them
 				DrawDebugLine(GetWorld(), TraceStartLocation, TraceEndLocation, FColor::Blue, false, 0.05f, 0, 0.1f); // Path of the trace
@@ -1457,7 +1595,7 @@ void AEDU_CORE_MobileEntity::RequestPath(const FVector& StartPos, const FVector&
 	if (!IsInGameThread())
 	{
 		// If not, queue the function to run on the main thread
-		AsyncTask(ENamedThreads::GameThread, [this, StartPos, EndPos]()
+		TickLaneAsyncTask([this, StartPos, EndPos]()
 		{
 			RequestPath(StartPos, EndPos);
 			UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("RequestPath restarted on Main thread."));
@@ -1471,8 +1609,18 @@ void AEDU_CORE_MobileEntity::RequestPath(const FVector& StartPos, const FVector&
 		NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
 	}
 
+	if(FindCachedPath(NavSystem->GetMainNavData(), StartPos, EndPos))
+	{
+		return;
+	}
+
 	if(TObjectPtr<UNavigationPath> NavPath = NavSystem->FindPathToLocationSynchronously(GetWorld(), StartPos, EndPos))
 	{
+		if(PathCache && NavPath->GetPath().IsValid())
+		{
+			PathCache->Add(*NavPath->GetPath(), NavAgentProperties);
+		}
+
 		if(NavPath->PathPoints.Num() < 3)
 		{
 			/*---------------------------------------------------------------------
@@ -1521,7 +1669,7 @@ void AEDU_CORE_MobileEntity::RequestPathAsync(const FVector& StartPos, const FVe
 	if (!IsInGameThread())
 	{
 		// If not, queue the function to run on the main thread
-		AsyncTask(ENamedThreads::GameThread, [this, StartPos, EndPos]()
+		TickLaneAsyncTask([this, StartPos, EndPos]()
 		{
 			RequestPathAsync(StartPos, EndPos);
 			UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("RequestPath restarted on Main thread."));
@@ -1542,6 +1690,12 @@ void AEDU_CORE_MobileEntity::RequestPathAsync(const FVector& StartPos, const FVe
 	
 	if(const ANavigationData* NavData = Cast<ANavigationData>(NavSystem->GetMainNavData()))
 	{
+		// Patrols and evasions ask for the same paths over and over.
+		if(FindCachedPath(NavData, StartPos, EndPos))
+		{
+			return;
+		}
+
 		// Initialize the pathfinding query with required parameters
 		FPathFindingQuery PathQuery(
 			this,									// Owner (typically 'this' if within an actor or controller class)
@@ -1569,6 +1723,153 @@ void AEDU_CORE_MobileEntity::RequestPathAsync(const FVector& StartPos, const FVe
 	}
 }
 
+bool AEDU_CORE_MobileEntity::FindCachedPath(const ANavigationData* NavData, const FVector& StartPos, const FVector& EndPos)
+{ FLOW_LOG
+	FNavPathCacheKey PathCacheKey;
+	if(!PathCache || !PathCache->MakeKey(NavData, StartPos, EndPos, NavAgentProperties, PathCacheKey)) return false;
+
+	const TArray<FVector>* PathPoints = PathCache->Find(PathCacheKey);
+	if(!PathPoints) return false;
+
+	// Same as a fresh path, only the NavPoints in the middle.
+	if(PathPoints->Num() > 2)
+	{
+		NavPointArray.Reset();
+		for (int32 Point = 1; Point < PathPoints->Num() - 1; ++Point)
+		{
+			NavPointArray.Add((*PathPoints)[Point]);
+		}
+	}
+	return true;
+}
+
+void AEDU_CORE_MobileEntity::RequestFormationPath()
+{ FLOW_LOG
+	// The waypoint's group path is only touched on the main thread.
+	if (!IsInGameThread())
+	{
+		TickLaneAsyncTask([this]()
+		{
+			RequestFormationPath();
+		});
+		return;
+	}
+
+	AEDU_CORE_Waypoint* Waypoint = WaypointArray.Num() > 0 ? WaypointArray[0].Get() : nullptr;
+
+	// No path at all, Calc reads our direction from the waypoint's field.
+	FlowFieldOwner = nullptr;
+	if(Waypoint && Waypoint->UsesFlowField())
+	{
+		NavPointArray.Reset();
+		FlowFieldOwner = Waypoint;
+		return;
+	}
+
+	if(!Waypoint || !Waypoint->JoinGroupPath(this))
+	{
+		RequestPathAsync(GetActorLocation(), FormationLocation);
+	}
+}
+
+void AEDU_CORE_MobileEntity::FollowGroupPath(const AEDU_CORE_Waypoint* Waypoint, const TArray<FVector>& Corridor)
+{ FLOW_LOG
+	// We got other orders while the group path was being found.
+	if(WaypointArray.Num() == 0 || WaypointArray[0] != Waypoint) return;
+
+	if(Corridor.Num() < 2)
+	{
+		RequestPathAsync(GetActorLocation(), FormationLocation);
+		return;
+	}
+
+	if(!NavSystem)
+	{
+		NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	}
+
+	/*---------------------------------------------------------------------
+	  Keep our place in the group along the corridor: start at our offset
+	  from the centroid, and blend into our offset in the formation by how
+	  far along the corridor the point is.
+
+	  Like OnRequestPathAsyncComplete, we only need the NavPoints in the
+	  middle, the last one is our FormationLocation.
+
+	  An offset point is only used if we can walk straight to it from the
+	  previous one, projecting can snap it across a wall or onto a ledge.
+	---------------------------------------------------------------------*/
+	const ANavigationData* NavData = NavSystem ? NavSystem->GetNavDataForProps(NavAgentProperties) : nullptr;
+	if(!NavData && NavSystem) NavData = NavSystem->GetMainNavData();
+	const FSharedConstNavQueryFilter QueryFilter = NavData ? NavData->GetDefaultQueryFilter() : nullptr;
+
+	auto CanWalkStraight = [NavData, &QueryFilter](const FVector& From, const FVector& To)
+	{
+		FVector HitLocation;
+		return !NavData || !NavData->Raycast(From, To, HitLocation, QueryFilter);
+	};
+
+	const FVector StartOffset = (GetActorLocation() - Corridor[0]) * FVector(1.f, 1.f, 0.f);
+	const FVector EndOffset = (FormationLocation - Corridor.Last()) * FVector(1.f, 1.f, 0.f);
+
+	float CorridorLength = 0.f;
+	for (int32 Point = 1; Point < Corridor.Num(); ++Point)
+	{
+		CorridorLength += FVector::Dist(Corridor[Point - 1], Corridor[Point]);
+	}
+
+	NavPointArray.Reset();
+	FVector PreviousPoint = Corridor[0];
+	float Travelled = 0.f;
+	for (int32 Point = 1; Point < Corridor.Num() - 1; ++Point)
+	{
+		Travelled += FVector::Dist(Corridor[Point - 1], Corridor[Point]);
+		const float Alpha = CorridorLength > UE_KINDA_SMALL_NUMBER ? Travelled / CorridorLength : 1.f;
+
+		// Offsets can push a point off the navmesh or behind a wall at chokepoints, use the corridor itself there.
+		FVector NavPoint = Corridor[Point];
+		FNavLocation OffsetLocation;
+		if(NavSystem && NavSystem->ProjectPointToNavigation(Corridor[Point] + FMath::Lerp(StartOffset, EndOffset, Alpha), OffsetLocation)
+			&& CanWalkStraight(NavPointArray.Num() > 0 ? PreviousPoint : GetActorLocation(), OffsetLocation.Location))
+		{
+			NavPoint = OffsetLocation.Location;
+		}
+
+		NavPointArray.Add(NavPoint);
+		PreviousPoint = NavPoint;
+	}
+
+	/*---------------------------------------------------------------------
+	  We joined by distance alone, the corridor may start on the other
+	  side of a wall or a cliff from us. Path to its first point on our
+	  own, it's within GroupPathJoinRadius, so the query is short.
+	---------------------------------------------------------------------*/
+	if(NavPointArray.Num() == 0)
+	{
+		if(!CanWalkStraight(GetActorLocation(), FormationLocation))
+		{
+			RequestPathAsync(GetActorLocation(), FormationLocation);
+		}
+		return;
+	}
+
+	if(!CanWalkStraight(GetActorLocation(), NavPointArray[0]))
+	{
+		const UNavigationPath* ApproachPath = NavSystem->FindPathToLocationSynchronously(GetWorld(), GetActorLocation(), NavPointArray[0]);
+		if(!ApproachPath || !ApproachPath->IsValid() || ApproachPath->IsPartial())
+		{
+			RequestPathAsync(GetActorLocation(), FormationLocation);
+			return;
+		}
+
+		// Only the middle, the last one is already our first NavPoint.
+		for (int32 Point = ApproachPath->PathPoints.Num() - 2; Point > 0; --Point)
+		{
+			NavPointArray.Insert(ApproachPath->PathPoints[Point], 0);
+		}
+	}
+}
+
 void AEDU_CORE_MobileEntity::OnRequestPathAsyncComplete(uint32 RequestID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
 { FLOW_LOG
 	if (Result == ENavigationQueryResult::Success && Path.IsValid())
@@ -1578,6 +1879,11 @@ void AEDU_CORE_MobileEntity::OnRequestPathAsyncComplete(uint32 RequestID, ENavig
 		// Retrieve the path points
 		const TArray<FNavPathPoint>& PathPoints = Path->GetPathPoints();
 
+		if(PathCache)
+		{
+			PathCache->Add(*Path, NavAgentProperties);
+		}
+
 		if(PathPoints.Num() > 2)
 		{
 			/*---------------------------------------------------------------------
@@ -6,11 +6,14 @@
 #include "Framework/Data/FLOWLOGS/FLOWLOG_ENTITIES.h"
 #include "Framework/Managers/GameModes/EDU_CORE_GameMode.h"
 #include "Framework/Player/EDU_CORE_PlayerController.h"
+#include "Framework/Pawns/EDU_CORE_C2_Camera.h"
+#include "Entities/Components/StatusComponent.h"
 
 // UE
 #include "Components/PrimitiveComponent.h"
 #include "Components/ShapeComponent.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 //------------------------------------------------------------------------------
 // Construction & Init
@@ -43,12 +46,30 @@ void AEDU_CORE_PhysicsEntity::GetLifetimeReplicatedProps(TArray<FLifetimePropert
 
 	if(!bEnableClientIndependentPhysics)
 	{
-		DOREPLIFETIME(AEDU_CORE_PhysicsEntity, Rep_Location);
-		DOREPLIFETIME(AEDU_CORE_PhysicsEntity, Rep_Rotation);
-		DOREPLIFETIME(AEDU_CORE_PhysicsEntity, Rep_Scale);
+		FDoRepLifetimeParams Params;
+		Params.bIsPushBased = true;
+		DOREPLIFETIME_WITH_PARAMS_FAST(AEDU_CORE_PhysicsEntity, Rep_Movement, Params);
 	}
 }
 
+bool AEDU_CORE_PhysicsEntity::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
+{ // FLOW_LOG
+	if(!bTeamNetRelevancy || bAlwaysRelevant || !StatusComponent) return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+
+	// The viewer is the C2 camera, or the PlayerController possessing it.
+	const AEDU_CORE_C2_Camera* Camera = Cast<AEDU_CORE_C2_Camera>(ViewTarget);
+	if(!Camera)
+	{
+		const APlayerController* PlayerController = Cast<APlayerController>(RealViewer);
+		Camera = PlayerController ? Cast<AEDU_CORE_C2_Camera>(PlayerController->GetPawn()) : nullptr;
+	}
+
+	// Spectators, and viewers we don't know the team of, fall back to the default relevancy.
+	if(Camera && !StatusComponent->IsNetRelevantForTeam(Camera->GetTeam(), NetRelevancyGracePeriod)) return false;
+
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
 // Called when the game starts or when spawned
 void AEDU_CORE_PhysicsEntity::BeginPlay()
 {
@@ -100,13 +121,26 @@ void AEDU_CORE_PhysicsEntity::BeginPlay()
 	{
 		PhysicsComponent->SetSimulatePhysics(true);
 
-		// We need to at least send updates 20 times a second.
-		if(GetNetUpdateFrequency() < 20) SetNetUpdateFrequency(20);
+		// We need to at least send updates 10 times a second, clients interpolate between them.
+		if(GetNetUpdateFrequency() < 10) SetNetUpdateFrequency(10);
+
+		// The initial bunch shouldn't place us at the origin.
+		Rep_Movement.Location = GetActorLocation();
+		Rep_Movement.Rotation = GetActorQuat();
+		Rep_Movement.Scale = GetActorScale3D();
+		Rep_Movement.ServerTime = GetWorld()->GetTimeSeconds();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEDU_CORE_PhysicsEntity, Rep_Movement, this);
 		
 		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
 		{
 			GameMode->AddToPhysicsEntityArray(this);
 		}
+
+		if(bBlocksLineOfSight)
+		{
+			LastLineOfSightLocation = GetActorLocation();
+			InvalidateLineOfSight(LastLineOfSightLocation);
+		}
 	}
 	
 	//------------------------------------------------------------------------------
@@ -116,9 +150,14 @@ void AEDU_CORE_PhysicsEntity::BeginPlay()
 	{
 		PhysicsComponent->SetSimulatePhysics(false);
 	
-		Rep_Location = GetActorLocation();
-		Rep_Rotation = GetActorRotation();
-		Rep_Scale = GetActorScale();
+		// Hold the spawn transform until the server sends more.
+		if(Snapshots.IsEmpty())
+		{
+			Rep_Movement.Location = GetActorLocation();
+			Rep_Movement.Rotation = GetActorQuat();
+			Rep_Movement.Scale = GetActorScale3D();
+			Snapshots.Add(Rep_Movement);
+		}
 
 		if (AEDU_CORE_PlayerController* LocalController = Cast<AEDU_CORE_PlayerController>(GetWorld()->GetFirstPlayerController()))
 		{
@@ -127,6 +166,32 @@ void AEDU_CORE_PhysicsEntity::BeginPlay()
 	}
 }
 
+void AEDU_CORE_PhysicsEntity::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{ FLOW_LOG
+	if(!bEnableClientIndependentPhysics && GetNetMode() != NM_Client)
+	{
+		if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GameMode->RemoveFromPhysicsEntityArray(this);
+		}
+
+		if(bBlocksLineOfSight)
+		{
+			InvalidateLineOfSight(LastLineOfSightLocation);
+		}
+	}
+	else if(!bEnableClientIndependentPhysics && GetNetMode() == NM_Client)
+	{
+		// Entities that stop being relevant are destroyed on the client, don't leave them in the aggregated tick.
+		if (AEDU_CORE_PlayerController* LocalController = Cast<AEDU_CORE_PlayerController>(GetWorld()->GetFirstPlayerController()))
+		{
+			LocalController->RemoveFromPhysicsEntityArray(this);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Network Functionality: Server
 //------------------------------------------------------------------------------	
@@ -141,98 +206,139 @@ void AEDU_CORE_PhysicsEntity::ServerPhysicsCalc(float DeltaTime)
 void AEDU_CORE_PhysicsEntity::ServerPhysicsExec(float DeltaTime)
 { // FlowLog_AI_TICK
 	
-	// Updating Rep_ variables on the server will trigger updates on the client.
-	Rep_Location = GetActorLocation();
-	Rep_Rotation = GetActorRotation();
-	Rep_Scale = GetActorScale();
-}
+	const FVector Location = GetActorLocation();
+	const FQuat Rotation = GetActorQuat();
+	const FVector Scale = GetActorScale3D();
+
+	// Updating Rep_Movement on the server will trigger updates on the client, jitter below the thresholds doesn't.
+	if(FVector::DistSquared(Location, Rep_Movement.Location) > FMath::Square(ReplicatedLocationThreshold)
+		|| Rotation.AngularDistance(Rep_Movement.Rotation) > FMath::DegreesToRadians(ReplicatedRotationThreshold)
+		|| !Scale.Equals(Rep_Movement.Scale, ReplicatedScaleThreshold))
+	{
+		Rep_Movement.Location = Location;
+		Rep_Movement.Rotation = Rotation;
+		Rep_Movement.Scale = Scale;
+		Rep_Movement.ServerTime = GetWorld()->GetTimeSeconds();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEDU_CORE_PhysicsEntity, Rep_Movement, this);
+		bRepMovementAtRest = false;
+	}
+	else if(!bRepMovementAtRest && GetWorld()->GetTimeSeconds() - Rep_Movement.ServerTime > 1.f / GetNetUpdateFrequency())
+	{
+		// We stopped, restamp the last transform so clients don't extrapolate past it.
+		Rep_Movement.ServerTime = GetWorld()->GetTimeSeconds();
+		MARK_PROPERTY_DIRTY_FROM_NAME(AEDU_CORE_PhysicsEntity, Rep_Movement, this);
+		bRepMovementAtRest = true;
+	}
 
-void AEDU_CORE_PhysicsEntity::OnRep_ReplicatedLocation()
-{ // FLOW_LOG 
-	// Handle transform update on clients
-	StartLocation = GetActorLocation();
-	BlendDuration_Location = ElapsedTime_Location;
-	ElapsedTime_Location = 0.f;
-	
-	//UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s::%hs - BlendDuration: %f"), *GetClass()->GetName(), __FUNCTION__, BlendDuration);
+	// Drop cached LOS answers where we were, and where we are now.
+	if(bBlocksLineOfSight && FVector::DistSquared(Location, LastLineOfSightLocation) > FMath::Square(LineOfSightInvalidationDistance))
+	{
+		InvalidateLineOfSight(LastLineOfSightLocation);
+		InvalidateLineOfSight(Location);
+		LastLineOfSightLocation = Location;
+	}
 }
 
-void AEDU_CORE_PhysicsEntity::OnRep_ReplicatedRotation()
-{ // FLOW_LOG
-	StartRotation = GetActorRotation();
-	StartQuat = FQuat(GetActorRotation());
-	TargetQuat = FQuat(Rep_Rotation);
-	
-	BlendDuration_Rotation = ElapsedTime_Rotation;
-	ElapsedTime_Rotation = 0.f;
+void AEDU_CORE_PhysicsEntity::InvalidateLineOfSight(const FVector& Location) const
+{
+	if (AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+	{
+		GameMode->InvalidateLineOfSight(Location, GetSimpleCollisionRadius());
+	}
 }
 
-void AEDU_CORE_PhysicsEntity::OnRep_ReplicatedScale()
-{ // FLOW_LOG
-	StartScale = GetActorScale();
-	BlendDuration_Scale = ElapsedTime_Scale;
-	ElapsedTime_Scale = 0.f;
+void AEDU_CORE_PhysicsEntity::OnRep_ReplicatedMovement()
+{ // FLOW_LOG 
+	// Late or repeated updates would run the buffer backwards.
+	if(!Snapshots.IsEmpty() && Rep_Movement.ServerTime <= Snapshots.Last().ServerTime) return;
+
+	if(Snapshots.Num() == SnapshotCapacity)
+	{
+		Snapshots.RemoveAt(0, 1, EAllowShrinking::No);
+	}
+	Snapshots.Add(Rep_Movement);
 }
 
 //------------------------------------------------------------------------------
 // Network Functionality: Client
 //------------------------------------------------------------------------------
 
-void AEDU_CORE_PhysicsEntity::ClientLerpLocation(float DeltaTime)
+bool AEDU_CORE_PhysicsEntity::FindSnapshots(const double ServerTime, int32& OutFrom, int32& OutTo, float& OutAlpha) const
 { // FLOW_LOG
-	if(!bLerpLocation) return;
-
-	ElapsedTime_Location += DeltaTime;
-	float Alpha = FMath::Clamp(ElapsedTime_Location / BlendDuration_Location, 0.0f, 1.0f);
-			
-	// Interpolate towards the replicated transform
-	FVector CurrentLocation = FMath::Lerp(StartLocation, Rep_Location, Alpha);
-	SetActorLocation(CurrentLocation);
-
-	/*
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"X %f, Y %f, Z %f "), CurrentLocation.X, CurrentLocation.Z, CurrentLocation.Y));
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"Alpha_Location %f "), Alpha));
-	*/
+	const int32 Num = Snapshots.Num();
+	if(Num == 0) return false;
+
+	const double RenderTime = ServerTime - InterpolationDelay;
+	OutAlpha = 0.f;
+
+	// Not enough history yet, hold the oldest.
+	if(Num == 1 || RenderTime <= Snapshots[0].ServerTime)
+	{
+		OutFrom = OutTo = 0;
+		return true;
+	}
+
+	// Past the newest, keep going along the velocity of the newest two, but not forever.
+	const FQuantizedMovement& Newest = Snapshots[Num - 1];
+	if(RenderTime >= Newest.ServerTime)
+	{
+		const FQuantizedMovement& Previous = Snapshots[Num - 2];
+		const double Extrapolation = FMath::Min(RenderTime - Newest.ServerTime, static_cast<double>(MaxExtrapolationTime));
+
+		OutFrom = Num - 2;
+		OutTo = Num - 1;
+		OutAlpha = 1.f + static_cast<float>(Extrapolation / (Newest.ServerTime - Previous.ServerTime));
+		return true;
+	}
+
+	// The buffer is tiny, walk back from the newest.
+	int32 From = Num - 2;
+	while(From > 0 && Snapshots[From].ServerTime > RenderTime) --From;
+
+	OutFrom = From;
+	OutTo = From + 1;
+	OutAlpha = static_cast<float>((RenderTime - Snapshots[From].ServerTime) / (Snapshots[From + 1].ServerTime - Snapshots[From].ServerTime));
+	return true;
 }
 
-void AEDU_CORE_PhysicsEntity::ClientLerpRotation(float DeltaTime)
+void AEDU_CORE_PhysicsEntity::ClientPhysicsCalc(const double ServerTime, FClientPhysicsTransform& OutTransform) const
 { // FLOW_LOG
-	if(!bLerpRotation) return;
+	OutTransform.bMoved = false;
+	OutTransform.bScaled = false;
+
+	// Hidden entities snap to the buffer when they are shown again.
+	if(IsHidden()) return;
+
+	int32 From, To; float Alpha;
+	if(!FindSnapshots(ServerTime, From, To, Alpha)) return;
+
+	const FVector CurrentLocation = GetActorLocation();
+	const FQuat CurrentRotation = GetActorQuat();
+
+	OutTransform.Location = bLerpLocation ? FMath::Lerp(Snapshots[From].Location, Snapshots[To].Location, static_cast<double>(Alpha)) : CurrentLocation;
+
+	// Slerp keeps turning along the same arc when Alpha is past 1.
+	OutTransform.Rotation = bLerpRotation ? FQuat::Slerp(Snapshots[From].Rotation, Snapshots[To].Rotation, Alpha) : CurrentRotation;
 	
-	ElapsedTime_Rotation += DeltaTime;
-	float Alpha = FMath::Clamp(ElapsedTime_Rotation / BlendDuration_Rotation, 0.0f, 1.0f);
-
-	// Interpolate towards the replicated transform
-	//FRotator LerpedRotation = FMath::Lerp(CurrentRotation, Rep_Rotation, Alpha_Rotation);
-	FQuat LerpedQuat = FQuat::Slerp(StartQuat, TargetQuat, Alpha);
-	FRotator CurrentRotation = LerpedQuat.Rotator();
-	SetActorRotation(CurrentRotation);
-
-	/*
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"Pitch: %f, Yaw %f, Roll %f "), CurrentRotation.Pitch, CurrentRotation.Yaw, CurrentRotation.Roll));
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"Alpha_Rotation %f "), Alpha));
-	*/
+	OutTransform.bMoved = !OutTransform.Location.Equals(CurrentLocation, UE_KINDA_SMALL_NUMBER) || !OutTransform.Rotation.Equals(CurrentRotation, UE_KINDA_SMALL_NUMBER);
+
+	if(bLerpScale)
+	{
+		// Scale isn't extrapolated.
+		OutTransform.Scale = FMath::Lerp(Snapshots[From].Scale, Snapshots[To].Scale, static_cast<double>(FMath::Min(Alpha, 1.f)));
+		OutTransform.bScaled = !OutTransform.Scale.Equals(GetActorScale3D(), UE_KINDA_SMALL_NUMBER);
+	}
 }
 
-void AEDU_CORE_PhysicsEntity::ClientLerpScale(float DeltaTime)
+void AEDU_CORE_PhysicsEntity::ClientPhysicsExec(const FClientPhysicsTransform& Transform)
 { // FLOW_LOG
-	if(!bLerpScale) return;
-	
-	ElapsedTime_Scale += DeltaTime;
-	float Alpha = FMath::Clamp(ElapsedTime_Scale / BlendDuration_Scale, 0.0f, 1.0f);
-			
-	// Interpolate towards the replicated transform
-	FVector CurrentScale = FMath::Lerp(CurrentScale, Rep_Scale, Alpha);
-	SetActorScale3D(CurrentScale);
-
-	/*
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"Width %f, Height %f, Depth %f "), CurrentScale.X, CurrentScale.Z, CurrentScale.Y));
-	GEngine->AddOnScreenDebugMessage(-1, GetWorld()->DeltaTimeSeconds, FColor::Cyan, FString::Printf(TEXT(
-	"Alpha_Scale %f "), Alpha));
-	*/
+	if(Transform.bMoved)
+	{
+		SetActorLocationAndRotation(Transform.Location, Transform.Rotation);
+	}
+
+	if(Transform.bScaled)
+	{
+		SetActorScale3D(Transform.Scale);
+	}
 }
@@ -0,0 +1,104 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Entities/EDU_CORE_QuantizedMovement.h"
+
+// UE
+#include "Engine/NetSerialization.h"
+
+namespace EDU_CORE_QuantizedMovement
+{
+	// The three smallest components of a unit quaternion are within +-1/sqrt(2).
+	constexpr float ComponentRange = UE_INV_SQRT_2;
+	constexpr uint32 ComponentMax = (1u << FQuantizedMovement::RotationBits) - 1;
+
+	uint32 QuantizeComponent(const float Value)
+	{
+		const float Normalized = (FMath::Clamp(Value, -ComponentRange, ComponentRange) + ComponentRange) / (2.f * ComponentRange);
+		return static_cast<uint32>(FMath::RoundToInt32(Normalized * ComponentMax));
+	}
+
+	float DequantizeComponent(const uint32 Value)
+	{
+		return static_cast<float>(Value) / ComponentMax * (2.f * ComponentRange) - ComponentRange;
+	}
+
+	uint32 PackRotation(FQuat Rotation)
+	{
+		Rotation.Normalize();
+		float Components[4] = { Rotation.X, Rotation.Y, Rotation.Z, Rotation.W };
+
+		int32 LargestIndex = 0;
+		for(int32 Index = 1; Index < 4; ++Index)
+		{
+			if(FMath::Abs(Components[Index]) > FMath::Abs(Components[LargestIndex]))
+			{
+				LargestIndex = Index;
+			}
+		}
+
+		// q and -q are the same rotation, flip so the dropped component is positive.
+		const float Sign = Components[LargestIndex] < 0.f ? -1.f : 1.f;
+
+		uint32 Packed = static_cast<uint32>(LargestIndex);
+		for(int32 Index = 0; Index < 4; ++Index)
+		{
+			if(Index == LargestIndex) continue;
+			Packed = (Packed << FQuantizedMovement::RotationBits) | QuantizeComponent(Components[Index] * Sign);
+		}
+		return Packed;
+	}
+
+	FQuat UnpackRotation(uint32 Packed)
+	{
+		float Components[4];
+		float SumSquared = 0.f;
+
+		// Components were packed in order, so they come out in reverse.
+		const int32 LargestIndex = static_cast<int32>(Packed >> (3 * FQuantizedMovement::RotationBits));
+		for(int32 Index = 3; Index >= 0; --Index)
+		{
+			if(Index == LargestIndex) continue;
+
+			Components[Index] = DequantizeComponent(Packed & ComponentMax);
+			SumSquared += FMath::Square(Components[Index]);
+			Packed >>= FQuantizedMovement::RotationBits;
+		}
+		Components[LargestIndex] = FMath::Sqrt(FMath::Max(1.f - SumSquared, 0.f));
+
+		FQuat Rotation(Components[0], Components[1], Components[2], Components[3]);
+		Rotation.Normalize();
+		return Rotation;
+	}
+}
+
+bool FQuantizedMovement::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bOutSuccess = true;
+
+	// Centimeters, up to 2^24 cm from the origin.
+	bOutSuccess &= SerializePackedVector<1, 24>(Location, Ar);
+
+	uint32 PackedRotation = Ar.IsSaving() ? EDU_CORE_QuantizedMovement::PackRotation(Rotation) : 0;
+	static_assert(2 + 3 * RotationBits <= 32, "Smallest three doesn't fit in 32 bits.");
+	Ar << PackedRotation;
+	if(Ar.IsLoading())
+	{
+		Rotation = EDU_CORE_QuantizedMovement::UnpackRotation(PackedRotation);
+	}
+
+	uint8 bHasScale = Ar.IsSaving() ? !Scale.Equals(FVector::OneVector, UE_KINDA_SMALL_NUMBER) : 0;
+	Ar.SerializeBits(&bHasScale, 1);
+	if(bHasScale)
+	{
+		// Hundredths.
+		bOutSuccess &= SerializePackedVector<100, 30>(Scale, Ar);
+	}
+	else if(Ar.IsLoading())
+	{
+		Scale = FVector::OneVector;
+	}
+
+	Ar << ServerTime;
+	return true;
+}
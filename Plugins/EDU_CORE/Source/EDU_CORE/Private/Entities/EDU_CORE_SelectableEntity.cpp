@@ -72,6 +72,20 @@ void AEDU_CORE_SelectableEntity::BeginPlay()
 	}
 }
 
+void AEDU_CORE_SelectableEntity::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{ FLOW_LOG
+	// Release the Unique ID, so the map doesn't keep dead entries around.
+	if(HasAuthority() && ServerEntityID.IsValid())
+	{
+		if(AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GameMode->RemoveFromGuidActorMap(ServerEntityID);
+		}
+	}
+	
+	Super::EndPlay(EndPlayReason);
+}
+
 //------------------------------------------------------------------------------
 // Networking
 //------------------------------------------------------------------------------
@@ -5,8 +5,10 @@
 #include "Interfaces/EDU_CORE_CommandInterface.h"
 #include "Framework/Data/FLOWLOGS/FLOWLOG_AI.h"
 #include "Framework/Managers/GameModes/EDU_CORE_GameMode.h"
+#include "Entities/EDU_CORE_MobileEntity.h"
 
 #include "Net/UnrealNetwork.h"
+#include "NavigationSystem.h"
 
 //------------------------------------------------------------------------------
 // Construction & Init
@@ -56,6 +58,9 @@ void AEDU_CORE_Waypoint::AddActorToWaypoint(const TObjectPtr<AEDU_CORE_Selectabl
 
 void AEDU_CORE_Waypoint::RemoveActorFromWaypoint(const TObjectPtr<AEDU_CORE_SelectableEntity>& Entity)
 { FLOW_LOG
+	// Listeners and the pool are shared by every entity, lanes hop here with TickLaneAsyncTask.
+	check(IsInGameThread());
+
 	if(ListenerArray.Contains(Entity))
 	{
 		ListenerArray.RemoveSingle(Entity);
@@ -102,6 +107,10 @@ int32 AEDU_CORE_Waypoint::GetFormationIndex(const TObjectPtr<AEDU_CORE_Selectabl
 
 void AEDU_CORE_Waypoint::NotifyListeners()
 { FLOW_LOG
+	// Before anyone executes orders, so they can join them.
+	RequestFlowField();
+	RequestGroupPath();
+	
 	for (int32 Index = 0; Index < ListenerArray.Num(); ++Index)
 	{
 		if(AActor* Actor = ListenerArray[Index])
@@ -133,10 +142,162 @@ void AEDU_CORE_Waypoint::ResetWaypoint()
 	// Reset Params with default constructor
 	FWaypointParams NewParams;
 	Params = NewParams;
+
+	// Drops the answer of a running query too.
+	GroupPath.Reset();
+	GroupPathMembers.Reset();
+	GroupPathRequestID = INVALID_NAVQUERYID;
+
+	if(bUsesFlowField)
+	{
+		if(AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode()))
+		{
+			GameMode->GetFlowFields().ReleaseField(this);
+		}
+		bUsesFlowField = false;
+	}
 	
 	bAlwaysRelevant = false;
 }
 
+//------------------------------------------------------------------------------
+// Group Path
+//------------------------------------------------------------------------------
+
+void AEDU_CORE_Waypoint::RequestGroupPath()
+{ FLOW_LOG
+	GroupPath.Reset();
+	GroupPathMembers.Reset();
+	GroupPathRequestID = INVALID_NAVQUERYID;
+
+	if(bUsesFlowField || ListenerArray.Num() < GroupPathMinListeners) return;
+
+	UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(GetWorld());
+	if(!NavSystem) return;
+
+	FVector Centroid = FVector::ZeroVector;
+	int32 NumListeners = 0;
+	const AEDU_CORE_MobileEntity* FirstMobileEntity = nullptr;
+	for(const TObjectPtr<AEDU_CORE_SelectableEntity>& Listener : ListenerArray)
+	{
+		if(Listener)
+		{
+			Centroid += Listener->GetActorLocation();
+			++NumListeners;
+
+			if(!FirstMobileEntity)
+			{
+				FirstMobileEntity = Cast<AEDU_CORE_MobileEntity>(Listener);
+			}
+		}
+	}
+	if(NumListeners < GroupPathMinListeners || !FirstMobileEntity) return;
+	Centroid /= NumListeners;
+
+	// Planned for the agent of a member, a default agent could lead large vehicles through gaps they don't fit.
+	GroupPathAgent = FirstMobileEntity->GetNavAgentProperties();
+	const ANavigationData* NavData = NavSystem->GetNavDataForProps(GroupPathAgent);
+	if(!NavData) NavData = NavSystem->GetMainNavData();
+	if(!NavData) return;
+
+	// A spread out group can have its centroid in a building or a river.
+	FNavLocation Start;
+	if(!NavSystem->ProjectPointToNavigation(Centroid, Start, INVALID_NAVEXTENT, NavData))
+	{
+		UE_LOG(FLOWLOG_CATEGORY, Log, TEXT("%s::%hs - Centroid isn't on the navmesh, listeners path on their own."), *GetClass()->GetName(), __FUNCTION__);
+		return;
+	}
+	GroupPathStart = Start.Location;
+
+	FPathFindingQuery PathQuery(
+		this,
+		*NavData,
+		GroupPathStart,
+		GetActorLocation(),
+		nullptr,
+		nullptr,
+		TNumericLimits<FVector::FReal>::Max(),
+		true
+	);
+
+	GroupPathRequestID = NavSystem->FindPathAsync(
+		GroupPathAgent,
+		PathQuery,
+		FNavPathQueryDelegate::CreateUObject(this, &ThisClass::OnGroupPathComplete));
+}
+
+void AEDU_CORE_Waypoint::OnGroupPathComplete(uint32 RequestID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path)
+{ FLOW_LOG
+	// Moved or reset since.
+	if(RequestID != GroupPathRequestID) return;
+	GroupPathRequestID = INVALID_NAVQUERYID;
+
+	if(Result == ENavigationQueryResult::Success && Path.IsValid())
+	{
+		for(const FNavPathPoint& PathPoint : Path->GetPathPoints())
+		{
+			GroupPath.Add(PathPoint.Location);
+		}
+	}
+	else
+	{
+		UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("%s::%hs - No group path, %d listeners path on their own."), *GetClass()->GetName(), __FUNCTION__, GroupPathMembers.Num());
+	}
+
+	// Members that got other orders meanwhile ignore it.
+	TArray<TWeakObjectPtr<AEDU_CORE_MobileEntity>> Members = MoveTemp(GroupPathMembers);
+	for(const TWeakObjectPtr<AEDU_CORE_MobileEntity>& Member : Members)
+	{
+		if(AEDU_CORE_MobileEntity* MobileEntity = Member.Get())
+		{
+			MobileEntity->FollowGroupPath(this, GroupPath);
+		}
+	}
+}
+
+bool AEDU_CORE_Waypoint::JoinGroupPath(AEDU_CORE_MobileEntity* Member)
+{ FLOW_LOG
+	const bool bPending = GroupPathRequestID != INVALID_NAVQUERYID;
+	if(!Member || (!bPending && GroupPath.Num() < 2)) return false;
+
+	if(FVector::Dist2D(Member->GetActorLocation(), GroupPathStart) > GroupPathJoinRadius) return false;
+
+	// The corridor might not fit a different agent.
+	if(!Member->GetNavAgentProperties().IsEquivalent(GroupPathAgent)) return false;
+
+	if(bPending)
+	{
+		GroupPathMembers.AddUnique(Member);
+	}
+	else
+	{
+		Member->FollowGroupPath(this, GroupPath);
+	}
+	return true;
+}
+
+void AEDU_CORE_Waypoint::RequestFlowField()
+{ FLOW_LOG
+	AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(GetWorld()->GetAuthGameMode());
+	if(!GameMode || !GameMode->GetFlowFields().IsValid())
+	{
+		bUsesFlowField = false;
+		return;
+	}
+
+	// Everyone attacking the same position shares one destination, smaller groups included.
+	const bool bCommonTarget = Params.TargetPosition != FVector::ZeroVector;
+	const int32 MinListeners = bCommonTarget ? GroupPathMinListeners : FlowFieldMinListeners;
+
+	bUsesFlowField = ListenerArray.Num() >= MinListeners
+		&& GameMode->GetFlowFields().RequestField(this, bCommonTarget ? Params.TargetPosition : GetActorLocation());
+
+	if(!bUsesFlowField)
+	{
+		GameMode->GetFlowFields().ReleaseField(this);
+	}
+}
+
 //------------------------------------------------------------------------------
 // WaypointSelection
 //------------------------------------------------------------------------------
@@ -0,0 +1,359 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Commandlets/EDU_CORE_ScalingBenchmarkCommandlet.h"
+
+// CORE
+#include "Entities/EDU_CORE_MobileEntity.h"
+#include "Entities/Components/StatusComponent.h"
+#include "Entities/Waypoints/EDU_CORE_Waypoint.h"
+#include "Framework/Data/FLOWLOGS/FLOWLOG_MANAGERS.h"
+#include "Framework/Managers/GameModes/EDU_CORE_GameMode.h"
+
+// UE
+#include "Engine/Engine.h"
+#include "Misc/FileHelper.h"
+#include "UObject/Package.h"
+
+namespace EDU_CORE_ScalingBenchmark
+{
+	// Same as the fixed async physics tick the GameMode normalizes around.
+	constexpr float FixedDeltaTime = 0.02f;
+	
+	// Distance between units in a team block.
+	constexpr float UnitSpacing = 400.f;
+
+	// Distance between a team block and the map origin.
+	constexpr float TeamDistance = 10000.f;
+
+	struct FChannelResult
+	{
+		TArray<float> Milliseconds;
+		int64 Items = 0;
+		float CycleLatency = 0.f;
+	};
+
+	// Nearest-rank percentile of a sorted array
+	float Percentile(const TArray<float>& Sorted, const float Fraction)
+	{
+		if(Sorted.IsEmpty()) return 0.f;
+		const int32 Rank = FMath::CeilToInt32(Fraction * Sorted.Num()) - 1;
+		return Sorted[FMath::Clamp(Rank, 0, Sorted.Num() - 1)];
+	}
+}
+
+//------------------------------------------------------------------------------
+// Construction
+//------------------------------------------------------------------------------
+
+UEDU_CORE_ScalingBenchmarkCommandlet::UEDU_CORE_ScalingBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = true;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+//------------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------------
+
+int32 UEDU_CORE_ScalingBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString MapPath;
+	FString UnitClassPath;
+	if(!FParse::Value(*Params, TEXT("Map="), MapPath) || !FParse::Value(*Params, TEXT("UnitClass="), UnitClassPath))
+	{
+		UE_LOG(FLOWLOG_CATEGORY, Error, TEXT("%hs - Usage: -run=EDU_CORE_ScalingBenchmark -Map=<Map> -UnitClass=<MobileEntity Class> [-GameMode=] [-Counts=] [-Teams=] [-Seconds=] [-Output=]"), __FUNCTION__);
+		return 1;
+	}
+
+	UClass* UnitClass = LoadClass<AEDU_CORE_MobileEntity>(nullptr, *UnitClassPath);
+	if(!UnitClass)
+	{
+		UE_LOG(FLOWLOG_CATEGORY, Error, TEXT("%hs - UnitClass is not an AEDU_CORE_MobileEntity: %s"), __FUNCTION__, *UnitClassPath);
+		return 1;
+	}
+
+	FString GameModePath;
+	FParse::Value(*Params, TEXT("GameMode="), GameModePath);
+
+	FString CountsString = TEXT("100,500,1000,5000,10000");
+	FParse::Value(*Params, TEXT("Counts="), CountsString, false);
+
+	TArray<FString> CountStrings;
+	CountsString.ParseIntoArray(CountStrings, TEXT(","));
+
+	int32 TeamCount = 2;
+	FParse::Value(*Params, TEXT("Teams="), TeamCount);
+	TeamCount = FMath::Clamp(TeamCount, 1, static_cast<int32>(EEDU_CORE_Team::Team_10));
+
+	float Seconds = 30.f;
+	FParse::Value(*Params, TEXT("Seconds="), Seconds);
+	const int32 Frames = FMath::Max(FMath::CeilToInt32(Seconds / EDU_CORE_ScalingBenchmark::FixedDeltaTime), 1);
+
+	FString OutputPath = FPaths::ProfilingDir() / FString::Printf(TEXT("ScalingBenchmark_%s.csv"), *FDateTime::Now().ToString());
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+
+	FString CSV = TEXT("Units,Channel,Frames,Ran (%),Mean (ms),P50 (ms),P95 (ms),P99 (ms),Max (ms),Items/Frame,Cycle Latency (s)\n");
+
+	for(const FString& CountString : CountStrings)
+	{
+		const int32 UnitCount = FCString::Atoi(*CountString);
+		if(UnitCount <= 0) continue;
+
+		UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%hs - Running %d units for %d frames"), __FUNCTION__, UnitCount, Frames);
+
+		UWorld* World = CreateBenchmarkWorld(MapPath, GameModePath);
+		if(!World)
+		{
+			UE_LOG(FLOWLOG_CATEGORY, Error, TEXT("%hs - Failed to load map: %s"), __FUNCTION__, *MapPath);
+			return 1;
+		}
+
+		AEDU_CORE_GameMode* GameMode = Cast<AEDU_CORE_GameMode>(World->GetAuthGameMode());
+		if(!GameMode)
+		{
+			UE_LOG(FLOWLOG_CATEGORY, Error, TEXT("%hs - The GameMode is not an AEDU_CORE_GameMode, use -GameMode="), __FUNCTION__);
+			DestroyBenchmarkWorld(World);
+			return 1;
+		}
+
+		TArray<TArray<AEDU_CORE_MobileEntity*>> Teams;
+		SpawnUnits(World, UnitClass, UnitCount, TeamCount, Teams);
+		IssueOrders(GameMode, Teams);
+		RunBenchmark(World, GameMode, UnitCount, Frames, CSV);
+
+		DestroyBenchmarkWorld(World);
+	}
+
+	if(!FFileHelper::SaveStringToFile(CSV, *OutputPath))
+	{
+		UE_LOG(FLOWLOG_CATEGORY, Error, TEXT("%hs - Failed to write: %s"), __FUNCTION__, *OutputPath);
+		return 1;
+	}
+
+	UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%hs - Results written to: %s"), __FUNCTION__, *OutputPath);
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+// Functionality > World
+//------------------------------------------------------------------------------
+
+UWorld* UEDU_CORE_ScalingBenchmarkCommandlet::CreateBenchmarkWorld(const FString& MapPath, const FString& GameModePath) const
+{
+	UPackage* MapPackage = LoadPackage(nullptr, *MapPath, LOAD_None);
+	UWorld* World = MapPackage ? UWorld::FindWorldInPackage(MapPackage) : nullptr;
+	if(!World) return nullptr;
+
+	World->AddToRoot();
+	World->WorldType = EWorldType::Game;
+
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+
+	if(!World->bIsWorldInitialized)
+	{
+		World->InitWorld();
+	}
+
+	FURL URL;
+	URL.Map = MapPath;
+	if(!GameModePath.IsEmpty())
+	{
+		URL.AddOption(*FString::Printf(TEXT("game=%s"), *GameModePath));
+	}
+
+	World->SetGameMode(URL);
+	World->InitializeActorsForPlay(URL);
+	World->BeginPlay();
+	
+	return World;
+}
+
+void UEDU_CORE_ScalingBenchmarkCommandlet::DestroyBenchmarkWorld(UWorld* World) const
+{
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+
+	// Unload the map, so the next unit count starts from a clean load.
+	CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+}
+
+//------------------------------------------------------------------------------
+// Functionality > Scenario
+//------------------------------------------------------------------------------
+
+void UEDU_CORE_ScalingBenchmarkCommandlet::SpawnUnits(UWorld* World, UClass* UnitClass, const int32 UnitCount, const int32 TeamCount, TArray<TArray<AEDU_CORE_MobileEntity*>>& OutTeams) const
+{
+	using namespace EDU_CORE_ScalingBenchmark;
+	
+	OutTeams.SetNum(TeamCount);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	for(int32 TeamIndex = 0; TeamIndex < TeamCount; ++TeamIndex)
+	{
+		const int32 TeamSize = UnitCount / TeamCount + (TeamIndex < UnitCount % TeamCount ? 1 : 0);
+		const int32 Columns = FMath::Max(FMath::CeilToInt32(FMath::Sqrt(static_cast<float>(TeamSize))), 1);
+
+		// Teams are spread evenly on a circle, facing the origin.
+		const float Angle = 2.f * PI * TeamIndex / TeamCount;
+		const FVector TeamCenter = FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.f) * TeamDistance;
+		const FRotator TeamRotation = (-TeamCenter).Rotation();
+
+		const EEDU_CORE_Team Team = static_cast<EEDU_CORE_Team>(TeamIndex + 1);
+		OutTeams[TeamIndex].Reserve(TeamSize);
+
+		for(int32 UnitIndex = 0; UnitIndex < TeamSize; ++UnitIndex)
+		{
+			const FVector Offset((UnitIndex / Columns - Columns / 2) * UnitSpacing, (UnitIndex % Columns - Columns / 2) * UnitSpacing, 0.f);
+			const FVector Location = TeamCenter + TeamRotation.RotateVector(Offset);
+
+			if(AEDU_CORE_MobileEntity* Unit = World->SpawnActor<AEDU_CORE_MobileEntity>(UnitClass, Location, TeamRotation, SpawnParams))
+			{
+				if(UStatusComponent* StatusComponent = Unit->GetStatusComponent())
+				{
+					StatusComponent->ChangeTeam(Team);
+				}
+				OutTeams[TeamIndex].Add(Unit);
+			}
+		}
+	}
+}
+
+void UEDU_CORE_ScalingBenchmarkCommandlet::IssueOrders(AEDU_CORE_GameMode* GameMode, const TArray<TArray<AEDU_CORE_MobileEntity*>>& Teams) const
+{
+	for(int32 TeamIndex = 0; TeamIndex < Teams.Num(); ++TeamIndex)
+	{
+		const TArray<AEDU_CORE_MobileEntity*>& TeamUnits = Teams[TeamIndex];
+		const TArray<AEDU_CORE_MobileEntity*>& EnemyUnits = Teams[(TeamIndex + 1) % Teams.Num()];
+		if(TeamUnits.IsEmpty()) continue;
+		
+		const EEDU_CORE_Team Team = static_cast<EEDU_CORE_Team>(TeamIndex + 1);
+
+		// Move to the center
+		FWaypointParams MoveParams;
+		MoveParams.WaypointPosition = FVector::ZeroVector;
+		MoveParams.WaypointType = EEDU_CORE_WaypointType::NavigateTo;
+		MoveParams.WaypointTeam = Team;
+
+		// Attack the first unit of the next team
+		FWaypointParams AttackParams;
+		AttackParams.WaypointType = EEDU_CORE_WaypointType::AttackTarget;
+		AttackParams.WaypointTeam = Team;
+		AttackParams.ROE = EEDU_CORE_ROE::FireAtWill;
+		AttackParams.EngagementMode = EEngagementMode::EngageAtWill;
+		if(EnemyUnits.Num() > 0 && Teams.Num() > 1)
+		{
+			AttackParams.TargetArray.Add(EnemyUnits[0]);
+			AttackParams.WaypointPosition = EnemyUnits[0]->GetActorLocation();
+		}
+
+		AEDU_CORE_Waypoint* MoveWaypoint = GameMode->GetFreshWaypointFromPool(Team, MoveParams.WaypointPosition);
+		AEDU_CORE_Waypoint* AttackWaypoint = AttackParams.TargetArray.Num() > 0 ? GameMode->GetFreshWaypointFromPool(Team, AttackParams.WaypointPosition) : nullptr;
+		if(!MoveWaypoint)
+		{
+			UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("%hs - No Waypoint, make sure WaypointClass is set in the GameMode"), __FUNCTION__);
+			return;
+		}
+		
+		MoveWaypoint->SetWaypointParams(MoveParams);
+		if(AttackWaypoint)
+		{
+			AttackWaypoint->SetWaypointParams(AttackParams);
+		}
+
+		for(int32 UnitIndex = 0; UnitIndex < TeamUnits.Num(); ++UnitIndex)
+		{
+			AEDU_CORE_Waypoint* Waypoint = (AttackWaypoint && UnitIndex % 2) ? AttackWaypoint : MoveWaypoint;
+			Waypoint->AddActorToWaypoint(TeamUnits[UnitIndex]);
+		}
+
+		// Notify outside the loop, else listeners are notified several times.
+		MoveWaypoint->NotifyListeners();
+		if(AttackWaypoint)
+		{
+			AttackWaypoint->NotifyListeners();
+		}
+	}
+}
+
+//------------------------------------------------------------------------------
+// Functionality > Measurement
+//------------------------------------------------------------------------------
+
+void UEDU_CORE_ScalingBenchmarkCommandlet::RunBenchmark(UWorld* World, AEDU_CORE_GameMode* GameMode, const int32 UnitCount, const int32 Frames, FString& CSV) const
+{
+	using namespace EDU_CORE_ScalingBenchmark;
+
+	const TArray<TUniquePtr<FTickLane>>& Lanes = GameMode->GetTickLanes();
+
+	// Frame first, then every lane in registration order.
+	TArray<FChannelResult> Results;
+	Results.SetNum(Lanes.Num() + 1);
+	for(FChannelResult& Result : Results)
+	{
+		Result.Milliseconds.Reserve(Frames);
+	}
+
+	for(int32 Frame = 0; Frame < Frames; ++Frame)
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		
+		World->Tick(LEVELTICK_All, FixedDeltaTime);
+
+		// Run the game thread callbacks the lanes queued this frame.
+		FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+		
+		Results[0].Milliseconds.Add(static_cast<float>((FPlatformTime::Seconds() - StartTime) * 1000.0));
+
+		for(int32 LaneIndex = 0; LaneIndex < Lanes.Num(); ++LaneIndex)
+		{
+			FChannelResult& Result = Results[LaneIndex + 1];
+
+			// Periodic and budgeted lanes skip frames, their 0ms would drag the percentiles down.
+			if(Lanes[LaneIndex]->GetItemsThisFrame() > 0)
+			{
+				Result.Milliseconds.Add(Lanes[LaneIndex]->GetLastFrameMs());
+			}
+			Result.Items += Lanes[LaneIndex]->GetItemsThisFrame();
+			Result.CycleLatency = Lanes[LaneIndex]->GetLastCycleLatency();
+		}
+
+		++GFrameCounter;
+	}
+
+	for(int32 Channel = 0; Channel < Results.Num(); ++Channel)
+	{
+		FChannelResult& Result = Results[Channel];
+		const FString ChannelName = Channel == 0 ? TEXT("Frame") : Lanes[Channel - 1]->GetSettings().Name.ToString();
+
+		double Total = 0.0;
+		for(const float Milliseconds : Result.Milliseconds)
+		{
+			Total += Milliseconds;
+		}
+		Result.Milliseconds.Sort();
+
+		// The frame has no items of its own, the unit count is in the Units column.
+		const FString ItemsPerFrame = Channel == 0 ? FString() : FString::Printf(TEXT("%.2f"), static_cast<double>(Result.Items) / Frames);
+
+		// Times are over the frames the channel ran, how often that was is its own column.
+		const int32 RanFrames = Result.Milliseconds.Num();
+
+		CSV += FString::Printf(TEXT("%d,%s,%d,%.1f,%.4f,%.4f,%.4f,%.4f,%.4f,%s,%.3f\n"),
+			UnitCount, *ChannelName, Frames,
+			100.0 * RanFrames / Frames,
+			RanFrames > 0 ? Total / RanFrames : 0.0,
+			Percentile(Result.Milliseconds, 0.50f),
+			Percentile(Result.Milliseconds, 0.95f),
+			Percentile(Result.Milliseconds, 0.99f),
+			RanFrames > 0 ? Result.Milliseconds.Last() : 0.f,
+			*ItemsPerFrame,
+			Result.CycleLatency);
+	}
+}
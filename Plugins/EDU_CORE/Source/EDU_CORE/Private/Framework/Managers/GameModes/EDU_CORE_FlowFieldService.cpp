@@ -0,0 +1,343 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_FlowFieldService.h"
+
+// CORE
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+
+// UE
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "NavigationSystem.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("FlowField Built Fields"), STAT_EDU_FlowFieldBuilt, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("FlowField Cached Fields"), STAT_EDU_FlowFieldCached, STATGROUP_EDU_TickLanes);
+
+namespace EDU_CORE_FlowField
+{
+	// Orthogonal first, the step masks rely on it.
+	constexpr int32 NumNeighbours = 8;
+	constexpr int32 NeighbourX[NumNeighbours] = { 1, 0, -1, 0, 1, -1, -1, 1 };
+	constexpr int32 NeighbourY[NumNeighbours] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+
+	// The orthogonal neighbours a diagonal step passes between.
+	constexpr int32 DiagonalSides[4][2] = { { 0, 1 }, { 2, 1 }, { 2, 3 }, { 0, 3 } };
+
+	// Cells next to a blocked cell or a cut step.
+	constexpr uint8 EdgeCost = 3;
+}
+
+//------------------------------------------------------------------------------
+// Bake
+//------------------------------------------------------------------------------
+
+bool FFlowFieldService::Bake(const UWorld* World, const FBox& Bounds, const float NewCellSize, const float MaxSlope)
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE(FFlowFieldService::Bake);
+
+	Reset();
+	if(!World || !Bounds.IsValid) return false;
+
+	const UNavigationSystemV1* NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	const ANavigationData* NavData = NavSystem ? NavSystem->GetMainNavData() : nullptr;
+	if(!NavData) return false;
+
+	CellSize = FMath::Max(NewCellSize, 50.f);
+	InvCellSize = 1.f / CellSize;
+
+	// In 64 bits, unbounded level bounds overflow an int32 cell count.
+	const int64 NumX = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.X - Bounds.Min.X) * InvCellSize), 1);
+	const int64 NumY = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.Y - Bounds.Min.Y) * InvCellSize), 1);
+	if(NumX * NumY > MaxCells)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FFlowFieldService::Bake - %lld x %lld cells exceed MaxCells (%d), set TerrainBounds to the playable area or raise the cell size."), NumX, NumY, MaxCells);
+		return false;
+	}
+
+	Origin = FVector2D(Bounds.Min);
+	SizeX = static_cast<int32>(NumX);
+	SizeY = static_cast<int32>(NumY);
+	const int32 NumCells = SizeX * SizeY;
+
+	TArray<bool> Walkable;
+	Walkable.SetNumZeroed(NumCells);
+
+	TArray<float> Heights;
+	Heights.SetNumZeroed(NumCells);
+
+	// A cell is walkable if the navmesh covers its center, the projection keeps the level closest to the middle of the bounds.
+	const FVector Extent(CellSize * 0.5f, CellSize * 0.5f, (Bounds.Max.Z - Bounds.Min.Z) * 0.5f + 100.f);
+	const float CenterZ = Bounds.GetCenter().Z;
+
+	// One row per task, projection is a read only navmesh query, like the async path queries.
+	ParallelFor(TEXT("FlowField Bake"), SizeY, 1, [&](const int32 CellY)
+	{
+		for(int32 CellX = 0; CellX < SizeX; ++CellX)
+		{
+			const int32 Cell = CellY * SizeX + CellX;
+			const FVector Center(Origin.X + (CellX + 0.5f) * CellSize, Origin.Y + (CellY + 0.5f) * CellSize, CenterZ);
+
+			FNavLocation NavLocation;
+			Walkable[Cell] = NavData->ProjectPoint(Center, NavLocation, Extent);
+			Heights[Cell] = NavLocation.Location.Z;
+		}
+	});
+
+	/*---------------------------------------------------------------------
+	  Steps between walkable cells further apart in height than MaxSlope
+	  allows over the distance are cut: cliffs, walls the navmesh goes
+	  around, and the other level under a bridge. Blocked cells keep
+	  their steps into walkable cells, so they point back onto the grid.
+	---------------------------------------------------------------------*/
+	const float MaxRise = CellSize * FMath::Tan(FMath::DegreesToRadians(FMath::Clamp(MaxSlope, 1.f, 89.f)));
+
+	auto IsOpenStep = [&](const int32 CellX, const int32 CellY, const int32 Neighbour)
+	{
+		const int32 ToX = CellX + EDU_CORE_FlowField::NeighbourX[Neighbour];
+		const int32 ToY = CellY + EDU_CORE_FlowField::NeighbourY[Neighbour];
+		if(!IsValidCell(ToX, ToY) || !Walkable[ToY * SizeX + ToX]) return false;
+
+		const int32 Cell = CellY * SizeX + CellX;
+		if(!Walkable[Cell]) return true;
+
+		return FMath::Abs(Heights[ToY * SizeX + ToX] - Heights[Cell]) <= MaxRise * (Neighbour < 4 ? 1.f : UE_SQRT_2);
+	};
+
+	Costs.SetNumUninitialized(NumCells);
+	StepMasks.SetNumUninitialized(NumCells);
+	int32 NumWalkable = 0;
+
+	for(int32 CellY = 0; CellY < SizeY; ++CellY)
+	{
+		for(int32 CellX = 0; CellX < SizeX; ++CellX)
+		{
+			const int32 Cell = CellY * SizeX + CellX;
+
+			uint8 StepMask = 0;
+			bool bNextToBlocked = false;
+
+			for(int32 Neighbour = 0; Neighbour < EDU_CORE_FlowField::NumNeighbours; ++Neighbour)
+			{
+				bool bOpen = IsOpenStep(CellX, CellY, Neighbour);
+
+				// Diagonal, both orthogonal steps have to be open.
+				if(bOpen && Neighbour >= 4)
+				{
+					const int32* Sides = EDU_CORE_FlowField::DiagonalSides[Neighbour - 4];
+					bOpen = ((StepMask >> Sides[0]) & 1) && ((StepMask >> Sides[1]) & 1);
+				}
+
+				if(bOpen)
+				{
+					StepMask |= 1 << Neighbour;
+				}
+				else if(IsValidCell(CellX + EDU_CORE_FlowField::NeighbourX[Neighbour], CellY + EDU_CORE_FlowField::NeighbourY[Neighbour]))
+				{
+					bNextToBlocked = true;
+				}
+			}
+
+			StepMasks[Cell] = StepMask;
+
+			if(!Walkable[Cell])
+			{
+				Costs[Cell] = BlockedCost;
+				continue;
+			}
+
+			++NumWalkable;
+			Costs[Cell] = bNextToBlocked ? EDU_CORE_FlowField::EdgeCost : 1;
+		}
+	}
+
+	if(NumWalkable == 0)
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+void FFlowFieldService::Reset()
+{
+	Costs.Empty();
+	StepMasks.Empty();
+	Fields.Empty();
+	FreeScratch.Empty();
+	SizeX = 0;
+	SizeY = 0;
+}
+
+//------------------------------------------------------------------------------
+// Fields
+//------------------------------------------------------------------------------
+
+bool FFlowFieldService::RequestField(const UObject* Owner, const FVector& Goal)
+{
+	check(IsInGameThread());
+
+	const int32 GoalCell = GetCellIndex(Goal);
+	if(!Owner || GoalCell == INDEX_NONE || Costs[GoalCell] == BlockedCost)
+	{
+		ReleaseField(Owner);
+		return false;
+	}
+
+	FField& Field = Fields.FindOrAdd(Owner);
+	if(Field.GoalCell != GoalCell)
+	{
+		Field.Owner = Owner;
+		Field.GoalCell = GoalCell;
+		Field.bBuilt = false;
+	}
+	return true;
+}
+
+void FFlowFieldService::ReleaseField(const UObject* Owner)
+{
+	check(IsInGameThread());
+	Fields.Remove(Owner);
+}
+
+void FFlowFieldService::Flush()
+{ // FLOW_LOG
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE(FFlowFieldService::Flush);
+
+	TArray<FField*> Pending;
+	for(auto It = Fields.CreateIterator(); It; ++It)
+	{
+		if(!It.Value().Owner.IsValid())
+		{
+			It.RemoveCurrent();
+		}
+		else if(!It.Value().bBuilt)
+		{
+			Pending.Add(&It.Value());
+		}
+	}
+
+	LastBuiltFields = Pending.Num();
+	SET_DWORD_STAT(STAT_EDU_FlowFieldBuilt, LastBuiltFields);
+	SET_DWORD_STAT(STAT_EDU_FlowFieldCached, Fields.Num());
+
+	if(Pending.Num() == 0) return;
+
+	// Fields only read the cost grid, one field per task.
+	ParallelFor(TEXT("FlowField Build"), Pending.Num(), 1, [this, &Pending](const int32 Index)
+	{
+		BuildField(*Pending[Index]);
+	});
+}
+
+void FFlowFieldService::BuildField(FField& Field) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FFlowFieldService::BuildField);
+
+	/*---------------------------------------------------------------------
+	  Dijkstra from the goal outwards, the integrated cost of a cell is
+	  the cheapest way from it to the goal. Diagonal steps cost sqrt(2).
+	---------------------------------------------------------------------*/
+	const int32 NumCells = SizeX * SizeY;
+
+	TUniquePtr<FBuildScratch> Scratch = AcquireScratch();
+	TArray<float>& Integration = Scratch->Integration;
+	TArray<FOpenCell>& Open = Scratch->Open;
+
+	Integration.Init(UE_BIG_NUMBER, NumCells);
+	Open.Reset();
+	Open.HeapPush({ 0.f, Field.GoalCell });
+	Integration[Field.GoalCell] = 0.f;
+
+	while(Open.Num() > 0)
+	{
+		FOpenCell Current;
+		Open.HeapPop(Current, EAllowShrinking::No);
+
+		// Reached cheaper since it was pushed.
+		if(Current.Cost > Integration[Current.Cell]) continue;
+
+		const int32 CellX = Current.Cell % SizeX;
+		const int32 CellY = Current.Cell / SizeX;
+
+		for(int32 Neighbour = 0; Neighbour < EDU_CORE_FlowField::NumNeighbours; ++Neighbour)
+		{
+			if(!CanStep(Current.Cell, Neighbour)) continue;
+
+			const int32 NeighbourCell = (CellY + EDU_CORE_FlowField::NeighbourY[Neighbour]) * SizeX + CellX + EDU_CORE_FlowField::NeighbourX[Neighbour];
+			const float StepCost = Costs[NeighbourCell] * (Neighbour < 4 ? 1.f : UE_SQRT_2);
+			const float NewCost = Current.Cost + StepCost;
+
+			if(NewCost < Integration[NeighbourCell])
+			{
+				Integration[NeighbourCell] = NewCost;
+				Open.HeapPush({ NewCost, NeighbourCell });
+			}
+		}
+	}
+
+	// Every cell points to its cheapest neighbour, rows are independent.
+	Field.Directions.SetNumUninitialized(NumCells);
+
+	ParallelFor(TEXT("FlowField Directions"), SizeY, 8, [this, &Field, &Integration](const int32 CellY)
+	{
+		for(int32 CellX = 0; CellX < SizeX; ++CellX)
+		{
+			const int32 Cell = CellY * SizeX + CellX;
+
+			uint8 Direction = NoDirection;
+			float LowestCost = Integration[Cell];
+
+			for(int32 Neighbour = 0; Neighbour < EDU_CORE_FlowField::NumNeighbours; ++Neighbour)
+			{
+				if(!CanStep(Cell, Neighbour)) continue;
+
+				const int32 NeighbourCell = (CellY + EDU_CORE_FlowField::NeighbourY[Neighbour]) * SizeX + CellX + EDU_CORE_FlowField::NeighbourX[Neighbour];
+				if(Integration[NeighbourCell] < LowestCost)
+				{
+					LowestCost = Integration[NeighbourCell];
+					Direction = static_cast<uint8>(Neighbour);
+				}
+			}
+
+			Field.Directions[Cell] = Direction;
+		}
+	});
+
+	ReleaseScratch(MoveTemp(Scratch));
+	Field.bBuilt = true;
+}
+
+TUniquePtr<FFlowFieldService::FBuildScratch> FFlowFieldService::AcquireScratch() const
+{
+	FScopeLock Lock(&ScratchLock);
+	return FreeScratch.Num() > 0 ? FreeScratch.Pop(EAllowShrinking::No) : MakeUnique<FBuildScratch>();
+}
+
+void FFlowFieldService::ReleaseScratch(TUniquePtr<FBuildScratch>&& Scratch) const
+{
+	FScopeLock Lock(&ScratchLock);
+	FreeScratch.Add(MoveTemp(Scratch));
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+bool FFlowFieldService::GetDirection(const UObject* Owner, const FVector& Location, FVector& OutDirection) const
+{ // FLOW_LOG
+	const FField* Field = Fields.Find(Owner);
+	if(!Field || !Field->bBuilt) return false;
+
+	const int32 Cell = GetCellIndex(Location);
+	if(Cell == INDEX_NONE) return false;
+
+	const uint8 Direction = Field->Directions[Cell];
+	if(Direction == NoDirection) return false;
+
+	OutDirection = FVector(EDU_CORE_FlowField::NeighbourX[Direction], EDU_CORE_FlowField::NeighbourY[Direction], 0.f).GetUnsafeNormal();
+	return true;
+}
@@ -0,0 +1,169 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_FogOfWarGrid.h"
+
+// CORE
+#include "Framework/Managers/GameModes/EDU_CORE_TerrainHeightfield.h"
+
+//------------------------------------------------------------------------------
+// Construction
+//------------------------------------------------------------------------------
+
+bool FFogOfWarGrid::Init(const FBox& Bounds, const float NewCellSize, const float NewTargetHeight, const FTerrainHeightfield* NewTerrain)
+{
+	check(IsInGameThread());
+
+	Reset();
+	if(!Bounds.IsValid) return false;
+
+	CellSize = FMath::Max(NewCellSize, 100.f);
+	InvCellSize = 1.f / CellSize;
+
+	// In 64 bits, unbounded level bounds overflow an int32 cell count.
+	const int64 NumX = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.X - Bounds.Min.X) * InvCellSize), 1);
+	const int64 NumY = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.Y - Bounds.Min.Y) * InvCellSize), 1);
+	if(NumX * NumY > MaxCells)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FFogOfWarGrid::Init - %lld x %lld cells exceed MaxCells (%d), set TerrainBounds to the playable area."), NumX, NumY, MaxCells);
+		return false;
+	}
+
+	TargetHeight = NewTargetHeight;
+	Terrain = NewTerrain && NewTerrain->IsValid() ? NewTerrain : nullptr;
+
+	Origin = FVector2D(Bounds.Min);
+	SizeX = static_cast<int32>(NumX);
+	SizeY = static_cast<int32>(NumY);
+	NumCells = SizeX * SizeY;
+
+	// Value initialized, every cell starts dark.
+	CurrentCells = MakeUnique<std::atomic<FTeamMask>[]>(NumCells);
+	PreviousCells = MakeUnique<std::atomic<FTeamMask>[]>(NumCells);
+	return true;
+}
+
+void FFogOfWarGrid::Reset()
+{
+	CurrentCells.Reset();
+	PreviousCells.Reset();
+	Terrain = nullptr;
+	SizeX = 0;
+	SizeY = 0;
+	NumCells = 0;
+}
+
+void FFogOfWarGrid::Refresh()
+{
+	check(IsInGameThread());
+	if(!IsValid()) return;
+
+	// The old cycle becomes the previous one, and the oldest is cleared for reuse.
+	Swap(CurrentCells, PreviousCells);
+	for(int32 Index = 0; Index < NumCells; ++Index)
+	{
+		CurrentCells[Index].store(0, std::memory_order_relaxed);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Stamping
+//------------------------------------------------------------------------------
+
+template<typename CellFilterType>
+void FFogOfWarGrid::Stamp(const FVector& Eye, const FVector2D& BoxMin, const FVector2D& BoxMax, const EEDU_CORE_Team Team, CellFilterType&& CellFilter)
+{ // FLOW_LOG
+	if(!IsValid() || !FTeamVisibility::IsValidTeam(Team)) return;
+
+	const FTeamMask TeamBit = FTeamVisibility::GetTeamBit(Team);
+
+	const int32 MinX = FMath::Max(FMath::FloorToInt32((BoxMin.X - Origin.X) * InvCellSize), 0);
+	const int32 MinY = FMath::Max(FMath::FloorToInt32((BoxMin.Y - Origin.Y) * InvCellSize), 0);
+	const int32 MaxX = FMath::Min(FMath::FloorToInt32((BoxMax.X - Origin.X) * InvCellSize), SizeX - 1);
+	const int32 MaxY = FMath::Min(FMath::FloorToInt32((BoxMax.Y - Origin.Y) * InvCellSize), SizeY - 1);
+
+	for(int32 CellY = MinY; CellY <= MaxY; ++CellY)
+	{
+		for(int32 CellX = MinX; CellX <= MaxX; ++CellX)
+		{
+			std::atomic<FTeamMask>& Cell = CurrentCells[CellY * SizeX + CellX];
+
+			// Another observer of our team got here first, skip the terrain walk.
+			if(Cell.load(std::memory_order_relaxed) & TeamBit) continue;
+
+			const FVector2D CellCenter(Origin.X + (CellX + 0.5f) * CellSize, Origin.Y + (CellY + 0.5f) * CellSize);
+			if(!CellFilter(CellCenter)) continue;
+
+			if(Terrain)
+			{
+				const FVector CellTarget(CellCenter.X, CellCenter.Y, Terrain->GetHeight(FVector(CellCenter, 0.f)) + TargetHeight);
+				if(Terrain->IsBlocked(Eye, CellTarget)) continue;
+			}
+
+			Cell.fetch_or(TeamBit, std::memory_order_relaxed);
+		}
+	}
+}
+
+void FFogOfWarGrid::StampCircle(const FVector& Eye, const FVector& Center, const float Radius, const EEDU_CORE_Team Team)
+{
+	const FVector2D Center2D(Center);
+	const float RadiusSquared = FMath::Square(Radius);
+
+	Stamp(Eye, Center2D - Radius, Center2D + Radius, Team, [&](const FVector2D& CellCenter)
+	{
+		return FVector2D::DistSquared(CellCenter, Center2D) <= RadiusSquared;
+	});
+}
+
+void FFogOfWarGrid::StampCapsule(const FVector& Eye, const FVector& SegmentStart, const FVector& SegmentEnd, const float Radius, const EEDU_CORE_Team Team)
+{
+	const FVector FlatStart(SegmentStart.X, SegmentStart.Y, 0.f);
+	const FVector FlatEnd(SegmentEnd.X, SegmentEnd.Y, 0.f);
+	const float RadiusSquared = FMath::Square(Radius);
+
+	const FVector2D BoxMin(FMath::Min(FlatStart.X, FlatEnd.X) - Radius, FMath::Min(FlatStart.Y, FlatEnd.Y) - Radius);
+	const FVector2D BoxMax(FMath::Max(FlatStart.X, FlatEnd.X) + Radius, FMath::Max(FlatStart.Y, FlatEnd.Y) + Radius);
+
+	Stamp(Eye, BoxMin, BoxMax, Team, [&](const FVector2D& CellCenter)
+	{
+		return FMath::PointDistToSegmentSquared(FVector(CellCenter, 0.f), FlatStart, FlatEnd) <= RadiusSquared;
+	});
+}
+
+//------------------------------------------------------------------------------
+// Lookup
+//------------------------------------------------------------------------------
+
+int32 FFogOfWarGrid::GetCellIndex(const FVector& Location) const
+{
+	const int32 CellX = FMath::FloorToInt32((Location.X - Origin.X) * InvCellSize);
+	const int32 CellY = FMath::FloorToInt32((Location.Y - Origin.Y) * InvCellSize);
+
+	if(CellX < 0 || CellY < 0 || CellX >= SizeX || CellY >= SizeY) return INDEX_NONE;
+	return CellY * SizeX + CellX;
+}
+
+FFogOfWarGrid::FTeamMask FFogOfWarGrid::GetVisibleTeams(const FVector& Location) const
+{
+	const int32 Index = GetCellIndex(Location);
+	if(Index == INDEX_NONE) return 0;
+
+	return CurrentCells[Index].load(std::memory_order_relaxed) | PreviousCells[Index].load(std::memory_order_relaxed);
+}
+
+void FFogOfWarGrid::GetTeamRaster(const EEDU_CORE_Team Team, TBitArray<>& OutVisible) const
+{
+	OutVisible.Init(false, NumCells);
+	if(!IsValid() || !FTeamVisibility::IsValidTeam(Team)) return;
+
+	const FTeamMask TeamBit = FTeamVisibility::GetTeamBit(Team);
+	for(int32 Index = 0; Index < NumCells; ++Index)
+	{
+		const FTeamMask Mask = CurrentCells[Index].load(std::memory_order_relaxed) | PreviousCells[Index].load(std::memory_order_relaxed);
+		if(Mask & TeamBit)
+		{
+			OutVisible[Index] = true;
+		}
+	}
+}
@@ -0,0 +1,107 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_FrameTimeRecorder.h"
+
+// UE
+#include "Misc/FileHelper.h"
+
+//------------------------------------------------------------------------------
+// Setup
+//------------------------------------------------------------------------------
+
+int32 FFrameTimeRecorder::AddChannel(const FName& Name)
+{
+	TUniquePtr<FChannel> Channel = MakeUnique<FChannel>();
+	Channel->Name = Name;
+	return Channels.Add(MoveTemp(Channel));
+}
+
+void FFrameTimeRecorder::Reset()
+{
+	for(const TUniquePtr<FChannel>& Channel : Channels)
+	{
+		Channel->WriteIndex.store(0, std::memory_order_release);
+	}
+}
+
+//------------------------------------------------------------------------------
+// Evaluation
+//------------------------------------------------------------------------------
+
+void FFrameTimeRecorder::CopySamples(const int32 Channel, TArray<float>& OutSamples) const
+{
+	const FChannel& Source = *Channels[Channel];
+	const uint32 WriteIndex = Source.WriteIndex.load(std::memory_order_acquire);
+	const uint32 Count = FMath::Min(WriteIndex, Capacity);
+
+	OutSamples.Reset(Count);
+	for(uint32 Index = WriteIndex - Count; Index != WriteIndex; ++Index)
+	{
+		OutSamples.Add(Source.Samples[Index & (Capacity - 1)]);
+	}
+}
+
+FFrameTimeRecorder::FSummary FFrameTimeRecorder::GetSummary(const int32 Channel) const
+{
+	FSummary Summary;
+	
+	TArray<float> Samples;
+	CopySamples(Channel, Samples);
+	if(Samples.IsEmpty()) return Summary;
+
+	Samples.Sort();
+
+	// Nearest-rank percentile
+	auto Percentile = [&Samples](const float Fraction)
+	{
+		const int32 Rank = FMath::CeilToInt32(Fraction * Samples.Num()) - 1;
+		return Samples[FMath::Clamp(Rank, 0, Samples.Num() - 1)];
+	};
+
+	Summary.SampleCount = Samples.Num();
+	Summary.P50 = Percentile(0.50f);
+	Summary.P95 = Percentile(0.95f);
+	Summary.P99 = Percentile(0.99f);
+	Summary.Max = Samples.Last();
+	return Summary;
+}
+
+bool FFrameTimeRecorder::WriteCSV(const FString& FilePath) const
+{
+	// Upper bucket edges in ms, 16.7 and 33.3 are 60 and 30 FPS.
+	static constexpr float BucketEdges[] = { 1.f, 2.f, 4.f, 8.f, 12.f, 16.7f, 20.f, 25.f, 33.3f, 50.f, 100.f };
+	constexpr int32 NumBuckets = UE_ARRAY_COUNT(BucketEdges) + 1;
+
+	FString CSV = TEXT("Channel,Samples,P50 (ms),P95 (ms),P99 (ms),Max (ms)");
+	for(const float Edge : BucketEdges)
+	{
+		CSV += FString::Printf(TEXT(",<%.1f"), Edge);
+	}
+	CSV += FString::Printf(TEXT(",>=%.1f\n"), BucketEdges[NumBuckets - 2]);
+
+	TArray<float> Samples;
+	for(int32 Channel = 0; Channel < Channels.Num(); ++Channel)
+	{
+		const FSummary Summary = GetSummary(Channel);
+		CSV += FString::Printf(TEXT("%s,%d,%.3f,%.3f,%.3f,%.3f"),
+			*Channels[Channel]->Name.ToString(), Summary.SampleCount, Summary.P50, Summary.P95, Summary.P99, Summary.Max);
+
+		int32 Histogram[NumBuckets] = {};
+		CopySamples(Channel, Samples);
+		for(const float Sample : Samples)
+		{
+			int32 Bucket = 0;
+			while(Bucket < NumBuckets - 1 && Sample >= BucketEdges[Bucket]) ++Bucket;
+			++Histogram[Bucket];
+		}
+
+		for(const int32 Count : Histogram)
+		{
+			CSV += FString::Printf(TEXT(",%d"), Count);
+		}
+		CSV += TEXT("\n");
+	}
+
+	return FFileHelper::SaveStringToFile(CSV, *FilePath);
+}
@@ -19,6 +19,10 @@
 #include "Framework/Data/FLOWLOGS/FLOWLOG_MANAGERS.h"
 #include "Framework/Pawns/EDU_CORE_C2_Camera.h"
 
+// UE
+#include "Engine/LevelBounds.h"
+#include "Components/PrimitiveComponent.h"
+
 //------------------------------------------------------------------------------
 // Construction & Object Lifetime Management
 //------------------------------------------------------------------------------
@@ -35,37 +39,17 @@ AEDU_CORE_GameMode::AEDU_CORE_GameMode(const FObjectInitializer& ObjectInitializ
 void AEDU_CORE_GameMode::InitiateArrays()
 {
 
-	VisibilityStruct.Team_0_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_1_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_2_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_3_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_4_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_5_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_6_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_7_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_8_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_9_VisibleActors.Reserve(900);
-	VisibilityStruct.Team_10_VisibleActors.Reserve(900);
-
-	VisibilityStruct.Team_0_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_1_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_2_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_3_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_4_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_5_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_6_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_7_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_8_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_9_HiddenActors.Reserve(900);
-	VisibilityStruct.Team_10_HiddenActors.Reserve(900);
-
-	AbstractEntityArray.Reserve(500);
-	PhysicsEntityArray.Reserve(1000);
-	MobileEntityArray.Reserve(1000);
-	SightComponentArray.Reserve(1000);
-	StatusComponentArray.Reserve(1000);
-	TurretComponentArray.Reserve(1000);
-	EngagementComponentArray.Reserve(1000);
+	TeamVisibility.Reserve(900);
+
+	AbstractEntityRegistry.Reserve(500);
+	PhysicsEntityRegistry.Reserve(1000);
+	MobileEntityRegistry.Reserve(1000);
+	SleepingMobileEntityRegistry.Reserve(1000);
+	SightComponentRegistry.Reserve(1000);
+	StatusComponentRegistry.Reserve(1000);
+	TurretComponentRegistry.Reserve(1000);
+	FixedWeaponComponentRegistry.Reserve(1000);
+	EngagementComponentRegistry.Reserve(1000);
 
 	Team_0_Array.Reserve(100);
 	Team_1_Array.Reserve(100);
@@ -86,30 +70,6 @@ void AEDU_CORE_GameMode::Tick(float DeltaTime)
 { //FLOW_LOG
 	
 	Super::Tick(DeltaTime);
-	//------------------------------------------------------------------------------
-	// Debug
-	//------------------------------------------------------------------------------
-	
-	if (DeltaTime < 0.016f)			DeltaTimeDisplayColor = FColor::Green;
-	else if (DeltaTime < 0.02f)		DeltaTimeDisplayColor = FColor::Yellow;
-	else 							DeltaTimeDisplayColor = FColor::Red;
-	
-	// Add an on-screen debug message with the specified DisplayColor and DeltaTime information
-	GEngine->AddOnScreenDebugMessage(12, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	FString::Printf(TEXT("FPS: %f"), 1.f/DeltaTime));
-
-	FPSCounter++;
-	FPSTotal += 1.f/DeltaTime;
-	
-	GEngine->AddOnScreenDebugMessage(13, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	FString::Printf(TEXT("AVG FPS: %f"), FPSTotal / FPSCounter));
-	
-	if(FPSCounter > 500)
-	{
-		FPSCounter = 0;
-		FPSTotal = 0;
-	}
-	
 	//------------------------------------------------------------------------------
 	// Normalized Time
 	//	<!> Because of our Async Physics Tick, we want to normalize our internal
@@ -126,515 +86,409 @@ void AEDU_CORE_GameMode::Tick(float DeltaTime)
 	
 	AsyncedClock = AccumulatedAsyncDeltatime / AsyncPhysicsFPS;
 	LastAsyncedClock = AsyncedClock;
-
-	GEngine->AddOnScreenDebugMessage(19, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	FString::Printf(TEXT("AsyncDeltaTime: %f"), AsyncDeltaTime));
-	
-	// GEngine->AddOnScreenDebugMessage(20, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	// FString::Printf(TEXT("Accumulated AsyncDeltatime: %f"), AccumulatedAsyncDeltatime));
-	
-	GEngine->AddOnScreenDebugMessage(21, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	FString::Printf(TEXT("Real Clock: %f"), GetWorld()->GetTimeSeconds()));
-	
-	GEngine->AddOnScreenDebugMessage(22, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	FString::Printf(TEXT("Asynced Clock: %f"), AsyncedClock ));
-
-	// GEngine->AddOnScreenDebugMessage(23, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-	// FString::Printf(TEXT("Asynced Seconds / Real Second: %f"), GetWorld()->GetTimeSeconds() / AsyncedClock));
 	
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > AbstractEntityArray // Not in use.
+	// Server-Side Aggregated Tick > Spatial Grid
+	//	<!> Rebuilt before the lanes, which only read it.
 	//------------------------------------------------------------------------------
-	
+
+	UpdateSpatialGrid();
+
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > PhysicsEntityArray
+	// Server-Side Aggregated Tick > Visibility Expiry
+	//	<!> Only the entities a team just lost sight of are touched.
 	//------------------------------------------------------------------------------
-	
-		ParallelFor(PhysicsEntityArray.Num(), [this, DeltaTime](int32 Index)
-		{
-			if(AEDU_CORE_PhysicsEntity* Entity = PhysicsEntityArray[Index])  // Single access with conditional initialization
-			{
-				Entity->ServerPhysicsCalc(DeltaTime);
-			}
-		});
 
-		// Sequential execution of ServerPhysicsExec on each entity
-		for(TObjectPtr<AEDU_CORE_PhysicsEntity> PhysicsEntity : PhysicsEntityArray)
-		{
-			if (PhysicsEntity)  // Check for valid entity
-			{
-				PhysicsEntity->ServerPhysicsExec(DeltaTime);
-			}
-		}
+	ProcessVisibilityExpiry();
 
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > MobileEntityArray
+	// Server-Side Aggregated Tick > Fog of War
+	//	<!> A new stamping cycle starts before the lanes, cells last stamped two
+	//		cycles ago go dark.
 	//------------------------------------------------------------------------------
-	
-		ParallelFor(MobileEntityArray.Num(), [this, DeltaTime](int32 Index)
-		{
-			if(AEDU_CORE_MobileEntity* MobileEntity = MobileEntityArray[Index])  // Checking for validity only once
-			{
-				MobileEntity->ServerMobileCalc(DeltaTime, CurrentBatchIndex_10);
-			}
-		});
 
-		// Sequential execution of ServerMobilesExec on each entity
-		for(AEDU_CORE_MobileEntity* MobileEntity : MobileEntityArray)
-		{
-			if (MobileEntity)
-			{
-				MobileEntity->ServerMobileExec(DeltaTime, CurrentBatchIndex_10);
-			}
-		}
+	if(FogOfWar.IsValid() && AsyncedClock >= NextFogOfWarRefresh)
+	{
+		FogOfWar.Refresh();
+		NextFogOfWarRefresh = AsyncedClock + FogOfWarRefreshPeriod;
+	}
+	
+	//------------------------------------------------------------------------------
+	// Server-Side Aggregated Tick > Tick Lanes
+	//	<!> Lanes are declared in RegisterTickLanes(), and tick in that order.
+	//		Registries are locked meanwhile, removals from Exec are applied after.
+	//------------------------------------------------------------------------------
 
-		// If more than X.X second has passed since the last cycle, start a new batch cycle
-		if (AsyncedClock - LastMobilEntityBatchTime >= 0.75f)
-		{
-			if (MobileEntityBatchIndex == 0)
-			{
-				LastMobilEntityBatchTime = AsyncedClock;
-			}
-			constexpr int32 BatchSize = 40;
-	    		
-			// Calculate the end index for the current batch
-			const int32 ThisTickEndIndex = FMath::Min(MobileEntityBatchIndex + BatchSize, MobileEntityArray.Num());
-		        
-			//* Parallel batch processing of ServerMobileBatchedCalc
-			ParallelFor(ThisTickEndIndex - MobileEntityBatchIndex, [this, StartIndex = MobileEntityBatchIndex](int32 LocalIndex)
-			{
-				int32 EntityIndex = StartIndex + LocalIndex;
-				if (AEDU_CORE_MobileEntity* MobileEntity = MobileEntityArray[EntityIndex])
-				{
-					MobileEntity->ServerMobileBatchedCalc();
-				}
-			});//*/
-
-			/*/ Singe Core Sequential ServerMobileBatchedCalc
-			for (int32 EntityIndex = MobileBatchIndex; EntityIndex < ThisTickEndIndex; ++EntityIndex)
-			{
-				if (AEDU_CORE_MobileEntity* MobileEntity = MobileEntityArray[EntityIndex])
-				{
-					MobileEntity->ServerMobileBatchedCalc();
-				}
-			}//*/
-
-			// Update the batch index and last processing time to begin a new cycle
-			MobileEntityBatchIndex = ThisTickEndIndex;
-		}
+	FTickLaneContext LaneContext;
+	LaneContext.DeltaTime = DeltaTime;
+	LaneContext.AsyncDeltaTime = AsyncDeltaTime;
+	LaneContext.AsyncedClock = AsyncedClock;
+	LaneContext.CurrentBatchIndex = CurrentBatchIndex_10;
+	LaneContext.AsyncedClockDelta = AsyncDeltaTime / AsyncPhysicsFPS;
+	LaneContext.bUseBudgets = bUseTickLaneBudgets;
 
-		// If we've completed processing the entire array, reset the batch index to 0
-		if (MobileEntityBatchIndex >= MobileEntityArray.Num())
-		{
-			MobileEntityBatchIndex = 0;
-		}
+	SetRegistriesLocked(true);
+	for(const TUniquePtr<FTickLane>& Lane : TickLanes)
+	{
+		Lane->Tick(LaneContext);
+	}
+	SetRegistriesLocked(false);
 
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > SightComponentArray
+	// Server-Side Aggregated Tick > Line of Sight
+	//	<!> Traces everything the lanes requested this frame, the results are
+	//		delivered before the next frame's Exec.
 	//------------------------------------------------------------------------------
-		
-		// Define batch size
-		//  GEngine->AddOnScreenDebugMessage(14, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-		// 								 FString::Printf(TEXT("LastStatusComponentTime: %f"), LastStatusComponentTime));
-
-		// Define batch size
-		//  GEngine->AddOnScreenDebugMessage(13, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-		// 								 FString::Printf(TEXT("LastSightTime: %f"), LastSightTime));
-		
-		// If more than 1 second has passed since the last cycle, start a new batch cycle
-		if(AsyncedClock - LastSightComponentTime >= 1.f)
-		{
-			if (SightComponentBatchIndex == 0)
-			{
-				LastSightComponentTime = AsyncedClock;
-			}
-			constexpr int32 BatchSize = 20;
-	    		
-			// Calculate the end index for the current batch
-			const int32 ThisTickEndIndex = FMath::Min(SightComponentBatchIndex + BatchSize, SightComponentArray.Num());
-		        
-			// Parallel batch processing of ServerSightCalc
-			ParallelFor(ThisTickEndIndex - SightComponentBatchIndex, [this, DeltaTime, StartIndex = SightComponentBatchIndex](int32 LocalIndex)
-			{
-				int32 ComponentIndex = StartIndex + LocalIndex;
-				if (SightComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-		        {
-					if (USenseComponent* Component = SightComponentArray[ComponentIndex])
-					{
-						Component->ServerSightCalc(DeltaTime);
-					}
-				}
-			});
-
-			// Sequential batch processing of ServerSightExec
-			for (int32 ComponentIndex = SightComponentBatchIndex; ComponentIndex < ThisTickEndIndex; ++ComponentIndex)
-			{
-				if (USenseComponent* Component = SightComponentArray[ComponentIndex])
-				{
-	                    Component->ServerSightExec(DeltaTime);
-				}
-			}
-
-			// Update the batch index and last processing time to begin a new cycle
-			SightComponentBatchIndex = ThisTickEndIndex;
-		}
 
-		// If we've completed processing the entire array, reset the batch index to 0
-		if(SightComponentBatchIndex >= SightComponentArray.Num())
-		{
-		    SightComponentBatchIndex = 0;
-		}
-		
+	LineOfSightService.Flush(GetWorld());
 
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > StatusComponentArray
+	// Server-Side Aggregated Tick > Flow Fields
+	//	<!> Fields requested since the last frame are built here, and read by
+	//		the next frame's Calc.
 	//------------------------------------------------------------------------------
-	
-		// If more than 1 second has passed since the last cycle, start a new batch cycle
-		if(AsyncedClock - LastStatusComponentTime >= 1.0f)
-		    {
-	    		//  GEngine->AddOnScreenDebugMessage(13, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-				// 								 FString::Printf(TEXT("Tracing!")));
-	    		
-	    		if (StatusComponentBatchIndex == 0)
-	    		{
-	    			LastStatusComponentTime = AsyncedClock;
-	    		}
-			    constexpr int32 BatchSize = 20;
-	    		
-			    // Calculate the end index for the current batch
-		        const int32 ThisTickEndIndex = FMath::Min(StatusComponentBatchIndex + BatchSize, StatusComponentArray.Num());
-		        
-		        // Parallel batch processing of ServerStatusCalc
-		        ParallelFor(ThisTickEndIndex - StatusComponentBatchIndex, [this, DeltaTime, StartIndex = StatusComponentBatchIndex](int32 LocalIndex)
-		        {
-		            int32 ComponentIndex = StartIndex + LocalIndex;
-		            //if (StatusComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-		            //{
-		                if (UStatusComponent* Component = StatusComponentArray[ComponentIndex])
-		                {
-		                    Component->ServerStatusCalc(DeltaTime);
-		                }
-		           // }
-		        });
-
-		        // Sequential batch processing of ServerStatusExec
-		        for (int32 ComponentIndex = StatusComponentBatchIndex; ComponentIndex < ThisTickEndIndex; ++ComponentIndex)
-		        {
-		          //  if (StatusComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-		           // {
-		                if (UStatusComponent* Component = StatusComponentArray[ComponentIndex])
-		                {
-		                    Component->ServerStatusExec(DeltaTime);
-		                }
-		          //  }
-		        }
-
-		        // Update the batch index and last processing time to begin a new cycle
-		        StatusComponentBatchIndex = ThisTickEndIndex;
-		}
 
-		// If we've completed processing the entire array, reset the batch index to 0
-		if(StatusComponentBatchIndex >= StatusComponentArray.Num())
-		{
-		    StatusComponentBatchIndex = 0;
-		}
+	FlowFields.Flush();
 
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > EngagementComponentArray
+	// Server-Side Aggregated Tick > Sleep
+	//	<!> After the lanes and their callbacks, so no registry is iterated.
 	//------------------------------------------------------------------------------
+
+	ProcessSleepStateChanges();
 	
-		// If more than 1 second has passed since the last cycle, start a new batch cycle
-		if(AsyncedClock - LastEngagementComponentTime >= 2.5f)
-		    {
-	    		//  GEngine->AddOnScreenDebugMessage(13, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-				// 								 FString::Printf(TEXT("Tracing!")));
-	    		
-	    		if (EngagementComponentBatchIndex == 0)
-	    		{
-	    			LastEngagementComponentTime = AsyncedClock;
-	    		}
-			    constexpr int32 BatchSize = 20;
-	    		
-			    // Calculate the end index for the current batch
-		        const int32 ThisTickEndIndex = FMath::Min(EngagementComponentBatchIndex + BatchSize, EngagementComponentArray.Num());
-		        
-		        // Parallel batch processing of ServerEngagementCalc
-		        ParallelFor(ThisTickEndIndex - EngagementComponentBatchIndex, [this, DeltaTime, StartIndex = EngagementComponentBatchIndex](int32 LocalIndex)
-		        {
-		            int32 ComponentIndex = StartIndex + LocalIndex;
-		            //if (EngagementComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-		            //{
-		                if (UEngagementComponent* Component = EngagementComponentArray[ComponentIndex])
-		                {
-		                    Component->ServerEngagementComponentCalc(DeltaTime);
-		                }
-		           // }
-		        });
-
-		        // Sequential batch processing of ServerEngagementExec
-		        for (int32 ComponentIndex = EngagementComponentBatchIndex; ComponentIndex < ThisTickEndIndex; ++ComponentIndex)
-		        {
-		          //  if (EngagementComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-		           // {
-		                if (UEngagementComponent* Component = EngagementComponentArray[ComponentIndex])
-		                {
-		                    Component->ServerEngagementComponentExec(DeltaTime);
-		                }
-		          //  }
-		        }
-
-		        // Update the batch index and last processing time to begin a new cycle
-		        EngagementComponentBatchIndex = ThisTickEndIndex;
-		}
+	//------------------------------------------------------------------------------
+	// Debug
+	//	<!> Lane channels follow the Frame channel, in registration order.
+	//		Use the FrameTimes console command to see the percentiles.
+	//------------------------------------------------------------------------------
 
-		// If we've completed processing the entire array, reset the batch index to 0
-		if(EngagementComponentBatchIndex >= EngagementComponentArray.Num())
+	FrameTimeRecorder.Record(0, DeltaTime * 1000.f);
+	for(int32 LaneIndex = 0; LaneIndex < TickLanes.Num(); ++LaneIndex)
+	{
+		// Periodic and budgeted lanes skip frames, their 0ms would drag the percentiles down.
+		if(TickLanes[LaneIndex]->GetItemsThisFrame() > 0)
 		{
-		    EngagementComponentBatchIndex = 0;
+			FrameTimeRecorder.Record(LaneIndex + 1, TickLanes[LaneIndex]->GetLastFrameMs());
 		}
+	}
 	
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick > TurretComponentArray
+	// Reset all batch Indexes
 	//------------------------------------------------------------------------------
 
-		// Runs every Frame
-		ParallelFor(TurretComponentArray.Num(), [this](const int32 Index)
-		{
-			if(UTurretWeaponComponent* TurretComponent = TurretComponentArray[Index])  // Checking for validity only once
-			{
-				TurretComponent->ServerTurretCalc(AsyncDeltaTime);
-			}
-		});
-	
-		// Runs every 0.02 second (50FPS)
-		if (AsyncedClock - LastTurretComponentAnimationTime >= 0.02f)
-		{
-			LastTurretComponentAnimationTime = AsyncedClock;
+	// Original code
+	// CurrentBatchIndex = (CurrentBatchIndex < 10) ? (CurrentBatchIndex + 1) : 1;
 
-			// Sequential execution of ServerMobilesExec on each entity
-			for(UTurretWeaponComponent* TurretComponent : TurretComponentArray)
-			{
-				if (TurretComponent)
-				{
-					TurretComponent->ServerTurretExec(AsyncDeltaTime);
-				}
-			}
-		}
+	// Refactored version (faster)
+	CurrentBatchIndex_10 = (CurrentBatchIndex_10 % 10) + 1;
+	CurrentBatchIndex_100 = (CurrentBatchIndex_100 % 100) + 1;
+}
 
-		// If more than 1 second has passed since the last cycle, start a new batch cycle
-		if (AsyncedClock - LastTurretComponentEvaluationTime >= 1.f)
-		{
-			//  GEngine->AddOnScreenDebugMessage(13, GetWorld()->DeltaTimeSeconds, DeltaTimeDisplayColor, 
-			// 								 FString::Printf(TEXT("Tracing!")));
+void AEDU_CORE_GameMode::BeginPlay()
+{
+	Super::BeginPlay();
 
-			if (TurretComponentBatchIndex == 0)
-			{
-				LastTurretComponentEvaluationTime = AsyncedClock;
-			}
-			constexpr int32 BatchSize = 20;
+	InitiateArrays();
+	RegisterTickLanes();
 
-			// Calculate the end index for the current batch
-			const int32 ThisTickEndIndex = FMath::Min(TurretComponentBatchIndex + BatchSize,
-			                                          TurretComponentArray.Num());
+	SpatialGrid.SetCellSize(SpatialGridCellSize);
+	LineOfSightService.SetCacheSettings(LineOfSightCacheCellSize, LineOfSightCacheHeightBand, LineOfSightCacheTimeToLive);
+	BakeTerrainHeightfield();
+	BakeFlowFields();
 
-			// Parallel batch processing of ServerEngagementCalc
-			ParallelFor(ThisTickEndIndex - TurretComponentBatchIndex, [this, DeltaTime, StartIndex = TurretComponentBatchIndex](int32 LocalIndex)
-			{
-				int32 ComponentIndex = StartIndex + LocalIndex;
-				//if (TurretComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-				//{
-				if (UTurretWeaponComponent* Component = TurretComponentArray[ComponentIndex])
-				 {
-					Component->ServerTimeGatedTurretExec(DeltaTime);
-				 }
-				// }
-				});
-
-			// Sequential batch processing of ServerEngagementExec
-			for (int32 ComponentIndex = TurretComponentBatchIndex; ComponentIndex < ThisTickEndIndex; ++ComponentIndex)
-			{
-				//  if (TurretComponentArray.IsValidIndex(ComponentIndex)) // Ensure index validity
-				// {
-				if (UTurretWeaponComponent* Component = TurretComponentArray[ComponentIndex])
-				{
-					// Component->ServerTimeGatedTurretExec(DeltaTime);
-				}
-				//  }
-			}
+	if(bUsePathCache)
+	{
+		PathCache.Init(GetWorld(), PathCacheCapacity, PathCacheInvalidationMargin);
+	}
 
-			// Update the batch index and last processing time to begin a new cycle
-			TurretComponentBatchIndex = ThisTickEndIndex;
+	if(bUseFogOfWar)
+	{
+		if(!FogOfWar.Init(GetMapBounds(), FogOfWarCellSize, FogOfWarTargetHeight, &TerrainHeightfield))
+		{
+			FLOW_LOG_ERROR("Terrain bounds are empty or too large, Fog of War is disabled.")
 		}
+	}
+
+	FrameTimeRecorder.AddChannel(TEXT("Frame"));
+	for(const TUniquePtr<FTickLane>& Lane : TickLanes)
+	{
+		FrameTimeRecorder.AddChannel(Lane->GetSettings().Name);
+	}
+}
 
-		// If we've completed processing the entire array, reset the batch index to 0
-		if (TurretComponentBatchIndex >= TurretComponentArray.Num())
+void AEDU_CORE_GameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if(bDumpFrameTimesOnMatchEnd)
+	{
+		const FString FilePath = FPaths::ProfilingDir() / FString::Printf(TEXT("FrameTimes_%s.csv"), *FDateTime::Now().ToString());
+		if(FrameTimeRecorder.WriteCSV(FilePath))
 		{
-			TurretComponentBatchIndex = 0;
+			UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s::%hs - Frame times written to: %s"), *GetClass()->GetName(), __FUNCTION__, *FilePath);
 		}
-		
+		else
+		{
+			FLOW_LOG_ERROR("Failed to write frame times CSV")
+		}
+	}
+
+	// Unbinds from the NavSystem, which can outlive us.
+	PathCache.Reset();
+	
+	Super::EndPlay(EndPlayReason);
+}
+
+void AEDU_CORE_GameMode::AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector)
+{
+	AEDU_CORE_GameMode* This = CastChecked<AEDU_CORE_GameMode>(InThis);
+	
+	This->AbstractEntityRegistry.AddReferencedObjects(Collector);
+	This->PhysicsEntityRegistry.AddReferencedObjects(Collector);
+	This->MobileEntityRegistry.AddReferencedObjects(Collector);
+	This->SleepingMobileEntityRegistry.AddReferencedObjects(Collector);
+	This->SightComponentRegistry.AddReferencedObjects(Collector);
+	This->StatusComponentRegistry.AddReferencedObjects(Collector);
+	This->TurretComponentRegistry.AddReferencedObjects(Collector);
+	This->FixedWeaponComponentRegistry.AddReferencedObjects(Collector);
+	This->EngagementComponentRegistry.AddReferencedObjects(Collector);
+
+	This->TeamVisibility.AddReferencedObjects(Collector);
+	
+	Super::AddReferencedObjects(InThis, Collector);
+}
 
+void AEDU_CORE_GameMode::RegisterTickLanes()
+{ FLOW_LOG
+	/*------------------------------------------------------------------------------
+	  Periodic lanes are budgeted: BatchSize is only used until the lane has
+	  measured its own cost, after which it spends at most BudgetMs per frame
+	  and aims to complete a cycle within its Period. See EDU_CORE_TickLane.h
+	------------------------------------------------------------------------------*/
 	
 	//------------------------------------------------------------------------------
-	// Server-Side Aggregated Tick >FixedWeaponComponentArray
+	// AbstractEntityArray // Not in use.
 	//------------------------------------------------------------------------------
 	
-		// Sequential execution of FixedWeaponComponent on each entity
-		for(UFixedWeaponComponent* FixedWeaponComponent : FixedWeaponComponentArray)
-		{
-			if (FixedWeaponComponent)
-			{
-				FixedWeaponComponent->ServerFixedWeaponExec(AsyncDeltaTime);
-			}
-		}
-		
-		ParallelFor(FixedWeaponComponentArray.Num(), [this](const int32 Index)
-		{
-			if(UFixedWeaponComponent* FixedWeaponComponent = FixedWeaponComponentArray[Index])  // Checking for validity only once
-			{
-				FixedWeaponComponent->ServerFixedWeaponCalc(AsyncDeltaTime);
-			}
-		});
-		
-		// If more than 0.02 second has passed since the last cycle, start a new batch cycle
-		if (AsyncedClock - LastFixedWeaponComponentTime >= 0.02f)
-		{
-			LastFixedWeaponComponentTime = AsyncedClock;
+	//------------------------------------------------------------------------------
+	// PhysicsEntityArray: Every frame
+	//------------------------------------------------------------------------------
+	
+	RegisterTickLane({ TEXT("PhysicsEntity") }, PhysicsEntityRegistry,
+		&AEDU_CORE_PhysicsEntity::ServerPhysicsCalc, &AEDU_CORE_PhysicsEntity::ServerPhysicsExec);
 
-			// Sequential execution of ServerMobilesExec on each entity
-			for(UFixedWeaponComponent* FixedWeaponComponent : FixedWeaponComponentArray)
-			{
-				if (FixedWeaponComponent)
-				{
-					FixedWeaponComponent->ServerTimeGatedFixedWeaponExec(AsyncDeltaTime);
-				}
-			}
-		}
+	//------------------------------------------------------------------------------
+	// MobileEntityArray: Every frame, and 40 entities per frame every 0.75 second
+	//------------------------------------------------------------------------------
 	
+	RegisterTickLane({ TEXT("MobileEntity") }, MobileEntityRegistry,
+		&AEDU_CORE_MobileEntity::ServerMobileCalc, &AEDU_CORE_MobileEntity::ServerMobileExec);
+
+	RegisterTickLane({ TEXT("MobileEntityBatched"), 0.75f, 40, ETickLaneClock::Frame, 1.f }, MobileEntityRegistry,
+		&AEDU_CORE_MobileEntity::ServerMobileBatchedCalc, nullptr);
+
 	//------------------------------------------------------------------------------
-	// Reset all batch Indexes
+	// SleepingMobileEntityArray: 50 entities per frame every 0.5 second
 	//------------------------------------------------------------------------------
+	
+	RegisterTickLane({ TEXT("MobileEntitySleeping"), 0.5f, 50, ETickLaneClock::Frame, 0.25f }, SleepingMobileEntityRegistry,
+		nullptr, &AEDU_CORE_MobileEntity::ServerSleepingExec);
 
-	// Original code
-	// CurrentBatchIndex = (CurrentBatchIndex < 10) ? (CurrentBatchIndex + 1) : 1;
+	//------------------------------------------------------------------------------
+	// SightComponentArray: 20 components per frame every second
+	//------------------------------------------------------------------------------
+	
+	RegisterTickLane({ TEXT("SightComponent"), 1.f, 20, ETickLaneClock::Frame, 2.f }, SightComponentRegistry,
+		&USenseComponent::ServerSightCalc, &USenseComponent::ServerSightExec);
 
-	// Refactored version (faster)
-	CurrentBatchIndex_10 = (CurrentBatchIndex_10 % 10) + 1;
-	CurrentBatchIndex_100 = (CurrentBatchIndex_100 % 100) + 1;
-}
+	//------------------------------------------------------------------------------
+	// StatusComponentArray: 20 components per frame every second
+	//------------------------------------------------------------------------------
+	
+	RegisterTickLane({ TEXT("StatusComponent"), 1.f, 20, ETickLaneClock::Frame, 0.5f }, StatusComponentRegistry,
+		&UStatusComponent::ServerStatusCalc, &UStatusComponent::ServerStatusExec);
 
-void AEDU_CORE_GameMode::BeginPlay()
-{
-	Super::BeginPlay();
+	//------------------------------------------------------------------------------
+	// EngagementComponentArray: 20 components per frame every 2.5 seconds
+	//------------------------------------------------------------------------------
+	
+	RegisterTickLane({ TEXT("EngagementComponent"), 2.5f, 20, ETickLaneClock::Frame, 1.f }, EngagementComponentRegistry,
+		&UEngagementComponent::ServerEngagementComponentCalc, &UEngagementComponent::ServerEngagementComponentExec);
 
-	InitiateArrays();
+	//------------------------------------------------------------------------------
+	// TurretComponentArray
+	//	<!> ServerTimeGatedTurretExec defers its game thread work through AsyncTask,
+	//		so it runs in the parallel phase, there is no sequential phase.
+	//------------------------------------------------------------------------------
+	
+	// Alignment, every frame
+	RegisterTickLane({ TEXT("TurretComponent"), 0.f, 0, ETickLaneClock::Async }, TurretComponentRegistry,
+		&UTurretWeaponComponent::ServerTurretCalc, nullptr);
+
+	// Rotation, every 0.02 second (50FPS)
+	RegisterTickLane({ TEXT("TurretComponentAnimation"), 0.02f, 0, ETickLaneClock::Async }, TurretComponentRegistry,
+		nullptr, &UTurretWeaponComponent::ServerTurretExec);
+
+	// Target evaluation, 20 components per frame every second
+	RegisterTickLane({ TEXT("TurretComponentEvaluation"), 1.f, 20, ETickLaneClock::Frame, 1.f }, TurretComponentRegistry,
+		&UTurretWeaponComponent::ServerTimeGatedTurretExec, nullptr);
+
+	//------------------------------------------------------------------------------
+	// FixedWeaponComponentArray
+	//------------------------------------------------------------------------------
+	
+	// Every frame
+	RegisterTickLane({ TEXT("FixedWeaponComponent"), 0.f, 0, ETickLaneClock::Async }, FixedWeaponComponentRegistry,
+		&UFixedWeaponComponent::ServerFixedWeaponCalc, &UFixedWeaponComponent::ServerFixedWeaponExec);
+
+	// Target evaluation, every 0.02 second (50FPS)
+	RegisterTickLane({ TEXT("FixedWeaponComponentEvaluation"), 0.02f, 0, ETickLaneClock::Async }, FixedWeaponComponentRegistry,
+		nullptr, &UFixedWeaponComponent::ServerTimeGatedFixedWeaponExec);
 }
 
 //------------------------------------------------------------------------------
 // Public API > Aggregated Tick Arrays
 //------------------------------------------------------------------------------
 
-void AEDU_CORE_GameMode::AddToAbstractEntityArray(AEDU_CORE_AbstractEntity* AbstractEntity)
+FEntityHandle AEDU_CORE_GameMode::AddToAbstractEntityArray(AEDU_CORE_AbstractEntity* AbstractEntity)
 { FLOW_LOG
-	if (AbstractEntity)  // Check if the Entity is valid
-	{
-		// Add the entity to the TArray
-		AbstractEntityArray.Add(AbstractEntity); // Adds the pointer to the array
-		//UE_LOG(FLOWLOG_CATEGORY, Log, TEXT("Entity added: %s"), *AbstractEntity->GetName());
-	}
+	return AbstractEntityRegistry.Add(AbstractEntity);
 }
 
-void AEDU_CORE_GameMode::AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity)
+FEntityHandle AEDU_CORE_GameMode::AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity)
 { FLOW_LOG
-	   
-	if (PhysicsEntity)  // Check if the Entity is valid
-	{
-		// Add the entity to the TArray
-		PhysicsEntityArray.Add(PhysicsEntity); // Adds the pointer to the array
-		//UE_LOG(FLOWLOG_CATEGORY, Log, TEXT("Entity added: %s"), *PhysicsEntity->GetName());
-	}
+	return PhysicsEntityRegistry.Add(PhysicsEntity);
 }
 
-void AEDU_CORE_GameMode::AddToMobileEntityArray(AEDU_CORE_MobileEntity* MobileEntity)
+FEntityHandle AEDU_CORE_GameMode::AddToMobileEntityArray(AEDU_CORE_MobileEntity* MobileEntity)
 { FLOW_LOG
-	if(MobileEntity)  // Check if the entity is valid
+	const FEntityHandle Handle = MobileEntityRegistry.Add(MobileEntity);
+	
+	if(Handle.IsValid()) // Verify the entity was added or already exists
 	{
-		// Check if the entity is not already in the array and add it if unique
-		int32 Index = MobileEntityArray.AddUnique(MobileEntity);
-
-		if (Index != INDEX_NONE) // Verify the entity was added or already exists
+		/*------------------------------------------------------------------------------
+		  The BatchIndex is taken from the dense index when added. Swap-removes may
+		  move the entity later on, which only changes its place in the array, the
+		  BatchIndex is just there to spread the load, so we keep it.
+		------------------------------------------------------------------------------*/
+		const int32 Index = MobileEntityRegistry.GetDenseIndex(MobileEntity);
+		
+		// Calculate the BatchIndex based on Index size
+		if(Index < 100)
 		{
-			// Calculate the BatchIndex based on Index size
-			if(Index < 100)
-			{
-				 BatchIndex_10 = (Index / 10) + 1;
-			}
-			else
-			{
-				BatchIndex_10 = (Index / 100) + 1;
-			}
-			
-			// Call UpdateBatchIndex on the newly added entity, passing its BatchIndex rather than ArrayIndex
-			MobileEntity->UpdateBatchIndex(BatchIndex_10);
+			 BatchIndex_10 = (Index / 10) + 1;
+		}
+		else
+		{
+			BatchIndex_10 = (Index / 100) + 1;
 		}
+		
+		// Call UpdateBatchIndex on the newly added entity, passing its BatchIndex rather than ArrayIndex
+		MobileEntity->UpdateBatchIndex(BatchIndex_10);
 	}
+	return Handle;
 }
 
-void AEDU_CORE_GameMode::AddToSightComponentArray(USenseComponent* SightComponent)
+FEntityHandle AEDU_CORE_GameMode::AddToSightComponentArray(USenseComponent* SightComponent)
 { FLOW_LOG
-	if(SightComponent)  // Check if the entity is valid
-	{
-		// Check if the entity is not already in the array and add it if unique
-		int32 Index = SightComponentArray.AddUnique(SightComponent);
+	const FEntityHandle Handle = SightComponentRegistry.Add(SightComponent);
 
-		if (Index != INDEX_NONE) // Verify the entity was added or already exists
+	if(Handle.IsValid()) // Verify the entity was added or already exists
+	{
+		const int32 Index = SightComponentRegistry.GetDenseIndex(SightComponent);
+		
+		// Calculate the BatchIndex based on Index size
+		if(Index < 10) // <!> SightComponents Work a lot slower than other components. 
 		{
-			// Calculate the BatchIndex based on Index size
-			if(Index < 10) // <!> SightComponents Work a lot slower than other components. 
-			{
-				BatchIndex_100 = (Index / 1) + 1;
-			}
-			else
-			{
-				BatchIndex_100 = (Index / 10) + 1;
-			}
-			
-			// Call UpdateBatchIndex on the newly added entity, passing its BatchIndex rather than ArrayIndex
-			SightComponent->UpdateBatchIndex(BatchIndex_100);
+			BatchIndex_100 = (Index / 1) + 1;
+		}
+		else
+		{
+			BatchIndex_100 = (Index / 10) + 1;
 		}
+		
+		// Call UpdateBatchIndex on the newly added entity, passing its BatchIndex rather than ArrayIndex
+		SightComponent->UpdateBatchIndex(BatchIndex_100);
 	}
+	return Handle;
 }
 
-void AEDU_CORE_GameMode::AddToStatusComponentArray(UStatusComponent* StatusComponent)
+FEntityHandle AEDU_CORE_GameMode::AddToStatusComponentArray(UStatusComponent* StatusComponent)
 { FLOW_LOG
-	if(StatusComponent)  // Check if the entity is valid
-	{
-		StatusComponentArray.AddUnique(StatusComponent);
-	}
+	return StatusComponentRegistry.Add(StatusComponent);
 }
 
-void AEDU_CORE_GameMode::AddToEngagementComponentArray(UEngagementComponent* EngagementComponent)
+FEntityHandle AEDU_CORE_GameMode::AddToEngagementComponentArray(UEngagementComponent* EngagementComponent)
 { FLOW_LOG
-	if(EngagementComponent)  // Check if the entity is valid
-	{
-		EngagementComponentArray.AddUnique(EngagementComponent);
-	}
+	return EngagementComponentRegistry.Add(EngagementComponent);
 }
 
-void AEDU_CORE_GameMode::AddToTurretComponentArray(UTurretWeaponComponent* TurretComponent)
+FEntityHandle AEDU_CORE_GameMode::AddToTurretComponentArray(UTurretWeaponComponent* TurretComponent)
 { FLOW_LOG
-	if(TurretComponent)  // Check if the entity is valid
-	{
-		TurretComponentArray.AddUnique(TurretComponent);
-	}
+	return TurretComponentRegistry.Add(TurretComponent);
 }
 
-void AEDU_CORE_GameMode::AddToFixedWeaponComponentArray(UFixedWeaponComponent* FixedWeaponComponent)
+FEntityHandle AEDU_CORE_GameMode::AddToFixedWeaponComponentArray(UFixedWeaponComponent* FixedWeaponComponent)
 { FLOW_LOG
-	if(FixedWeaponComponent)  // Check if the entity is valid
+	return FixedWeaponComponentRegistry.Add(FixedWeaponComponent);
+}
+
+void AEDU_CORE_GameMode::SetRegistriesLocked(const bool bLocked)
+{ // FLOW_LOG
+	auto SetLocked = [bLocked](auto& Registry)
 	{
-		FixedWeaponComponentArray.AddUnique(FixedWeaponComponent);
-	}
+		bLocked ? Registry.Lock() : Registry.Unlock();
+	};
+
+	SetLocked(AbstractEntityRegistry);
+	SetLocked(PhysicsEntityRegistry);
+	SetLocked(MobileEntityRegistry);
+	SetLocked(SleepingMobileEntityRegistry);
+	SetLocked(SightComponentRegistry);
+	SetLocked(StatusComponentRegistry);
+	SetLocked(TurretComponentRegistry);
+	SetLocked(FixedWeaponComponentRegistry);
+	SetLocked(EngagementComponentRegistry);
+}
+
+void AEDU_CORE_GameMode::RemoveFromAbstractEntityArray(const AEDU_CORE_AbstractEntity* AbstractEntity)
+{ FLOW_LOG
+	AbstractEntityRegistry.Remove(AbstractEntity);
+}
+
+void AEDU_CORE_GameMode::RemoveFromPhysicsEntityArray(const AEDU_CORE_PhysicsEntity* PhysicsEntity)
+{ FLOW_LOG
+	PhysicsEntityRegistry.Remove(PhysicsEntity);
+}
+
+void AEDU_CORE_GameMode::RemoveFromMobileEntityArray(const AEDU_CORE_MobileEntity* MobileEntity)
+{ FLOW_LOG
+	MobileEntityRegistry.Remove(MobileEntity);
+	SleepingMobileEntityRegistry.Remove(MobileEntity);
+}
+
+void AEDU_CORE_GameMode::RemoveFromSightComponentArray(const USenseComponent* SightComponent)
+{ FLOW_LOG
+	SightComponentRegistry.Remove(SightComponent);
+}
+
+void AEDU_CORE_GameMode::RemoveFromStatusComponentArray(const UStatusComponent* StatusComponent)
+{ FLOW_LOG
+	StatusComponentRegistry.Remove(StatusComponent);
+}
+
+void AEDU_CORE_GameMode::RemoveFromEngagementComponentArray(const UEngagementComponent* EngagementComponent)
+{ FLOW_LOG
+	EngagementComponentRegistry.Remove(EngagementComponent);
+}
+
+void AEDU_CORE_GameMode::RemoveFromTurretComponentArray(const UTurretWeaponComponent* TurretComponent)
+{ FLOW_LOG
+	TurretComponentRegistry.Remove(TurretComponent);
+}
+
+void AEDU_CORE_GameMode::RemoveFromFixedWeaponComponentArray(const UFixedWeaponComponent* FixedWeaponComponent)
+{ FLOW_LOG
+	FixedWeaponComponentRegistry.Remove(FixedWeaponComponent);
 }
 
 //------------------------------------------------------------------------------
@@ -663,6 +517,8 @@ void AEDU_CORE_GameMode::AddActorToTeamArray(AActor* Actor, EEDU_CORE_Team TeamA
 		}
 	}
 	
+	TeamVisibility.SetTeam(Actor, TeamArray);
+
 	// Log successful addition
 	UE_LOG(LogTemp, Log, TEXT("Added actor %s to team %d"), *Actor->GetName(), static_cast<int32>(TeamArray));
 }
@@ -687,59 +543,176 @@ void AEDU_CORE_GameMode::RemoveActorFromTeamArray(AActor* Actor, EEDU_CORE_Team
 			
 		default: ;
 		}
+
+		if(TeamVisibility.GetTeam(Actor) == TeamArray)
+		{
+			TeamVisibility.SetTeam(Actor, EEDU_CORE_Team::Max);
+		}
 	}
 }
 
 void AEDU_CORE_GameMode::AddActorToTeamVisibleActorsArray(AActor* Actor, EEDU_CORE_Team TeamArray)
-{ FLOW_LOG
+{ // FLOW_LOG
 	if (!HasAuthority()) return;
 	
-	if (Actor)
+	TeamVisibility.SetVisible(Actor, TeamArray);
+}
+
+void AEDU_CORE_GameMode::RemoveActorFromTeamVisibleActorsArray(AActor* Actor, EEDU_CORE_Team TeamArray)
+{ // FLOW_LOG
+	TeamVisibility.SetHidden(Actor, TeamArray);
+}
+
+void AEDU_CORE_GameMode::RemoveActorFromAllVisibilityArrays(AActor* Actor)
+{ FLOW_LOG
+	TeamVisibility.RemoveActor(Actor);
+}
+
+void AEDU_CORE_GameMode::QueryEntitiesInRadius(const FVector& Center, const float Radius, const EEDU_CORE_Team TeamArray, const ETeamQueryFilter Filter, const ECollisionChannel ObjectType, TArray<AActor*>& OutActors) const
+{ // FLOW_LOG
+	const int32 FirstResult = OutActors.Num();
+	SpatialGrid.QueryRadius(Center, Radius, GetQueryTeamMask(TeamArray, Filter), OutActors, ECC_TO_BITFIELD(ObjectType));
+	RemoveIgnoredQueryResults(FirstResult, TeamArray, Filter, OutActors);
+}
+
+FTeamVisibility::FTeamMask AEDU_CORE_GameMode::GetQueryTeamMask(const EEDU_CORE_Team TeamArray, const ETeamQueryFilter Filter)
+{
+	constexpr FTeamVisibility::FTeamMask AllTeams = (1u << FTeamVisibility::NumTeams) - 1;
+
+	// Friendly buckets are skipped entirely, rather than filtered.
+	if(EnumHasAnyFlags(Filter, ETeamQueryFilter::Friendly) && FTeamVisibility::IsValidTeam(TeamArray))
 	{
-		switch(TeamArray)
+		return AllTeams & ~FTeamVisibility::GetTeamBit(TeamArray);
+	}
+	return AllTeams;
+}
+
+void AEDU_CORE_GameMode::RemoveIgnoredQueryResults(const int32 FirstResult, const EEDU_CORE_Team TeamArray, const ETeamQueryFilter Filter, TArray<AActor*>& OutActors) const
+{
+	if(!EnumHasAnyFlags(Filter, ETeamQueryFilter::Visible | ETeamQueryFilter::Hidden)) return;
+
+	for(int32 Index = OutActors.Num() - 1; Index >= FirstResult; --Index)
+	{
+		if(TeamVisibility.ShouldIgnore(OutActors[Index], TeamArray, Filter))
 		{
-			case EEDU_CORE_Team::None:		VisibilityStruct.Team_0_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_0_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_1:	VisibilityStruct.Team_1_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_1_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_2:	VisibilityStruct.Team_2_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_2_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_3:	VisibilityStruct.Team_3_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_3_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_4:	VisibilityStruct.Team_4_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_4_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_5:	VisibilityStruct.Team_5_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_5_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_6:	VisibilityStruct.Team_6_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_6_HiddenActors.RemoveSingle(Actor);		break;
-			case EEDU_CORE_Team::Team_7:	VisibilityStruct.Team_7_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_7_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_8:	VisibilityStruct.Team_8_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_8_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_9:	VisibilityStruct.Team_9_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_9_HiddenActors.RemoveSingleSwap(Actor);	break;
-			case EEDU_CORE_Team::Team_10:	VisibilityStruct.Team_10_VisibleActors.AddUnique(Actor); VisibilityStruct.Team_10_HiddenActors.RemoveSingleSwap(Actor);	break;
-			
-		default: ;
+			OutActors.RemoveAtSwap(Index, 1, EAllowShrinking::No);
 		}
 	}
+}
+
+void AEDU_CORE_GameMode::BakeTerrainHeightfield()
+{ FLOW_LOG
+	if(!bBakeTerrainHeightfield) return;
+
+	TerrainHeightfield.SetClearance(TerrainClearance);
+	if(!TerrainHeightfield.Bake(GetWorld(), GetMapBounds(), TerrainCellSize, bTerrainIncludesStaticMeshes))
+	{
+		FLOW_LOG_ERROR("Terrain bounds are empty or too large, LOS will trace everything.")
+		return;
+	}
 
-	UE_LOG(FLOWLOG_CATEGORY, Warning, TEXT("Server: Added actor %s to team %d Visible Actors Array."), *Actor->GetName(), static_cast<int32>(TeamArray));
+	LineOfSightService.SetTerrain(&TerrainHeightfield, bTerrainOnlyLineOfSight);
+	UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s::%hs - Terrain heightfield baked, %d x %d cells."), *GetClass()->GetName(), __FUNCTION__, TerrainHeightfield.GetSizeX(), TerrainHeightfield.GetSizeY());
 }
 
-void AEDU_CORE_GameMode::RemoveActorFromTeamVisibleActorsArray(AActor* Actor, EEDU_CORE_Team TeamArray)
+void AEDU_CORE_GameMode::BakeFlowFields()
 { FLOW_LOG
-	if (Actor)
+	if(!bUseFlowFields) return;
+
+	if(!FlowFields.Bake(GetWorld(), GetMapBounds(), FlowFieldCellSize, FlowFieldMaxSlope))
 	{
-		switch(TeamArray)
+		FLOW_LOG_ERROR("No flow field cost grid, either no navmesh in the map bounds or too many cells. Groups will path on their own.")
+		return;
+	}
+
+	UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s::%hs - Flow field cost grid baked, %d x %d cells."), *GetClass()->GetName(), __FUNCTION__, FlowFields.GetSizeX(), FlowFields.GetSizeY());
+}
+
+FBox AEDU_CORE_GameMode::GetMapBounds() const
+{ FLOW_LOG
+	if(TerrainBounds.IsValid) return TerrainBounds;
+
+	FLOW_LOG_WARNING("TerrainBounds is not set, falling back to the level bounds.")
+	return ALevelBounds::CalculateLevelBounds(GetWorld()->PersistentLevel);
+}
+
+void AEDU_CORE_GameMode::UpdateSpatialGrid()
+{ // FLOW_LOG
+	SpatialGrid.Reset();
+
+	for(const TObjectPtr<UStatusComponent>& StatusComponent : StatusComponentRegistry.GetDense())
+	{
+		if(AActor* Entity = StatusComponent->GetOwner())
 		{
-			case EEDU_CORE_Team::None:		VisibilityStruct.Team_0_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_0_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_1:	VisibilityStruct.Team_1_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_1_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_2:	VisibilityStruct.Team_2_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_2_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_3:	VisibilityStruct.Team_3_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_3_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_4:	VisibilityStruct.Team_4_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_4_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_5:	VisibilityStruct.Team_5_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_5_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_6:	VisibilityStruct.Team_6_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_6_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_7:	VisibilityStruct.Team_7_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_7_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_8:	VisibilityStruct.Team_8_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_8_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_9:	VisibilityStruct.Team_9_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_9_HiddenActors.AddUnique(Actor);		break;
-			case EEDU_CORE_Team::Team_10:	VisibilityStruct.Team_10_VisibleActors.RemoveSingleSwap(Actor); VisibilityStruct.Team_10_HiddenActors.AddUnique(Actor);		break;
+			const UPrimitiveComponent* Root = Cast<UPrimitiveComponent>(Entity->GetRootComponent());
+			const ECollisionChannel ObjectType = Root ? Root->GetCollisionObjectType() : ECC_MAX;
 			
-		default: ;
+			SpatialGrid.Add(Entity, Entity->GetActorLocation(), StatusComponent->GetActiveTeam(), ObjectType);
 		}
 	}
 }
 
+void AEDU_CORE_GameMode::ScheduleVisibilityExpiry(UStatusComponent* StatusComponent, const EEDU_CORE_Team TeamArray, const float DueAt)
+{ // FLOW_LOG
+	VisibilityExpiryQueue.HeapPush({ DueAt, StatusComponent, TeamArray });
+}
+
+void AEDU_CORE_GameMode::ProcessVisibilityExpiry()
+{ // FLOW_LOG
+	while(VisibilityExpiryQueue.Num() > 0 && VisibilityExpiryQueue.HeapTop().DueAt <= AsyncedClock)
+	{
+		FVisibilityExpiry Expiry;
+		VisibilityExpiryQueue.HeapPop(Expiry, EAllowShrinking::No);
+
+		UStatusComponent* StatusComponent = Expiry.StatusComponent.Get();
+		if(!StatusComponent) continue;
+
+		// Seen again, or only forgotten so far, come back later.
+		const float NextDueAt = StatusComponent->UpdateVisibilityExpiry(Expiry.Team, AsyncedClock);
+		if(NextDueAt >= 0.f)
+		{
+			VisibilityExpiryQueue.HeapPush({ FMath::Max(NextDueAt, AsyncedClock + UE_KINDA_SMALL_NUMBER), Expiry.StatusComponent, Expiry.Team });
+		}
+	}
+}
+
+void AEDU_CORE_GameMode::RequestSleepStateChange(AEDU_CORE_MobileEntity* MobileEntity)
+{ // FLOW_LOG
+	PendingSleepStateChanges.AddUnique(MobileEntity);
+}
+
+void AEDU_CORE_GameMode::ProcessSleepStateChanges()
+{ // FLOW_LOG
+	for(const TWeakObjectPtr<AEDU_CORE_MobileEntity>& WeakMobileEntity : PendingSleepStateChanges)
+	{
+		AEDU_CORE_MobileEntity* MobileEntity = WeakMobileEntity.Get();
+		if(!MobileEntity || MobileEntity->IsActorBeingDestroyed()) continue;
+
+		// Requests that were undone before we got here fail the Remove and do nothing.
+		if(MobileEntity->IsServerSleeping())
+		{
+			if(MobileEntityRegistry.Remove(MobileEntity))
+			{
+				PhysicsEntityRegistry.Remove(MobileEntity);
+				SleepingMobileEntityRegistry.Add(MobileEntity);
+
+				// The last transform was already sent, see AEDU_CORE_PhysicsEntity::ServerPhysicsExec
+				MobileEntity->SetNetDormancy(DORM_DormantAll);
+			}
+		}
+		else if(SleepingMobileEntityRegistry.Remove(MobileEntity))
+		{
+			AddToMobileEntityArray(MobileEntity);
+			if(!MobileEntity->bEnableClientIndependentPhysics)
+			{
+				AddToPhysicsEntityArray(MobileEntity);
+			}
+			MobileEntity->SetNetDormancy(DORM_Awake);
+		}
+	}
+	PendingSleepStateChanges.Reset();
+}
+
 TArray<AActor*>& AEDU_CORE_GameMode::GetTeamArray(EEDU_CORE_Team TeamArray)
 {
 	switch(TeamArray)
@@ -766,50 +739,28 @@ TArray<AActor*>& AEDU_CORE_GameMode::GetTeamArray(EEDU_CORE_Team TeamArray)
 
 TArray<AActor*>& AEDU_CORE_GameMode::GetTeamVisibleActorsArray(EEDU_CORE_Team TeamArray)
 {
-	switch(TeamArray)
+	if(FTeamVisibility::IsValidTeam(TeamArray))
 	{
-		case EEDU_CORE_Team::None:	 return VisibilityStruct.Team_0_VisibleActors;
-		case EEDU_CORE_Team::Team_1: return VisibilityStruct.Team_1_VisibleActors;
-		case EEDU_CORE_Team::Team_2: return VisibilityStruct.Team_2_VisibleActors;
-		case EEDU_CORE_Team::Team_3: return VisibilityStruct.Team_3_VisibleActors;
-		case EEDU_CORE_Team::Team_4: return VisibilityStruct.Team_4_VisibleActors;
-		case EEDU_CORE_Team::Team_5: return VisibilityStruct.Team_5_VisibleActors;
-		case EEDU_CORE_Team::Team_6: return VisibilityStruct.Team_6_VisibleActors;
-		case EEDU_CORE_Team::Team_7: return VisibilityStruct.Team_7_VisibleActors;
-		case EEDU_CORE_Team::Team_8: return VisibilityStruct.Team_8_VisibleActors;
-		case EEDU_CORE_Team::Team_9: return VisibilityStruct.Team_9_VisibleActors;
-		case EEDU_CORE_Team::Team_10: return VisibilityStruct.Team_10_VisibleActors;
-
-	default:
-		// Static empty array to return as a fallback
-			static TArray<AActor*> EmptyArray;
-		UE_LOG(LogTemp, Warning, TEXT("Invalid TeamArray enum value"));
-		return EmptyArray;
+		return TeamVisibility.GetVisible(TeamArray).GetActors();
 	}
+	
+	// Static empty array to return as a fallback
+	static TArray<AActor*> EmptyArray;
+	UE_LOG(LogTemp, Warning, TEXT("Invalid TeamArray enum value"));
+	return EmptyArray;
 }
 
 TArray<AActor*>& AEDU_CORE_GameMode::GetTeamHiddenActorsArray(EEDU_CORE_Team TeamArray)
 {
-	switch(TeamArray)
+	if(FTeamVisibility::IsValidTeam(TeamArray))
 	{
-	case EEDU_CORE_Team::None:	 return VisibilityStruct.Team_0_HiddenActors;
-	case EEDU_CORE_Team::Team_1: return VisibilityStruct.Team_1_HiddenActors;
-	case EEDU_CORE_Team::Team_2: return VisibilityStruct.Team_2_HiddenActors;
-	case EEDU_CORE_Team::Team_3: return VisibilityStruct.Team_3_HiddenActors;
-	case EEDU_CORE_Team::Team_4: return VisibilityStruct.Team_4_HiddenActors;
-	case EEDU_CORE_Team::Team_5: return VisibilityStruct.Team_5_HiddenActors;
-	case EEDU_CORE_Team::Team_6: return VisibilityStruct.Team_6_HiddenActors;
-	case EEDU_CORE_Team::Team_7: return VisibilityStruct.Team_7_HiddenActors;
-	case EEDU_CORE_Team::Team_8: return VisibilityStruct.Team_8_HiddenActors;
-	case EEDU_CORE_Team::Team_9: return VisibilityStruct.Team_9_HiddenActors;
-	case EEDU_CORE_Team::Team_10: return VisibilityStruct.Team_10_HiddenActors;
-
-	default:
-		// Static empty array to return as a fallback
-			static TArray<AActor*> EmptyArray;
-		UE_LOG(LogTemp, Warning, TEXT("Invalid TeamArray enum value"));
-		return EmptyArray;
+		return TeamVisibility.GetHidden(TeamArray).GetActors();
 	}
+	
+	// Static empty array to return as a fallback
+	static TArray<AActor*> EmptyArray;
+	UE_LOG(LogTemp, Warning, TEXT("Invalid TeamArray enum value"));
+	return EmptyArray;
 }
 
 //------------------------------------------------------------------------------
@@ -822,6 +773,11 @@ void AEDU_CORE_GameMode::AddToGuidActorMap(FGuid GUID,AActor* Actor)
 	//UE_LOG(FLOWLOG_CATEGORY, Log, TEXT("Entity added: %s"), *Actor->GetName());
 }
 
+void AEDU_CORE_GameMode::RemoveFromGuidActorMap(FGuid GUID)
+{ FLOW_LOG
+	GuidActorMap.Remove(GUID);
+}
+
 TObjectPtr<AActor> AEDU_CORE_GameMode::FindActorInMap(FGuid GUID) const
 { FLOW_LOG
 	if(TObjectPtr<AActor> Actor = GuidActorMap.FindRef(GUID))
@@ -909,3 +865,21 @@ void AEDU_CORE_GameMode::ChangeTeamCommand(const int32 InTeam) const
 		FLOW_LOG_ERROR("Cast to Camera failed?")
 	}
 }
+
+void AEDU_CORE_GameMode::FrameTimes() const
+{
+	UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("Frame times (ms) over the last %u frames, Asynced Clock: %f"), FFrameTimeRecorder::Capacity, AsyncedClock);
+	
+	for(int32 Channel = 0; Channel < FrameTimeRecorder.GetNumChannels(); ++Channel)
+	{
+		const FFrameTimeRecorder::FSummary Summary = FrameTimeRecorder.GetSummary(Channel);
+		const FString Line = FString::Printf(TEXT("%-32s p50: %7.3f  p95: %7.3f  p99: %7.3f  max: %7.3f"),
+			*FrameTimeRecorder.GetChannelName(Channel).ToString(), Summary.P50, Summary.P95, Summary.P99, Summary.Max);
+		
+		UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s"), *Line);
+		if(GEngine)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Cyan, Line);
+		}
+	}
+}
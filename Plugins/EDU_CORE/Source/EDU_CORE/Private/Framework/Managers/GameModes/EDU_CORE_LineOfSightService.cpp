@@ -0,0 +1,341 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_LineOfSightService.h"
+
+// CORE
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TerrainHeightfield.h"
+
+// UE
+#include "Algo/Count.h"
+#include "Engine/World.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("LineOfSight Requested Traces"), STAT_EDU_LineOfSightRequested, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LineOfSight Unique Traces"), STAT_EDU_LineOfSightUnique, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LineOfSight Cached Traces"), STAT_EDU_LineOfSightCached, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LineOfSight Cache Entries"), STAT_EDU_LineOfSightCacheEntries, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("LineOfSight Terrain Traces"), STAT_EDU_LineOfSightTerrain, STATGROUP_EDU_TickLanes);
+
+//------------------------------------------------------------------------------
+// Requests
+//------------------------------------------------------------------------------
+
+void FLineOfSightService::RequestFirstVisible(const UObject* Requester, const AActor* Observer, const ECollisionChannel Channel, const float AcceptRadius,
+	TArray<FLineOfSightTarget>&& Targets, FFirstVisibleCallback&& Callback)
+{
+	if(Targets.Num() == 0) return;
+
+	FRequest Request;
+	Request.Requester = Requester;
+	Request.AcceptRadius = AcceptRadius;
+	Request.Callback = MoveTemp(Callback);
+	Request.Targets.Reserve(Targets.Num());
+
+	FScopeLock ScopeLock(&RequestLock);
+
+	const bool bUseCache = CacheTimeToLive > 0.f;
+
+	for(const FLineOfSightTarget& Target : Targets)
+	{
+		FRequestTarget& RequestTarget = Request.Targets.AddDefaulted_GetRef();
+		RequestTarget.Location = Target.End;
+		RequestTarget.CacheKey = { GetCacheCell(Target.Start), GetCacheCell(Target.End), Channel, Target.Target, AcceptRadius > 0.f };
+
+		if(bUseCache)
+		{
+			const FCacheEntry* Entry = FindCacheEntry(RequestTarget.CacheKey);
+			if(Entry && Entry->ExpireTime > CurrentTime)
+			{
+				RequestTarget.bCachedLineOfSight = Entry->bHasLineOfSight;
+				++CachedTraces;
+
+				// Targets are in priority order, nothing after this one can win.
+				if(Entry->bHasLineOfSight) break;
+				continue;
+			}
+		}
+
+		const FTraceKey Key { Observer, Target.Target, Channel, QuantizeTracePoint(Target.Start), QuantizeTracePoint(Target.End) };
+
+		// Requests for the same line share the first one's trace.
+		int32& TraceIndex = TraceLookup.FindOrAdd(Key, INDEX_NONE);
+		if(TraceIndex == INDEX_NONE)
+		{
+			TraceIndex = Traces.Add({ Key, Target.Start, Target.End });
+		}
+
+		RequestTarget.TraceIndex = TraceIndex;
+		++RequestedTraces;
+	}
+
+	Requests.Add(MoveTemp(Request));
+}
+
+void FLineOfSightService::RequestLineOfSight(const UObject* Requester, const AActor* Observer, const ECollisionChannel Channel, const float AcceptRadius,
+	const FLineOfSightTarget& Target, TFunction<void(bool bHasLineOfSight)>&& Callback)
+{
+	RequestFirstVisible(Requester, Observer, Channel, AcceptRadius, { Target },
+		[Callback = MoveTemp(Callback)](const int32 FirstVisibleIndex)
+		{
+			Callback(FirstVisibleIndex != INDEX_NONE);
+		});
+}
+
+//------------------------------------------------------------------------------
+// Cache
+//------------------------------------------------------------------------------
+
+void FLineOfSightService::SetCacheSettings(const float NewCellSize, const float NewHeightBand, const float NewTimeToLive)
+{
+	check(IsInGameThread());
+	FScopeLock ScopeLock(&RequestLock);
+
+	CacheCellSize = FMath::Max(NewCellSize, 100.f);
+	InvCacheCellSize = 1.f / CacheCellSize;
+	CacheHeightBand = FMath::Max(NewHeightBand, 50.f);
+	InvCacheHeightBand = 1.f / CacheHeightBand;
+	CacheTimeToLive = FMath::Max(NewTimeToLive, 0.f);
+
+	// Cell coordinates depend on the sizes, so the old answers are useless.
+	ResetCache();
+}
+
+void FLineOfSightService::InvalidateArea(const FVector& Center, const float Radius)
+{
+	FScopeLock ScopeLock(&RequestLock);
+	if(NumCacheEntries == 0) return;
+
+	PendingInvalidations.Emplace(Center, Radius);
+}
+
+const FLineOfSightService::FCacheEntry* FLineOfSightService::FindCacheEntry(const FCacheKey& Key) const
+{
+	const FCacheBucket* Bucket = Cache.Find(GetCacheBucket(Key));
+	return Bucket ? Bucket->Entries.Find(Key) : nullptr;
+}
+
+void FLineOfSightService::AddCacheEntry(const FCacheKey& Key, const FCacheEntry& Entry)
+{
+	FCacheBucket& Bucket = Cache.FindOrAdd(GetCacheBucket(Key));
+
+	const int32 PreviousNum = Bucket.Entries.Num();
+	Bucket.Entries.Add(Key, Entry);
+	NumCacheEntries += Bucket.Entries.Num() - PreviousNum;
+
+	Bucket.LineBounds += GetCacheCellCenter(Key.ObserverCell);
+	Bucket.LineBounds += GetCacheCellCenter(Key.TargetCell);
+	Bucket.LatestExpireTime = FMath::Max(Bucket.LatestExpireTime, Entry.ExpireTime);
+}
+
+void FLineOfSightService::ResetCache()
+{
+	Cache.Reset();
+	NumCacheEntries = 0;
+	PendingInvalidations.Reset();
+}
+
+void FLineOfSightService::PurgeCache()
+{
+	const bool bPurgeExpired = CurrentTime >= NextPurgeTime;
+	if(!bPurgeExpired && PendingInvalidations.Num() == 0) return;
+
+	// Answers are stored per cell, so the area grows by a cell to cover every line inside them.
+	const float CellMargin = CacheCellSize + CacheHeightBand;
+
+	TArray<FSphere, TInlineAllocator<8>> BucketAreas;
+
+	for(TMap<FIntPoint, FCacheBucket>::TIterator BucketIt = Cache.CreateIterator(); BucketIt; ++BucketIt)
+	{
+		FCacheBucket& Bucket = BucketIt.Value();
+
+		// Nothing in the bucket is fresh, no need to look at the entries.
+		if(Bucket.LatestExpireTime <= CurrentTime)
+		{
+			NumCacheEntries -= Bucket.Entries.Num();
+			BucketIt.RemoveCurrent();
+			continue;
+		}
+
+		BucketAreas.Reset();
+		for(const FSphere& Area : PendingInvalidations)
+		{
+			if(Bucket.LineBounds.ComputeSquaredDistanceToPoint(Area.Center) <= FMath::Square(Area.W + CellMargin))
+			{
+				BucketAreas.Add(Area);
+			}
+		}
+
+		if(BucketAreas.Num() == 0 && !bPurgeExpired) continue;
+
+		for(TMap<FCacheKey, FCacheEntry>::TIterator It = Bucket.Entries.CreateIterator(); It; ++It)
+		{
+			if(It.Value().ExpireTime <= CurrentTime)
+			{
+				It.RemoveCurrent();
+				--NumCacheEntries;
+				continue;
+			}
+
+			const FVector LineStart = GetCacheCellCenter(It.Key().ObserverCell);
+			const FVector LineEnd = GetCacheCellCenter(It.Key().TargetCell);
+
+			for(const FSphere& Area : BucketAreas)
+			{
+				if(FMath::PointDistToSegmentSquared(Area.Center, LineStart, LineEnd) <= FMath::Square(Area.W + CellMargin))
+				{
+					It.RemoveCurrent();
+					--NumCacheEntries;
+					break;
+				}
+			}
+		}
+
+		if(Bucket.Entries.Num() == 0)
+		{
+			BucketIt.RemoveCurrent();
+		}
+	}
+
+	PendingInvalidations.Reset();
+	if(bPurgeExpired)
+	{
+		NextPurgeTime = CurrentTime + CacheTimeToLive;
+	}
+}
+
+void FLineOfSightService::SetTerrain(const FTerrainHeightfield* NewTerrain, const bool bNewTerrainOnly)
+{
+	check(IsInGameThread());
+	FScopeLock ScopeLock(&RequestLock);
+
+	Terrain = NewTerrain;
+	bTerrainOnly = bNewTerrainOnly;
+
+	// Answers traced against a different terrain are useless.
+	ResetCache();
+}
+
+//------------------------------------------------------------------------------
+// Flush
+//------------------------------------------------------------------------------
+
+void FLineOfSightService::Flush(const UWorld* World)
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(TEXT("LineOfSight Flush"), EDU_TickLaneChannel);
+
+	// Take the batch, callbacks may request again for the next Flush.
+	TArray<FTrace> BatchTraces;
+	TArray<FRequest> BatchRequests;
+	{
+		FScopeLock ScopeLock(&RequestLock);
+		BatchTraces = MoveTemp(Traces);
+		BatchRequests = MoveTemp(Requests);
+		TraceLookup.Reset();
+
+		LastRequestedTraces = RequestedTraces + CachedTraces;
+		LastUniqueTraces = BatchTraces.Num();
+		LastCachedTraces = CachedTraces;
+		RequestedTraces = 0;
+		CachedTraces = 0;
+	}
+
+	SET_DWORD_STAT(STAT_EDU_LineOfSightRequested, LastRequestedTraces);
+	SET_DWORD_STAT(STAT_EDU_LineOfSightUnique, LastUniqueTraces);
+	SET_DWORD_STAT(STAT_EDU_LineOfSightCached, LastCachedTraces);
+	SET_DWORD_STAT(STAT_EDU_LineOfSightCacheEntries, NumCacheEntries);
+
+	if(!World) return;
+
+	const FTerrainHeightfield* BatchTerrain = Terrain && Terrain->IsValid() ? Terrain : nullptr;
+	const bool bBatchTerrainOnly = bTerrainOnly;
+
+	// Scene queries are read only, so every unique pair can be traced in parallel.
+	ParallelFor(TEXT("LineOfSight Traces"), BatchTraces.Num(), 8, [World, &BatchTraces, BatchTerrain, bBatchTerrainOnly](const int32 Index)
+	{
+		FTrace& Trace = BatchTraces[Index];
+
+		// Terrain first, most lines on our maps are blocked by hills, not by entities.
+		if(BatchTerrain)
+		{
+			Trace.bAnsweredByTerrain = true;
+			if(BatchTerrain->IsBlocked(Trace.Start, Trace.End, &Trace.ImpactPoint))
+			{
+				Trace.bHit = true;
+				return;
+			}
+			if(bBatchTerrainOnly)
+			{
+				Trace.bHit = true;
+				Trace.HitActor = Trace.Key.Target;
+				Trace.ImpactPoint = Trace.End;
+				return;
+			}
+			Trace.bAnsweredByTerrain = false;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(EDU_LineOfSight), false, Trace.Key.Observer);
+
+		FHitResult HitResult;
+		Trace.bHit = World->LineTraceSingleByChannel(HitResult, Trace.Start, Trace.End, Trace.Key.Channel, QueryParams);
+		Trace.HitActor = HitResult.GetActor();
+		Trace.ImpactPoint = HitResult.ImpactPoint;
+	});
+
+	LastTerrainTraces = Algo::CountIf(BatchTraces, [](const FTrace& Trace) { return Trace.bAnsweredByTerrain; });
+	SET_DWORD_STAT(STAT_EDU_LineOfSightTerrain, LastTerrainTraces);
+
+	// Resolve every request, and cache the new answers.
+	{
+		FScopeLock ScopeLock(&RequestLock);
+
+		CurrentTime = World->GetTimeSeconds();
+		PurgeCache();
+
+		const double ExpireTime = CurrentTime + CacheTimeToLive;
+		const bool bUseCache = CacheTimeToLive > 0.f;
+
+		for(FRequest& Request : BatchRequests)
+		{
+			const float AcceptRadiusSquared = FMath::Square(Request.AcceptRadius);
+
+			for(int32 TargetIndex = 0; TargetIndex < Request.Targets.Num(); ++TargetIndex)
+			{
+				const FRequestTarget& RequestTarget = Request.Targets[TargetIndex];
+
+				bool bHasLineOfSight = RequestTarget.bCachedLineOfSight;
+				if(RequestTarget.TraceIndex != INDEX_NONE)
+				{
+					const FTrace& Trace = BatchTraces[RequestTarget.TraceIndex];
+
+					const bool bHitTarget = Trace.HitActor && Trace.HitActor == Trace.Key.Target;
+					const bool bHitNearTarget = Trace.bHit && Request.AcceptRadius > 0.f
+						&& FVector::DistSquared(RequestTarget.Location, Trace.ImpactPoint) < AcceptRadiusSquared;
+
+					bHasLineOfSight = bHitTarget || bHitNearTarget;
+
+					if(bUseCache)
+					{
+						AddCacheEntry(RequestTarget.CacheKey, { ExpireTime, bHasLineOfSight });
+					}
+				}
+
+				if(bHasLineOfSight)
+				{
+					Request.FirstVisibleIndex = TargetIndex;
+					break;
+				}
+			}
+		}
+	}
+
+	// Deliver in request order, on the game thread.
+	for(FRequest& Request : BatchRequests)
+	{
+		if(!Request.Requester.IsValid()) continue;
+
+		Request.Callback(Request.FirstVisibleIndex);
+	}
+}
@@ -0,0 +1,184 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_NavPathCache.h"
+
+// CORE
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+
+// UE
+#include "Engine/World.h"
+#include "NavigationData.h"
+#include "NavigationSystem.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NavPathCache Hits"), STAT_EDU_NavPathCacheHits, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("NavPathCache Misses"), STAT_EDU_NavPathCacheMisses, STATGROUP_EDU_TickLanes);
+DECLARE_DWORD_COUNTER_STAT(TEXT("NavPathCache Entries"), STAT_EDU_NavPathCacheEntries, STATGROUP_EDU_TickLanes);
+
+//------------------------------------------------------------------------------
+// Init
+//------------------------------------------------------------------------------
+
+void FNavPathCache::Init(UWorld* World, const int32 NewCapacity, const float NewInvalidationMargin)
+{
+	check(IsInGameThread());
+
+	Reset();
+	if(!World || NewCapacity <= 0) return;
+
+	Capacity = NewCapacity;
+	InvalidationMargin = FMath::Max(NewInvalidationMargin, 0.f);
+	Cache.Empty(Capacity);
+
+	NavSystem = FNavigationSystem::GetCurrent<UNavigationSystemV1>(World);
+	if(NavSystem.IsValid())
+	{
+		NavigationDirtiedHandle = NavSystem->OnNavigationDirtied.AddRaw(this, &FNavPathCache::InvalidateArea);
+	}
+}
+
+void FNavPathCache::Reset()
+{
+	if(NavSystem.IsValid())
+	{
+		NavSystem->OnNavigationDirtied.Remove(NavigationDirtiedHandle);
+	}
+	NavSystem.Reset();
+	NavigationDirtiedHandle.Reset();
+	PendingAreas.Empty();
+	LastInvalidationTime = 0.0;
+
+	Cache.Empty();
+	Capacity = 0;
+	Hits = 0;
+	Misses = 0;
+}
+
+//------------------------------------------------------------------------------
+// Paths
+//------------------------------------------------------------------------------
+
+bool FNavPathCache::MakeKey(const ANavigationData* NavData, const FVector& Start, const FVector& End, const FNavAgentProperties& Agent, FNavPathCacheKey& OutKey) const
+{
+	if(!IsValid() || !NavData) return false;
+
+	// The same extent the path query projects with.
+	const FVector Extent = NavData->GetConfig().DefaultQueryExtent;
+
+	FNavLocation StartLocation;
+	FNavLocation EndLocation;
+	if(!NavData->ProjectPoint(Start, StartLocation, Extent) || !NavData->ProjectPoint(End, EndLocation, Extent)) return false;
+
+	OutKey.StartPoly = StartLocation.NodeRef;
+	OutKey.EndPoly = EndLocation.NodeRef;
+	OutKey.AgentHash = GetAgentHash(Agent);
+	return true;
+}
+
+const TArray<FVector>* FNavPathCache::Find(const FNavPathCacheKey& Key)
+{
+	check(IsInGameThread());
+	UpdateBuildState();
+
+	if(const FEntry* Entry = Cache.FindAndTouch(Key))
+	{
+		++Hits;
+		INC_DWORD_STAT(STAT_EDU_NavPathCacheHits);
+		return &Entry->PathPoints;
+	}
+
+	++Misses;
+	INC_DWORD_STAT(STAT_EDU_NavPathCacheMisses);
+	return nullptr;
+}
+
+void FNavPathCache::Add(const FNavigationPath& Path, const FNavAgentProperties& Agent)
+{
+	check(IsInGameThread());
+
+	const TArray<FNavPathPoint>& PathPoints = Path.GetPathPoints();
+	if(!IsValid() || Path.IsPartial() || PathPoints.Num() < 2) return;
+
+	// Found on tiles that are being, or have since been, rebuilt.
+	if(!UpdateBuildState() || (LastInvalidationTime > 0.0 && Path.GetTimeStamp() <= LastInvalidationTime)) return;
+
+	FNavPathCacheKey Key;
+	Key.StartPoly = PathPoints[0].NodeRef;
+	Key.EndPoly = PathPoints.Last().NodeRef;
+	Key.AgentHash = GetAgentHash(Agent);
+	if(Key.StartPoly == INVALID_NAVNODEREF || Key.EndPoly == INVALID_NAVNODEREF) return;
+
+	FEntry Entry;
+	Entry.PathPoints.Reserve(PathPoints.Num());
+	for(const FNavPathPoint& PathPoint : PathPoints)
+	{
+		Entry.PathPoints.Add(PathPoint.Location);
+		Entry.Bounds += PathPoint.Location;
+	}
+	Entry.Bounds = Entry.Bounds.ExpandBy(InvalidationMargin);
+
+	// Evicts the least recently used path when full.
+	Cache.Add(Key, MoveTemp(Entry));
+	SET_DWORD_STAT(STAT_EDU_NavPathCacheEntries, Cache.Num());
+}
+
+void FNavPathCache::InvalidateArea(const FBox& Area)
+{ // FLOW_LOG
+	check(IsInGameThread());
+
+	// Dirtied before the tiles rebuild, paths found until then still run on the old ones.
+	PendingAreas.Add(Area);
+	if(const UWorld* World = NavSystem.IsValid() ? NavSystem->GetWorld() : nullptr)
+	{
+		LastInvalidationTime = World->GetTimeSeconds();
+	}
+
+	RemoveIntersecting(Area);
+}
+
+bool FNavPathCache::UpdateBuildState()
+{
+	if(!NavSystem.IsValid()) return true;
+	if(NavSystem->IsNavigationBuildInProgress()) return false;
+	if(PendingAreas.Num() == 0) return true;
+
+	for(const FBox& Area : PendingAreas)
+	{
+		RemoveIntersecting(Area);
+	}
+	PendingAreas.Reset();
+
+	if(const UWorld* World = NavSystem->GetWorld())
+	{
+		LastInvalidationTime = World->GetTimeSeconds();
+	}
+	return true;
+}
+
+void FNavPathCache::RemoveIntersecting(const FBox& Area)
+{
+	if(Cache.Num() == 0) return;
+
+	TArray<FNavPathCacheKey, TInlineAllocator<16>> Invalidated;
+	for(TLruCache<FNavPathCacheKey, FEntry>::TConstIterator It(Cache); It; ++It)
+	{
+		// The segments could miss the area, but the polygons of the key might not.
+		if(It.Value().Bounds.Intersect(Area))
+		{
+			Invalidated.Add(It.Key());
+		}
+	}
+
+	for(const FNavPathCacheKey& Key : Invalidated)
+	{
+		Cache.Remove(Key);
+	}
+	SET_DWORD_STAT(STAT_EDU_NavPathCacheEntries, Cache.Num());
+}
+
+uint32 FNavPathCache::GetAgentHash(const FNavAgentProperties& Agent)
+{
+	return HashCombineFast(
+		HashCombineFast(GetTypeHash(Agent.AgentRadius), GetTypeHash(Agent.AgentHeight)),
+		HashCombineFast(GetTypeHash(Agent.AgentStepHeight), GetTypeHash(Agent.NavWalkingSearchHeightScale)));
+}
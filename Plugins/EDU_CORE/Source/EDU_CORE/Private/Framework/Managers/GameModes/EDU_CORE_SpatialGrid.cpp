@@ -0,0 +1,108 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_SpatialGrid.h"
+
+//------------------------------------------------------------------------------
+// Construction
+//------------------------------------------------------------------------------
+
+void FSpatialGrid::SetCellSize(const float NewCellSize)
+{
+	CellSize = FMath::Max(NewCellSize, 100.f);
+	InvCellSize = 1.f / CellSize;
+
+	// Cell coordinates depend on the size, so the old cells are useless.
+	Cells.Reset();
+	OccupiedCells.Reset();
+	NumEntries = 0;
+}
+
+void FSpatialGrid::Reset()
+{
+	for(const FIntPoint& Coordinates : OccupiedCells)
+	{
+		FCell& Cell = Cells.FindChecked(Coordinates);
+		for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+		{
+			Cell.TeamEntries[TeamIndex].Reset();
+		}
+		Cell.OccupiedTeams = 0;
+	}
+
+	// Moving entities leave a trail of empty cells, drop them once they outnumber the occupied ones.
+	if(Cells.Num() > FMath::Max(OccupiedCells.Num() * 4, 256))
+	{
+		Cells.Reset();
+	}
+
+	OccupiedCells.Reset();
+	NumEntries = 0;
+}
+
+void FSpatialGrid::Add(AActor* Actor, const FVector& Location, const EEDU_CORE_Team Team, const ECollisionChannel ObjectType)
+{
+	if(!Actor || !FTeamVisibility::IsValidTeam(Team)) return;
+
+	const FIntPoint Coordinates = GetCellCoordinates(Location);
+	FCell& Cell = Cells.FindOrAdd(Coordinates);
+	if(Cell.OccupiedTeams == 0)
+	{
+		OccupiedCells.Add(Coordinates);
+	}
+
+	const uint32 ObjectTypeBit = ObjectType < ECC_MAX ? ECC_TO_BITFIELD(ObjectType) : 0;
+	Cell.TeamEntries[static_cast<int32>(Team)].Add({ Actor, Location, ObjectTypeBit });
+	Cell.OccupiedTeams |= FTeamVisibility::GetTeamBit(Team);
+	++NumEntries;
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+template<typename VisitorType>
+void FSpatialGrid::ForEachEntryInRadius(const FVector& Center, const float Radius, const FTeamMask TeamMask, VisitorType&& Visitor) const
+{
+	if(TeamMask == 0 || NumEntries == 0) return;
+
+	const FIntPoint MinCell = GetCellCoordinates(Center - FVector(Radius, Radius, 0.f));
+	const FIntPoint MaxCell = GetCellCoordinates(Center + FVector(Radius, Radius, 0.f));
+
+	for(int32 CellX = MinCell.X; CellX <= MaxCell.X; ++CellX)
+	{
+		for(int32 CellY = MinCell.Y; CellY <= MaxCell.Y; ++CellY)
+		{
+			const FCell* Cell = Cells.Find(FIntPoint(CellX, CellY));
+			if(!Cell) continue;
+
+			const FTeamMask CellMask = Cell->OccupiedTeams & TeamMask;
+			if(CellMask == 0) continue;
+
+			for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+			{
+				if(!(CellMask & (1u << TeamIndex))) continue;
+
+				for(const FEntry& Entry : Cell->TeamEntries[TeamIndex])
+				{
+					Visitor(Entry);
+				}
+			}
+		}
+	}
+}
+
+void FSpatialGrid::QueryRadius(const FVector& Center, const float Radius, const FTeamMask TeamMask, TArray<AActor*>& OutActors, const uint32 ObjectTypeMask) const
+{
+	const float RadiusSquared = FMath::Square(Radius);
+
+	ForEachEntryInRadius(Center, Radius, TeamMask, [&](const FEntry& Entry)
+	{
+		if(Entry.ObjectTypeBit != 0 && !(Entry.ObjectTypeBit & ObjectTypeMask)) return;
+
+		if(FVector::DistSquared(Entry.Location, Center) <= RadiusSquared)
+		{
+			OutActors.Add(Entry.Actor);
+		}
+	});
+}
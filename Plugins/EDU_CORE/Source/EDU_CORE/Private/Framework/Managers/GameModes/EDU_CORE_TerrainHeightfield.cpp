@@ -0,0 +1,166 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_TerrainHeightfield.h"
+
+// UE
+#include "Async/ParallelFor.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/World.h"
+
+//------------------------------------------------------------------------------
+// Bake
+//------------------------------------------------------------------------------
+
+bool FTerrainHeightfield::Bake(const UWorld* World, const FBox& Bounds, const float NewCellSize, const bool bIncludeStaticMeshes)
+{
+	check(IsInGameThread());
+	TRACE_CPUPROFILER_EVENT_SCOPE(FTerrainHeightfield::Bake);
+
+	Reset();
+	if(!World || !Bounds.IsValid) return false;
+
+	CellSize = FMath::Max(NewCellSize, 50.f);
+	InvCellSize = 1.f / CellSize;
+
+	// In 64 bits, unbounded level bounds overflow an int32 cell count.
+	const int64 NumX = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.X - Bounds.Min.X) * InvCellSize), 1);
+	const int64 NumY = FMath::Max<int64>(FMath::CeilToInt64((Bounds.Max.Y - Bounds.Min.Y) * InvCellSize), 1);
+	if(NumX * NumY > MaxCells)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FTerrainHeightfield::Bake - %lld x %lld cells exceed MaxCells (%d), set TerrainBounds to the playable area."), NumX, NumY, MaxCells);
+		return false;
+	}
+
+	Origin = FVector2D(Bounds.Min);
+	SizeX = static_cast<int32>(NumX);
+	SizeY = static_cast<int32>(NumY);
+	MinHeight = Bounds.Min.Z;
+
+	Heights.SetNumUninitialized(SizeX * SizeY);
+
+	const float TraceTop = Bounds.Max.Z + 100.f;
+	const float TraceBottom = Bounds.Min.Z - 100.f;
+	const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+
+	// One row per task, scene queries are read only.
+	ParallelFor(TEXT("TerrainHeightfield Bake"), SizeY, 1, [&](const int32 CellY)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(EDU_TerrainBake), false);
+
+		for(int32 CellX = 0; CellX < SizeX; ++CellX)
+		{
+			const float X = Origin.X + (CellX + 0.5f) * CellSize;
+			const float Y = Origin.Y + (CellY + 0.5f) * CellSize;
+
+			float Height = MinHeight;
+			FHitResult HitResult;
+
+			// Without static meshes, trace through them until we reach the ground.
+			for(int32 Attempt = 0; Attempt < 4; ++Attempt)
+			{
+				if(!World->LineTraceSingleByObjectType(HitResult, FVector(X, Y, TraceTop), FVector(X, Y, TraceBottom), ObjectParams, QueryParams)) break;
+
+				if(!bIncludeStaticMeshes && HitResult.GetComponent() && HitResult.GetComponent()->IsA<UStaticMeshComponent>())
+				{
+					QueryParams.AddIgnoredComponent(HitResult.GetComponent());
+					continue;
+				}
+
+				Height = HitResult.ImpactPoint.Z;
+				break;
+			}
+
+			Heights[CellY * SizeX + CellX] = Height;
+		}
+	});
+
+	return true;
+}
+
+void FTerrainHeightfield::Reset()
+{
+	Heights.Empty();
+	SizeX = 0;
+	SizeY = 0;
+}
+
+//------------------------------------------------------------------------------
+// Queries
+//------------------------------------------------------------------------------
+
+float FTerrainHeightfield::GetHeight(const FVector& Location) const
+{
+	return GetCellHeight(
+		FMath::FloorToInt32((Location.X - Origin.X) * InvCellSize),
+		FMath::FloorToInt32((Location.Y - Origin.Y) * InvCellSize));
+}
+
+bool FTerrainHeightfield::IsBlocked(const FVector& Start, const FVector& End, FVector* OutBlockLocation) const
+{ // FLOW_LOG
+	/*---------------------------------------------------------------------
+	  Grid walk (Amanatides & Woo) over every cell the XY line crosses.
+	  T runs from 0 at Start to 1 at End, and each cell holds the line
+	  from T to NextT, the lowest point of the line in a cell is at one of
+	  those two ends.
+	---------------------------------------------------------------------*/
+	if(!IsValid()) return false;
+
+	const float StartX = (Start.X - Origin.X) * InvCellSize;
+	const float StartY = (Start.Y - Origin.Y) * InvCellSize;
+	const float DeltaX = (End.X - Origin.X) * InvCellSize - StartX;
+	const float DeltaY = (End.Y - Origin.Y) * InvCellSize - StartY;
+
+	int32 CellX = FMath::FloorToInt32(StartX);
+	int32 CellY = FMath::FloorToInt32(StartY);
+	const int32 EndCellX = FMath::FloorToInt32(StartX + DeltaX);
+	const int32 EndCellY = FMath::FloorToInt32(StartY + DeltaY);
+
+	const int32 StepX = DeltaX > 0.f ? 1 : -1;
+	const int32 StepY = DeltaY > 0.f ? 1 : -1;
+
+	// T at which the line crosses the next cell border, and the T between two borders.
+	const float DeltaTX = FMath::Abs(DeltaX) > UE_SMALL_NUMBER ? 1.f / FMath::Abs(DeltaX) : UE_BIG_NUMBER;
+	const float DeltaTY = FMath::Abs(DeltaY) > UE_SMALL_NUMBER ? 1.f / FMath::Abs(DeltaY) : UE_BIG_NUMBER;
+	float NextTX = DeltaTX * (StepX > 0 ? (CellX + 1 - StartX) : (StartX - CellX));
+	float NextTY = DeltaTY * (StepY > 0 ? (CellY + 1 - StartY) : (StartY - CellY));
+
+	const int32 MaxSteps = FMath::Abs(EndCellX - CellX) + FMath::Abs(EndCellY - CellY);
+	float T = 0.f;
+
+	for(int32 Step = 0; Step <= MaxSteps; ++Step)
+	{
+		const float NextT = FMath::Min3(NextTX, NextTY, 1.f);
+		const bool bEndpointCell = Step == 0 || (CellX == EndCellX && CellY == EndCellY);
+
+		if(!bEndpointCell && IsValidCell(CellX, CellY))
+		{
+			const float LineZ = FMath::Min(FMath::Lerp(Start.Z, End.Z, T), FMath::Lerp(Start.Z, End.Z, NextT));
+			if(GetCellHeight(CellX, CellY) > LineZ + Clearance)
+			{
+				if(OutBlockLocation)
+				{
+					*OutBlockLocation = FMath::Lerp(Start, End, T);
+				}
+				return true;
+			}
+		}
+
+		if(NextT >= 1.f) break;
+
+		// Step into the next cell along whichever axis crosses a border first.
+		T = NextT;
+		if(NextTX < NextTY)
+		{
+			CellX += StepX;
+			NextTX += DeltaTX;
+		}
+		else
+		{
+			CellY += StepY;
+			NextTY += DeltaTY;
+		}
+	}
+
+	return false;
+}
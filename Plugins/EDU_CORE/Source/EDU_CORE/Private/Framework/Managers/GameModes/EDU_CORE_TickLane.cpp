@@ -0,0 +1,152 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+
+// UE
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+UE_TRACE_CHANNEL_DEFINE(EDU_TickLaneChannel);
+
+//------------------------------------------------------------------------------
+// Construction
+//------------------------------------------------------------------------------
+
+FTickLane::FTickLane(const FTickLaneSettings& InSettings) : Settings(InSettings)
+{
+	const FString LaneName = Settings.Name.ToString();
+	CalcScopeName = LaneName + TEXT(" Calc");
+	ExecScopeName = LaneName + TEXT(" Exec");
+
+#if STATS
+	CalcStatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_EDU_TickLanes>(CalcScopeName);
+	ExecStatId = FDynamicStats::CreateStatId<FStatGroup_STATGROUP_EDU_TickLanes>(ExecScopeName);
+	ItemsStatId = FDynamicStats::CreateStatIdInt64<FStatGroup_STATGROUP_EDU_TickLanes>(LaneName + TEXT(" Items/Frame"));
+	CycleLatencyStatId = FDynamicStats::CreateStatIdDouble<FStatGroup_STATGROUP_EDU_TickLanes>(LaneName + TEXT(" Cycle Latency (s)"));
+	AsyncTaskStatId = FDynamicStats::CreateStatIdInt64<FStatGroup_STATGROUP_EDU_TickLanes>(LaneName + TEXT(" AsyncTasks/Frame"));
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Tick
+//------------------------------------------------------------------------------
+
+void FTickLane::Tick(const FTickLaneContext& Context)
+{
+	const int32 Num = GetNum();
+	const int32 AsyncTasksBefore = AsyncTaskCounter.load(std::memory_order_relaxed);
+	ItemsThisFrame = 0;
+	LastFrameMs = 0.f;
+
+	// If more than Period has passed since the last cycle, start a new batch cycle
+	if(Context.AsyncedClock - LastCycleTime >= Settings.Period)
+	{
+		if(BatchIndex == 0)
+		{
+			LastCycleTime = Context.AsyncedClock;
+		}
+
+		const int32 BatchSize = CalculateBatchSize(Num, Context);
+
+		// Calculate the end index for the current batch
+		const int32 ThisTickEndIndex = FMath::Min(BatchIndex + BatchSize, Num);
+		ItemsThisFrame = ThisTickEndIndex - BatchIndex;
+
+		if(ItemsThisFrame > 0)
+		{
+			UpdateParallelChunking(ItemsThisFrame);
+
+			const double CalcStartTime = FPlatformTime::Seconds();
+			{
+				TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(*CalcScopeName, EDU_TickLaneChannel);
+#if STATS
+				FScopeCycleCounter CycleCounter(CalcStatId);
+#endif
+				ProcessCalc(BatchIndex, ThisTickEndIndex, Context);
+			}
+
+			const double ExecStartTime = FPlatformTime::Seconds();
+			{
+				TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(*ExecScopeName, EDU_TickLaneChannel);
+#if STATS
+				FScopeCycleCounter CycleCounter(ExecStatId);
+#endif
+				ProcessExec(BatchIndex, ThisTickEndIndex, Context);
+			}
+
+			const double EndTime = FPlatformTime::Seconds();
+			LastFrameMs = static_cast<float>((EndTime - CalcStartTime) * 1000.0);
+			RecordCost(ExecStartTime - CalcStartTime, EndTime - ExecStartTime, ItemsThisFrame);
+		}
+
+		BatchIndex = ThisTickEndIndex;
+	}
+
+	// If we've completed processing the entire array, reset the batch index to 0
+	if(BatchIndex >= Num)
+	{
+		if(ItemsThisFrame > 0)
+		{
+			LastCycleLatency = Context.AsyncedClock - LastCycleTime;
+		}
+		BatchIndex = 0;
+	}
+
+#if STATS
+	SET_DWORD_STAT_FName(ItemsStatId.GetName(), ItemsThisFrame);
+	SET_FLOAT_STAT_FName(CycleLatencyStatId.GetName(), LastCycleLatency);
+	SET_DWORD_STAT_FName(AsyncTaskStatId.GetName(), AsyncTaskCounter.load(std::memory_order_relaxed) - AsyncTasksBefore);
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Budgeted mode
+//------------------------------------------------------------------------------
+
+int32 FTickLane::CalculateBatchSize(const int32 Num, const FTickLaneContext& Context) const
+{
+	const int32 FixedBatchSize = Settings.BatchSize > 0 ? Settings.BatchSize : Num;
+
+	// Every frame lanes always process the whole array, and we need one measurement before we can budget.
+	if(!Context.bUseBudgets || Settings.BudgetMs <= 0.f || Settings.Period <= 0.f || CostPerItemMs <= 0.0)
+	{
+		return FixedBatchSize;
+	}
+
+	// Members per frame needed to complete a cycle within the target latency
+	const float CycleLatency = Settings.TargetCycleLatency > 0.f ? Settings.TargetCycleLatency : Settings.Period;
+	const float FramesPerCycle = FMath::Max(CycleLatency / FMath::Max(Context.AsyncedClockDelta, UE_KINDA_SMALL_NUMBER), 1.f);
+	const int32 LatencyBatchSize = FMath::CeilToInt32(Num / FramesPerCycle);
+
+	// Members per frame we can afford
+	const int32 BudgetBatchSize = FMath::Max(FMath::FloorToInt32(Settings.BudgetMs / CostPerItemMs), 1);
+
+	return FMath::Clamp(LatencyBatchSize, 1, BudgetBatchSize);
+}
+
+void FTickLane::UpdateParallelChunking(const int32 ItemCount)
+{
+	// Each worker task should carry at least this much work to pay for its dispatch.
+	constexpr double MinParallelTaskMs = 0.05;
+
+	ParallelMinBatchSize = CalcCostPerItemMs > 0.0
+		? FMath::Max(FMath::CeilToInt32(MinParallelTaskMs / CalcCostPerItemMs), 1)
+		: 1;
+
+	ParallelFlags = ParallelMinBatchSize >= ItemCount
+		? EParallelForFlags::ForceSingleThread
+		: EParallelForFlags::None;
+}
+
+void FTickLane::RecordCost(const double CalcSeconds, const double ExecSeconds, const int32 ItemCount)
+{
+	// Exponential moving average, smooths out single hitches.
+	constexpr double Smoothing = 0.2;
+
+	const double CalcMs = CalcSeconds * 1000.0 / ItemCount;
+	const double ExecMs = ExecSeconds * 1000.0 / ItemCount;
+
+	CalcCostPerItemMs = CalcCostPerItemMs > 0.0 ? FMath::Lerp(CalcCostPerItemMs, CalcMs, Smoothing) : CalcMs;
+	ExecCostPerItemMs = ExecCostPerItemMs > 0.0 ? FMath::Lerp(ExecCostPerItemMs, ExecMs, Smoothing) : ExecMs;
+	CostPerItemMs = CalcCostPerItemMs + ExecCostPerItemMs;
+}
@@ -9,6 +9,41 @@
 #include "EnhancedInputSubsystems.h"
 #include "Entities/EDU_CORE_AbstractEntity.h"
 #include "Entities/EDU_CORE_PhysicsEntity.h"
+#include "GameFramework/GameStateBase.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+#include "Engine/LocalPlayer.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/Engine.h"
+#include "SceneView.h"
+
+//------------------------------------------------------------------------------
+// Client Physics Lane
+//	<!> Binds the lane to the controller, Calc needs the index for ClientPhysicsTransforms.
+//------------------------------------------------------------------------------
+
+class FClientPhysicsLane final : public FTickLane
+{
+public:
+	FClientPhysicsLane(const FTickLaneSettings& InSettings, AEDU_CORE_PlayerController& InController)
+	: FTickLane(InSettings), Controller(InController)
+	{}
+
+protected:
+	virtual int32 GetNum() const override { return Controller.PhysicsEntityArray.Num(); }
+
+	virtual void ProcessCalc(const int32 StartIndex, const int32 EndIndex, const FTickLaneContext& Context) override
+	{
+		Controller.ClientPhysicsCalc(StartIndex, EndIndex, ParallelMinBatchSize, ParallelFlags);
+	}
+
+	virtual void ProcessExec(const int32 StartIndex, const int32 EndIndex, const FTickLaneContext& Context) override
+	{
+		Controller.ClientPhysicsExec(StartIndex, EndIndex);
+	}
+
+private:
+	AEDU_CORE_PlayerController& Controller;
+};
 
 //------------------------------------------------------------------------------
 // Initialization & Object lifetime management
@@ -36,6 +71,19 @@ void AEDU_CORE_PlayerController::BeginPlay()
 	InputModeData.SetHideCursorDuringCapture(false); // Whether to hide the cursor during temporary mouse capture caused by a mouse down
 	InputModeData.SetLockMouseToViewportBehavior(EMouseLockMode::DoNotLock); // Don't lock to window. It's better to put this in a menu.
 	SetShowMouseCursor(true);
+
+	// True clients only, ListenServers run the GameMode lanes.
+	if(GetNetMode() == NM_Client)
+	{
+		FTickLaneSettings LaneSettings;
+		LaneSettings.Name = TEXT("Client Physics");
+		LaneSettings.Period = ClientPhysicsPeriod;
+		LaneSettings.BudgetMs = ClientPhysicsBudgetMs;
+		ClientPhysicsLane = MakeUnique<FClientPhysicsLane>(LaneSettings, *this);
+
+		ClientFrameTimeRecorder.AddChannel(TEXT("Client Frame"));
+		ClientFrameTimeRecorder.AddChannel(LaneSettings.Name);
+	}
 }
 
 void AEDU_CORE_PlayerController::PlayerTick(float DeltaTime)
@@ -43,48 +91,159 @@ void AEDU_CORE_PlayerController::PlayerTick(float DeltaTime)
 	Super::PlayerTick(DeltaTime);
 	
 	/*---------------------- Client-Side Aggregated Tick --------------------------*/
-	if(GetNetMode() == NM_Client)
+	if(ClientPhysicsLane)
 	{
-		/*-------------------------------------------------------------------------------
-		  Physics updates!
-		  
-		<!> TODO
-			For Optimization these can be split between ParallelFor and for, running calcs on ParallelFor and SetActor_X() on the gamethread using Asycn
-				https://georgy.dev/posts/parallel-for-loop/
-				https://georgy.dev/posts/async-task/
-		------------------------------------------------------------------------------*/
-		for (AEDU_CORE_PhysicsEntity* PhysicsEntity : PhysicsEntityArray)
+		ClientPhysicsTick(DeltaTime);
+	}
+}
+
+void AEDU_CORE_PlayerController::ClientPhysicsTick(const float DeltaTime)
+{ // FLOW_LOG
+	// Entities render behind this, see AEDU_CORE_PhysicsEntity::InterpolationDelay.
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	ClientPhysicsServerTime = GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	if(GetWorld()->GetTimeSeconds() >= NextSignificanceUpdate)
+	{
+		NextSignificanceUpdate = GetWorld()->GetTimeSeconds() + SignificanceUpdateInterval;
+		UpdateClientSignificance();
+	}
+
+	ClientPhysicsTransforms.SetNum(PhysicsEntityArray.Num(), EAllowShrinking::No);
+
+	// The client has no AsyncedClock, world time drives periods and budgets instead.
+	FTickLaneContext LaneContext;
+	LaneContext.DeltaTime = DeltaTime;
+	LaneContext.AsyncDeltaTime = DeltaTime;
+	LaneContext.AsyncedClock = GetWorld()->GetTimeSeconds();
+	LaneContext.AsyncedClockDelta = DeltaTime;
+
+	ClientPhysicsLane->Tick(LaneContext);
+
+	ClientFrameTimeRecorder.Record(0, DeltaTime * 1000.f);
+	if(ClientPhysicsLane->GetItemsThisFrame() > 0)
+	{
+		ClientFrameTimeRecorder.Record(1, ClientPhysicsLane->GetLastFrameMs());
+	}
+}
+
+void AEDU_CORE_PlayerController::ClientPhysicsCalc(const int32 StartIndex, const int32 EndIndex, const int32 MinBatchSize, const EParallelForFlags Flags)
+{ // FLOW_LOG
+	const double ServerTime = ClientPhysicsServerTime;
+	const uint64 FrameNumber = GFrameCounter;
+	const uint32 Interval = static_cast<uint32>(FMath::Max(ReducedUpdateInterval, 1));
+	
+	ParallelFor(TEXT("Client Physics Calc"), EndIndex - StartIndex, MinBatchSize, [this, StartIndex, ServerTime, FrameNumber, Interval](const int32 LocalIndex)
+	{
+		const int32 Index = StartIndex + LocalIndex;
+		FClientPhysicsTransform& Transform = ClientPhysicsTransforms[Index];
+		Transform.bMoved = Transform.bScaled = false;
+		
+		const AEDU_CORE_PhysicsEntity* PhysicsEntity = PhysicsEntityArray[Index];
+		if(!PhysicsEntity) return;
+
+		switch(PhysicsEntity->GetClientSignificance())
 		{
-			// Check if the entity pointer is valid (not null)
-			if (PhysicsEntity)
-			{
-				// If the entity pointer is valid, call the ParallelTick function on the entity
-				PhysicsEntity->ClientLerpLocation(DeltaTime);
-			}
+		case EEDU_CORE_ClientSignificance::Frozen:
+			return;
+
+		case EEDU_CORE_ClientSignificance::Hidden:
+			// Revealed since the last significance update, snap to the buffer right away.
+			if(PhysicsEntity->IsHidden()) return;
+			break;
+			
+		case EEDU_CORE_ClientSignificance::Reduced:
+			// Staggered by UniqueID, the array order changes when entities are removed.
+			if((FrameNumber + PhysicsEntity->GetUniqueID()) % Interval != 0) return;
+			break;
+			
+		default:
+			break;
 		}
 		
-		for (AEDU_CORE_PhysicsEntity* PhysicsEntity : PhysicsEntityArray)
+		PhysicsEntity->ClientPhysicsCalc(ServerTime, Transform);
+	}, Flags);
+}
+
+void AEDU_CORE_PlayerController::ClientPhysicsExec(const int32 StartIndex, const int32 EndIndex)
+{ // FLOW_LOG
+	for(int32 Index = StartIndex; Index < EndIndex && Index < PhysicsEntityArray.Num(); ++Index)
+	{
+		const FClientPhysicsTransform& Transform = ClientPhysicsTransforms[Index];
+		if(Transform.bMoved || Transform.bScaled)
 		{
-			// Check if the entity pointer is valid (not null)
-			if (PhysicsEntity)
-			{
-				// If the entity pointer is valid, call the ParallelTick function on the entity
-				PhysicsEntity->ClientLerpRotation(DeltaTime);
-			}
+			PhysicsEntityArray[Index]->ClientPhysicsExec(Transform);
 		}
-		
-		for (AEDU_CORE_PhysicsEntity* PhysicsEntity : PhysicsEntityArray)
+	}
+}
+
+void AEDU_CORE_PlayerController::UpdateClientSignificance()
+{ // FLOW_LOG
+	TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(TEXT("Client Significance"), EDU_TickLaneChannel);
+	
+	// Without a view, e.g. while the viewport is being created, update everything.
+	const ULocalPlayer* LocalPlayer = GetLocalPlayer();
+	FSceneViewProjectionData ProjectionData;
+	if(!LocalPlayer || !LocalPlayer->ViewportClient || !LocalPlayer->GetProjectionData(LocalPlayer->ViewportClient->Viewport, ProjectionData))
+	{
+		for(AEDU_CORE_PhysicsEntity* PhysicsEntity : PhysicsEntityArray)
 		{
-			// Check if the entity pointer is valid (not null)
-			if (PhysicsEntity)
-			{
-				// If the entity pointer is valid, call the ParallelTick function on the entity
-				PhysicsEntity->ClientLerpScale(DeltaTime);
-			}
+			if(PhysicsEntity) PhysicsEntity->SetClientSignificance(EEDU_CORE_ClientSignificance::Full);
 		}
+		return;
 	}
+
+	FConvexVolume Frustum;
+	GetViewFrustumBounds(Frustum, ProjectionData.ComputeViewProjectionMatrix(), false);
 	
-}	
+	const FVector ViewOrigin = ProjectionData.ViewOrigin;
+	const double FullDistanceSquared = FMath::Square(FullUpdateDistance);
+	const double FrozenDistanceSquared = FMath::Square(FrozenDistance);
+
+	ParallelFor(TEXT("Client Significance"), PhysicsEntityArray.Num(), ClientPhysicsMinBatchSize, [&](const int32 Index)
+	{
+		AEDU_CORE_PhysicsEntity* PhysicsEntity = PhysicsEntityArray[Index];
+		if(!PhysicsEntity) return;
+
+		const FVector Location = PhysicsEntity->GetActorLocation();
+		const double DistanceSquared = FVector::DistSquared(ViewOrigin, Location);
+
+		EEDU_CORE_ClientSignificance Significance = EEDU_CORE_ClientSignificance::Full;
+		if(PhysicsEntity->IsHidden())
+		{
+			Significance = EEDU_CORE_ClientSignificance::Hidden;
+		}
+		else if(DistanceSquared > FrozenDistanceSquared
+			|| !Frustum.IntersectSphere(Location, PhysicsEntity->GetSimpleCollisionRadius() + SignificanceFrustumMargin))
+		{
+			Significance = EEDU_CORE_ClientSignificance::Frozen;
+		}
+		else if(DistanceSquared > FullDistanceSquared)
+		{
+			Significance = EEDU_CORE_ClientSignificance::Reduced;
+		}
+		
+		PhysicsEntity->SetClientSignificance(Significance);
+	});
+}
+
+void AEDU_CORE_PlayerController::ClientFrameTimes() const
+{
+	UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("Client frame times (ms) over the last %u frames"), FFrameTimeRecorder::Capacity);
+	
+	for(int32 Channel = 0; Channel < ClientFrameTimeRecorder.GetNumChannels(); ++Channel)
+	{
+		const FFrameTimeRecorder::FSummary Summary = ClientFrameTimeRecorder.GetSummary(Channel);
+		const FString Line = FString::Printf(TEXT("%-32s p50: %7.3f  p95: %7.3f  p99: %7.3f  max: %7.3f"),
+			*ClientFrameTimeRecorder.GetChannelName(Channel).ToString(), Summary.P50, Summary.P95, Summary.P99, Summary.Max);
+		
+		UE_LOG(FLOWLOG_CATEGORY, Display, TEXT("%s"), *Line);
+		if(GEngine)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Cyan, Line);
+		}
+	}
+}
 
 //------------------------------------------------------------------------------
 // Functionality: Utility
@@ -118,6 +277,12 @@ void AEDU_CORE_PlayerController::AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity
 	}
 }
 
+void AEDU_CORE_PlayerController::RemoveFromPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity)
+{ FLOW_LOG
+	// Order doesn't matter, ClientPhysicsTransforms is refilled every frame.
+	PhysicsEntityArray.RemoveSwap(PhysicsEntity, EAllowShrinking::No);
+}
+
 	
 //------------------------------------------------------------------------------
 // Input
@@ -0,0 +1,437 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+// THIS
+#include "Framework/Managers/Replication/EDU_CORE_ReplicationGraph.h"
+
+// CORE
+#include "Entities/EDU_CORE_PhysicsEntity.h"
+#include "Entities/Components/StatusComponent.h"
+#include "Entities/Waypoints/EDU_CORE_Waypoint.h"
+#include "Framework/Pawns/EDU_CORE_SpectatorCamera.h"
+#include "Framework/Pawns/EDU_CORE_C2_Camera.h"
+
+// UE
+#include "Engine/NetConnection.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerController.h"
+#include "UObject/UObjectIterator.h"
+
+namespace EDU_CORE_ReplicationGraph
+{
+	// The team of the C2 camera the viewer looks through, Max if we can't tell.
+	EEDU_CORE_Team GetViewerTeam(const FNetViewer& Viewer)
+	{
+		const AEDU_CORE_C2_Camera* Camera = Cast<AEDU_CORE_C2_Camera>(Viewer.ViewTarget);
+		if(!Camera)
+		{
+			const APlayerController* PlayerController = Cast<APlayerController>(Viewer.InViewer);
+			Camera = PlayerController ? Cast<AEDU_CORE_C2_Camera>(PlayerController->GetPawn()) : nullptr;
+		}
+		return Camera ? Camera->GetTeam() : EEDU_CORE_Team::Max;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Construction & Init
+//------------------------------------------------------------------------------
+
+void UEDU_CORE_ReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Update frequency and cull distance come from the class defaults, like they do for the default net driver.
+	for(TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+		if(!Class->IsChildOf(AActor::StaticClass()) || Class->HasAnyClassFlags(CLASS_Abstract | CLASS_Deprecated | CLASS_NewerVersionExists)) continue;
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject());
+		if(!ActorCDO || !ActorCDO->GetIsReplicated()) continue;
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(ActorCDO->GetNetUpdateFrequency());
+		ClassInfo.SetCullDistanceSquared(ActorCDO->GetNetCullDistanceSquared());
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UEDU_CORE_ReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = GridSpatialBias;
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	TeamNode = CreateNewNode<UEDU_CORE_ReplicationGraphNode_Team>();
+	AddGlobalGraphNode(TeamNode);
+
+	TeamGridNode = CreateNewNode<UEDU_CORE_ReplicationGraphNode_TeamGrid>();
+	TeamGridNode->InitGrids(GridCellSize, GridSpatialBias);
+	AddGlobalGraphNode(TeamGridNode);
+}
+
+void UEDU_CORE_ReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager)
+{
+	Super::InitConnectionGraphNodes(ConnectionManager);
+
+	// The connection's own PlayerController and camera.
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, ConnectionManager);
+}
+
+//------------------------------------------------------------------------------
+// Routing
+//------------------------------------------------------------------------------
+
+EEDU_CORE_ReplicationNode UEDU_CORE_ReplicationGraph::GetNodeFor(const AActor* Actor) const
+{
+	// Waypoints are bAlwaysRelevant, but only to their own team.
+	if(Actor->IsA<AEDU_CORE_Waypoint>()) return EEDU_CORE_ReplicationNode::Team;
+
+	if(const AEDU_CORE_PhysicsEntity* PhysicsEntity = Cast<AEDU_CORE_PhysicsEntity>(Actor))
+	{
+		if(PhysicsEntity->bTeamNetRelevancy && !PhysicsEntity->bAlwaysRelevant && PhysicsEntity->GetStatusComponent()) return EEDU_CORE_ReplicationNode::TeamEntity;
+	}
+
+	// Cameras and PlayerControllers are added by the connection's own node.
+	if(Actor->IsA<AEDU_CORE_SpectatorCamera>() || Actor->bOnlyRelevantToOwner) return EEDU_CORE_ReplicationNode::NotRouted;
+
+	if(Actor->bAlwaysRelevant || Actor->IsA<AInfo>()) return EEDU_CORE_ReplicationNode::AlwaysRelevant;
+
+	// From the class defaults, so an actor that changes dormancy at runtime is still removed from the node it was added to.
+	if(Actor->GetClass()->GetDefaultObject<AActor>()->NetDormancy > DORM_Awake) return EEDU_CORE_ReplicationNode::Spatialize_Dormancy;
+
+	return Actor->IsRootComponentMovable() ? EEDU_CORE_ReplicationNode::Spatialize_Dynamic : EEDU_CORE_ReplicationNode::Spatialize_Static;
+}
+
+void UEDU_CORE_ReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	switch(GetNodeFor(ActorInfo.Actor))
+	{
+		case EEDU_CORE_ReplicationNode::AlwaysRelevant:			AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);	break;
+		case EEDU_CORE_ReplicationNode::Team:					TeamNode->NotifyAddNetworkActor(ActorInfo);				break;
+		case EEDU_CORE_ReplicationNode::TeamEntity:				TeamNode->NotifyAddNetworkActor(ActorInfo);
+																TeamGridNode->NotifyAddNetworkActor(ActorInfo);			break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Static:		GridNode->AddActor_Static(ActorInfo, GlobalInfo);		break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Dynamic:		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);		break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Dormancy:	GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);		break;
+
+	default: ;
+	}
+}
+
+void UEDU_CORE_ReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	switch(GetNodeFor(ActorInfo.Actor))
+	{
+		case EEDU_CORE_ReplicationNode::AlwaysRelevant:			AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);	break;
+		case EEDU_CORE_ReplicationNode::Team:					TeamNode->NotifyRemoveNetworkActor(ActorInfo);				break;
+		case EEDU_CORE_ReplicationNode::TeamEntity:				TeamNode->NotifyRemoveNetworkActor(ActorInfo);
+																TeamGridNode->NotifyRemoveNetworkActor(ActorInfo);			break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Static:		GridNode->RemoveActor_Static(ActorInfo);					break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Dynamic:		GridNode->RemoveActor_Dynamic(ActorInfo);					break;
+		case EEDU_CORE_ReplicationNode::Spatialize_Dormancy:	GridNode->RemoveActor_Dormancy(ActorInfo);					break;
+
+	default: ;
+	}
+}
+
+//------------------------------------------------------------------------------
+// Team Node
+//------------------------------------------------------------------------------
+
+UEDU_CORE_ReplicationGraphNode_Team::UEDU_CORE_ReplicationGraphNode_Team()
+{
+	for(uint32& Frame : TeamListFrames)
+	{
+		Frame = MAX_uint32;
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_Team::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	FTeamEntity& Entity = TeamEntities.AddDefaulted_GetRef();
+	Entity.Actor = ActorInfo.Actor;
+	Entity.Waypoint = Cast<AEDU_CORE_Waypoint>(ActorInfo.Actor);
+
+	if(const AEDU_CORE_PhysicsEntity* PhysicsEntity = Cast<AEDU_CORE_PhysicsEntity>(ActorInfo.Actor))
+	{
+		Entity.StatusComponent = PhysicsEntity->GetStatusComponent();
+	}
+
+	if(Entity.Waypoint)
+	{
+		AllWaypoints.Add(ActorInfo.Actor);
+	}
+}
+
+bool UEDU_CORE_ReplicationGraphNode_Team::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	const int32 Index = TeamEntities.IndexOfByPredicate([&ActorInfo](const FTeamEntity& Entity) { return Entity.Actor == ActorInfo.Actor; });
+	if(Index == INDEX_NONE) return false;
+
+	if(TeamEntities[Index].Waypoint)
+	{
+		AllWaypoints.RemoveFast(ActorInfo.Actor);
+	}
+	TeamEntities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+
+	// Team lists may still hold the actor, rebuild them on the next gather.
+	for(uint32& Frame : TeamListFrames)
+	{
+		Frame = MAX_uint32;
+	}
+	return true;
+}
+
+void UEDU_CORE_ReplicationGraphNode_Team::NotifyResetAllNetworkActors()
+{
+	TeamEntities.Reset();
+	AllWaypoints.Reset();
+	for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+	{
+		TeamLists[TeamIndex].Reset();
+		TeamListFrames[TeamIndex] = MAX_uint32;
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_Team::BuildTeamList(const EEDU_CORE_Team Team, const uint32 FrameNum)
+{ // FLOW_LOG
+	const int32 TeamIndex = static_cast<int32>(Team);
+	if(TeamListFrames[TeamIndex] == FrameNum) return;
+
+	FActorRepListRefView& TeamList = TeamLists[TeamIndex];
+	TeamList.Reset(TeamEntities.Num());
+
+	for(const FTeamEntity& Entity : TeamEntities)
+	{
+		const bool bRelevant = Entity.Waypoint
+			? Entity.Waypoint->GetWaypointTeam() == Team
+			: Entity.StatusComponent && Entity.StatusComponent->GetActiveTeam() == Team;
+
+		if(bRelevant)
+		{
+			TeamList.Add(Entity.Actor);
+		}
+	}
+
+	TeamListFrames[TeamIndex] = FrameNum;
+}
+
+void UEDU_CORE_ReplicationGraphNode_Team::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{ // FLOW_LOG
+	FTeamVisibility::FTeamMask GatheredTeams = 0;
+	bool bGatheredAll = false;
+
+	for(const FNetViewer& Viewer : Params.Viewers)
+	{
+		const EEDU_CORE_Team Team = EDU_CORE_ReplicationGraph::GetViewerTeam(Viewer);
+
+		// Spectators, and viewers we don't know the team of, see every waypoint.
+		if(!FTeamVisibility::IsValidTeam(Team))
+		{
+			if(!bGatheredAll)
+			{
+				Params.OutGatheredReplicationLists.AddReplicationActorList(AllWaypoints);
+				bGatheredAll = true;
+			}
+			continue;
+		}
+
+		const FTeamVisibility::FTeamMask TeamBit = FTeamVisibility::GetTeamBit(Team);
+		if(GatheredTeams & TeamBit) continue;
+
+		BuildTeamList(Team, Params.ReplicationFrameNum);
+		Params.OutGatheredReplicationLists.AddReplicationActorList(TeamLists[static_cast<int32>(Team)]);
+		GatheredTeams |= TeamBit;
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_Team::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(NodeName);
+	DebugInfo.PushIndent();
+
+	LogActorRepList(DebugInfo, TEXT("Waypoints"), AllWaypoints);
+	for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+	{
+		if(TeamLists[TeamIndex].Num() > 0)
+		{
+			LogActorRepList(DebugInfo, FString::Printf(TEXT("Team %d"), TeamIndex), TeamLists[TeamIndex]);
+		}
+	}
+
+	DebugInfo.PopIndent();
+}
+
+//------------------------------------------------------------------------------
+// Team Grid Node
+//------------------------------------------------------------------------------
+
+UEDU_CORE_ReplicationGraphNode_TeamGrid::UEDU_CORE_ReplicationGraphNode_TeamGrid()
+{
+	// Membership follows visibility, and the grids move their dynamic actors.
+	bRequiresPrepareForReplicationCall = true;
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::InitGrids(const float CellSize, const FVector2D& SpatialBias)
+{
+	Grids.Reset(SpectatorGrid + 1);
+	for(int32 GridIndex = 0; GridIndex <= SpectatorGrid; ++GridIndex)
+	{
+		UReplicationGraphNode_GridSpatialization2D* Grid = CreateChildNode<UReplicationGraphNode_GridSpatialization2D>();
+		Grid->CellSize = CellSize;
+		Grid->SpatialBias = SpatialBias;
+		Grids.Add(Grid);
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::AddToGrid(const int32 GridIndex, const FGridEntity& Entity) const
+{
+	const FNewReplicatedActorInfo ActorInfo(Entity.Actor);
+	FGlobalActorReplicationInfo& GlobalInfo = GraphGlobals->GlobalActorReplicationInfoMap->Get(Entity.Actor);
+
+	if(Entity.bDynamic)
+	{
+		Grids[GridIndex]->AddActor_Dynamic(ActorInfo, GlobalInfo);
+	}
+	else
+	{
+		Grids[GridIndex]->AddActor_Static(ActorInfo, GlobalInfo);
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::RemoveFromGrid(const int32 GridIndex, const FGridEntity& Entity) const
+{
+	const FNewReplicatedActorInfo ActorInfo(Entity.Actor);
+
+	if(Entity.bDynamic)
+	{
+		Grids[GridIndex]->RemoveActor_Dynamic(ActorInfo);
+	}
+	else
+	{
+		Grids[GridIndex]->RemoveActor_Static(ActorInfo);
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const AEDU_CORE_PhysicsEntity* PhysicsEntity = Cast<AEDU_CORE_PhysicsEntity>(ActorInfo.Actor);
+	if(!PhysicsEntity) return;
+
+	FGridEntity& Entity = Entities.AddDefaulted_GetRef();
+	Entity.Actor = ActorInfo.Actor;
+	Entity.StatusComponent = PhysicsEntity->GetStatusComponent();
+	Entity.GracePeriod = PhysicsEntity->NetRelevancyGracePeriod;
+	Entity.bDynamic = PhysicsEntity->IsRootComponentMovable();
+
+	// Team grids are filled by PrepareForReplication, once a team sees the entity.
+	AddToGrid(SpectatorGrid, Entity);
+}
+
+bool UEDU_CORE_ReplicationGraphNode_TeamGrid::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	const int32 Index = Entities.IndexOfByPredicate([&ActorInfo](const FGridEntity& Entity) { return Entity.Actor == ActorInfo.Actor; });
+	if(Index == INDEX_NONE) return false;
+
+	const FGridEntity& Entity = Entities[Index];
+	for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+	{
+		if(Entity.InTeamGrids & (1u << TeamIndex))
+		{
+			RemoveFromGrid(TeamIndex, Entity);
+		}
+	}
+	RemoveFromGrid(SpectatorGrid, Entity);
+
+	Entities.RemoveAtSwap(Index, 1, EAllowShrinking::No);
+	return true;
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::NotifyResetAllNetworkActors()
+{
+	Entities.Reset();
+	for(UReplicationGraphNode_GridSpatialization2D* Grid : Grids)
+	{
+		Grid->NotifyResetAllNetworkActors();
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::PrepareForReplication()
+{ // FLOW_LOG
+	for(FGridEntity& Entity : Entities)
+	{
+		if(!Entity.StatusComponent) continue;
+
+		const EEDU_CORE_Team ActiveTeam = Entity.StatusComponent->GetActiveTeam();
+
+		FTeamVisibility::FTeamMask RelevantTeams = 0;
+		for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+		{
+			const EEDU_CORE_Team Team = static_cast<EEDU_CORE_Team>(TeamIndex);
+
+			// Our own team gets us from the Team node, wherever we are.
+			if(Team != ActiveTeam && Entity.StatusComponent->IsNetRelevantForTeam(Team, Entity.GracePeriod))
+			{
+				RelevantTeams |= 1u << TeamIndex;
+			}
+		}
+
+		const FTeamVisibility::FTeamMask ChangedTeams = RelevantTeams ^ Entity.InTeamGrids;
+		if(ChangedTeams == 0) continue;
+
+		for(int32 TeamIndex = 0; TeamIndex < FTeamVisibility::NumTeams; ++TeamIndex)
+		{
+			if(!(ChangedTeams & (1u << TeamIndex))) continue;
+
+			if(RelevantTeams & (1u << TeamIndex))
+			{
+				AddToGrid(TeamIndex, Entity);
+			}
+			else
+			{
+				RemoveFromGrid(TeamIndex, Entity);
+			}
+		}
+		Entity.InTeamGrids = RelevantTeams;
+	}
+
+	// Children aren't global nodes, so they're never prepared by the graph.
+	for(UReplicationGraphNode_GridSpatialization2D* Grid : Grids)
+	{
+		Grid->PrepareForReplication();
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{ // FLOW_LOG
+	uint32 GatheredGrids = 0;
+
+	for(const FNetViewer& Viewer : Params.Viewers)
+	{
+		const EEDU_CORE_Team Team = EDU_CORE_ReplicationGraph::GetViewerTeam(Viewer);
+		const int32 GridIndex = FTeamVisibility::IsValidTeam(Team) ? static_cast<int32>(Team) : SpectatorGrid;
+
+		if(GatheredGrids & (1u << GridIndex)) continue;
+
+		Grids[GridIndex]->GatherActorListsForConnection(Params);
+		GatheredGrids |= 1u << GridIndex;
+	}
+}
+
+void UEDU_CORE_ReplicationGraphNode_TeamGrid::LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const
+{
+	DebugInfo.Log(NodeName);
+	DebugInfo.PushIndent();
+
+	for(int32 GridIndex = 0; GridIndex < Grids.Num(); ++GridIndex)
+	{
+		Grids[GridIndex]->LogNode(DebugInfo, GridIndex == SpectatorGrid ? FString(TEXT("Spectators")) : FString::Printf(TEXT("Team %d"), GridIndex));
+	}
+
+	DebugInfo.PopIndent();
+}
@@ -61,6 +61,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -174,7 +177,7 @@ protected:
 
 	// This works with both Turrets and Fixed Weapons
 	template <typename WeaponComponentType>
-	int8 EvaluateTargetsInRange(TObjectPtr<WeaponComponentType>& WeaponMount, const TArray<FOverlapResult>& TargetsInRangeArray);
+	int8 EvaluateTargetsInRange(TObjectPtr<WeaponComponentType>& WeaponMount, const TArray<AActor*>& TargetsInRangeArray);
 	
 	// Searches the proximity for Viable Targets based on our furthest range.
 	void SearchForTargets(float SearchRange);
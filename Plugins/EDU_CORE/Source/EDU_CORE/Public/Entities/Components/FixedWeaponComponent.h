@@ -14,6 +14,7 @@
 
 class UEngagementComponent;
 class AEDU_CORE_MobileEntity;
+class AEDU_CORE_GameMode;
 
 /*------------------------------------------------------------------------------
   Fixed Weapon Component
@@ -68,6 +69,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -123,6 +127,10 @@ protected:
 	UPROPERTY()
 	TObjectPtr<UEngagementComponent> EngagementComponent = nullptr;
 
+	// Cached on the server in BeginPlay, owns the Line of Sight Service.
+	UPROPERTY()
+	TObjectPtr<AEDU_CORE_GameMode> GameMode = nullptr;
+
 	/*----------------------------- Targets ------------------------------
 	  We can hurt ViableTargets with at least one of our weapons,
 	  Priority Targets can hit us with at least one of their weapons.
@@ -193,5 +201,6 @@ protected:
 
 	void SortTargets(ETargetPriority InTargetPriority, TArray<TObjectPtr<AEDU_CORE_SelectableEntity>> TargetArray) const;
 
-	bool HasLineOfSight(const FVector& Vector, const FVector& TargetPos, const TObjectPtr<AEDU_CORE_SelectableEntity>& Target) const;
+	// Requests LOS to every target in range, and engages the first one in sight with NewStatus.
+	void RequestTargetInSight(const TArray<TObjectPtr<AEDU_CORE_SelectableEntity>>& TargetArray, EWeaponStatus NewStatus);
 };
@@ -68,6 +68,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -199,9 +202,9 @@ protected:
 	UPROPERTY()
 	FTransform PreviousParentTransform;
 
-	// Temp Array for for DetectActorsInFOV()
+	// Temp Array for for DetectActorsInFOV() and Listen(), filled from the Spatial Grid.
 	UPROPERTY(VisibleAnywhere)
-	TArray<FOverlapResult> SensedActorsArray;
+	TArray<AActor*> SensedActorsArray;
 	
 //------------------------------------------------------------------------------
 // Functionality
@@ -216,9 +219,8 @@ protected:
 	UFUNCTION()
 	void Listen();
 
-	// Helper function for DetectActorsInFOV() 
-	UFUNCTION()
-	bool GetVisualConfirmation(const FVector& StartLocation, const FVector& EndLocation, const AActor* ActorToConfirm) const;
+	// Helper function for DetectActorsInFOV(), sets the entity visible once the LOS trace confirms it.
+	void RequestVisualConfirmation(const FVector& StartLocation, AEDU_CORE_SelectableEntity* SelectableEntity, EEDU_CORE_Team OurTeam, UStatusComponent* TargetStatusComponent);
 	
 	//
 	void SetEntityTeamVisibility(AEDU_CORE_SelectableEntity* SelectableEntity, EEDU_CORE_Team OurTeam, UStatusComponent* TargetStatusComponent) const;
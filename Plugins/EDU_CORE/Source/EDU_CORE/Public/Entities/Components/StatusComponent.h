@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Components/ActorComponent.h"
 #include "Framework/Data/DataTypes/EDU_CORE_DataTypes.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TeamVisibility.h"
 #include "StatusComponent.generated.h"
 
 
@@ -54,10 +55,10 @@ public:
 	// Gets the team this entity currently on.
 	FORCEINLINE EEDU_CORE_Team GetActiveTeam() const { return ActiveTeam; };
 
-	// Sets visibility for a specific team for a duration.
-	void SetVisibleForTeam(EEDU_CORE_Team TeamIndex, uint8 Time = 10);
+	// Sets or clears the bit of a specific team in VisibleToTeams.
+	void SetVisibleForTeam(EEDU_CORE_Team TeamIndex, bool bVisible);
 	
-	// Gets visibility for a specific team for a duration.
+	// Gets the seconds left until a specific team loses sight of us, counted from when it last saw us.
 	uint8 GetVisibleForTeam(EEDU_CORE_Team TeamInde) const;
 	
 	// Returns the Defence against a certain damage type.
@@ -65,6 +66,12 @@ public:
 
 	// Sets visibility for a specific team using the default duration.
 	void ResetVisibilityForTeam(EEDU_CORE_Team TeamIndex);
+
+	// Called by the GameMode's expiry queue, returns when to call again, or a negative value once the team lost sight of us.
+	float UpdateVisibilityExpiry(EEDU_CORE_Team TeamIndex, float Clock);
+
+	// Server only. True while the team sees us, and for GracePeriod seconds after it lost sight of us.
+	bool IsNetRelevantForTeam(EEDU_CORE_Team TeamIndex, float GracePeriod) const;
 	
 //------------------------------------------------------------------------------
 // Construction & Init
@@ -82,6 +89,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Override GetLifetimeReplicatedProps
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
@@ -418,42 +428,35 @@ protected:
 	FReplicatedArray<uint8> FadingForTeamArray; 
 	*/
 	
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_0 = 1;
-	
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_1 = 1;
-	
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_2 = 1;
-
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_3 = 1;
-
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_4 = 1;
+	/*------------------------ Team Visibility -------------------------
+	  One bit per team that currently sees us, see FTeamVisibility. A
+	  single push model property, so the net driver only compares and
+	  sends it when a team gains or loses sight of us.
+	--------------------------------------------------------------------*/
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_5 = 1;
+	// Seconds every other team sees us after we spawn, 0 spawns hidden.
+	UPROPERTY(EditAnywhere, Category = "Defence | Visibility")
+	uint8 SpawnVisibilityTime = 1;
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_6 = 1;
+	// FTeamVisibility::FTeamMask, UHT doesn't resolve the alias.
+	UPROPERTY(VisibleAnywhere, Category = "Defence | Visibility", ReplicatedUsing = OnRep_VisibleToTeams)
+	uint16 VisibleToTeams = 0;
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_7 = 1;
+	/*----------------------- Visibility Expiry --------------------------
+	  VisibleToTeams only changes when a team gains or loses sight of
+	  us. The countdown in between is the AsyncedClock time since
+	  LastSeenByTeam, and the GameMode's expiry queue wakes us up when
+	  a team should forget us. Idle entities cost nothing.
+	---------------------------------------------------------------------*/
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_8 = 1;
+	// Server only, AsyncedClock time each team last saw us, -UE_BIG_NUMBER if never.
+	float LastSeenByTeam[FTeamVisibility::NumTeams];
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_9 = 1;
+	// Teams with an entry in the GameMode's expiry queue.
+	FTeamVisibility::FTeamMask QueuedVisibilityExpiry = 0;
 
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_10 = 1;
-
-	// This one should never be decremented.
-	UPROPERTY(EditAnywhere, Category = "Defence | Visibility| Team Timers", ReplicatedUsing = OnRep_VisibilityForTeamUpdate)
-	uint8 VisibilityForTeam_Spectator = 1;
+	// Queues the team in the GameMode, unless it's queued already.
+	void QueueVisibilityExpiry(EEDU_CORE_Team TeamIndex, float DueAt);
 	
 //--------------------------------------------------------------------------
 // Editable Data > Team setting
@@ -542,14 +545,15 @@ protected:
 //--------------------------------------------------------------------------
 // Functionality > Utility
 //--------------------------------------------------------------------------
-protected:
+public:
 	
+	// Server only
 	void ChangeTeam(EEDU_CORE_Team NewTeam);
+
+protected:
 	
 	void UpdateHostileTeams();
 
-	void VisibilityTick();
-
 //------------------------------------------------------------------------------
 // Network Functionality
 //------------------------------------------------------------------------------
@@ -559,9 +563,12 @@ protected:
 	UFUNCTION()
 	void CheckLocalPlayer();
 
-	// Sets visibility on the Clients, reacting to VisibilityForTeam
+	// Sets visibility on the Clients, reacting to VisibleToTeams
 	UFUNCTION()
-	void OnRep_VisibilityForTeamUpdate() const;
+	void OnRep_VisibleToTeams() const;
+
+	// Hides the owner unless the team of the local camera is in VisibleToTeams.
+	void ApplyLocalVisibility() const;
 
 	// Sets visibility on the Listen Server without replicating to clients
 	UFUNCTION(Server, Unreliable)
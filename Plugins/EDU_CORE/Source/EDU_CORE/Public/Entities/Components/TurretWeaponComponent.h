@@ -13,6 +13,8 @@
 #include "TurretWeaponComponent.generated.h"
 
 class UEngagementComponent;
+class AEDU_CORE_GameMode;
+struct FLineOfSightTarget;
 
 /*------------------------------------------------------------------------------
   Turret Wepon component
@@ -68,6 +70,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the owner is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -147,6 +152,10 @@ protected:
 	UPROPERTY()
 	TObjectPtr<UEngagementComponent> EngagementComponent = nullptr;
 
+	// Cached on the server in BeginPlay, owns the Line of Sight Service.
+	UPROPERTY()
+	TObjectPtr<AEDU_CORE_GameMode> GameMode = nullptr;
+
 	// Cached references to the turretMount that the barrel attaches to.
 	UPROPERTY()
 	TObjectPtr<UStaticMeshComponent> TurretMountMesh;
@@ -246,6 +255,11 @@ protected:
 
 	void SortTargets(TArray<TObjectPtr<AEDU_CORE_SelectableEntity>>& TargetArray) const;
 	
-	bool HasLineOfSight(const FVector& StartPos, const FVector& EndPos,	const TObjectPtr<AEDU_CORE_SelectableEntity>& Target) const;
+	// Forgets deleted and out of range targets, and adds the rest to the LOS request in order.
+	void GatherLineOfSightTargets(TArray<TObjectPtr<AEDU_CORE_SelectableEntity>>& TargetArray, const FVector& MyPos,
+		TArray<AEDU_CORE_SelectableEntity*>& OutCandidates, TArray<FLineOfSightTarget>& OutTargets);
+
+	// Called when no target passed the LOS check, drops the target after 10 tries.
+	void OnNoTargetFound();
 	
 };
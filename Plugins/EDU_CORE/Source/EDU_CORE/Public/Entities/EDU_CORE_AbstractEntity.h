@@ -21,6 +21,9 @@ class EDU_CORE_API AEDU_CORE_AbstractEntity : public AActor
 //------------------------------------------------------------------------------
 public:
 	virtual void BeginPlay() override;
+
+	// Removes the entity from the aggregated tick
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	
 	// Called every frame by GameMode (Only exists on the Server)
 	virtual void ServerTick(float DeltaTime);
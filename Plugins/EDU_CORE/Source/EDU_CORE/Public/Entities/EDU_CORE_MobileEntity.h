@@ -16,9 +16,13 @@ class AEDU_CORE_C2_Camera;
 
 class UPhysicalMaterial;
 class USphereComponent;
+class UTurretWeaponComponent;
 
 class UNavigationPath;
 class UNavigationSystemV1;
+class ANavigationData;
+class FFlowFieldService;
+class FNavPathCache;
 
 /*------------------------------------------------------------------------------
   Abstract SUPER Class intended to be inherited from.
@@ -107,6 +111,8 @@ protected:
 	
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //------------------------------------------------------------------------------
 // Aggregated Server tick
 //------------------------------------------------------------------------------
@@ -119,6 +125,21 @@ public:
 
 	// Gamethread; Running 1/frame
 	virtual void ServerMobileExec(float DeltaTime, int32 CurrentBatchIndex);
+
+	// Gamethread; Running 2/sec, only while sleeping
+	virtual void ServerSleepingExec();
+
+	/*-------------------------------- Sleep ---------------------------------------
+	  Parked entities with no orders and no armed turret go to sleep after
+	  TimeBeforeSleep: they leave the per-frame lanes and go net dormant.
+	  Orders, damage, physics waking the body, being pushed further than
+	  WakeDisplacement or a turret arming wakes them again.
+	------------------------------------------------------------------------------*/
+
+	// Server only, safe to call from any game thread code.
+	void ServerWake();
+
+	FORCEINLINE bool IsServerSleeping() const { return bServerSleeping; }
 	
 //------------------------------------------------------------------------------
 // Public API
@@ -132,6 +153,11 @@ public:
 	// Waypoint needs to update listeners about FormationLocation whenever an entity leaves the formation.
 	virtual void UpdateFormationLocation(const FWaypointParams& Params);
 
+	// Called by Waypoint with its group path, see AEDU_CORE_Waypoint::JoinGroupPath. Paths on our own when Corridor is empty.
+	void FollowGroupPath(const AEDU_CORE_Waypoint* Waypoint, const TArray<FVector>& Corridor);
+
+	FORCEINLINE const FNavAgentProperties& GetNavAgentProperties() const { return NavAgentProperties; }
+
 	// Get Batch Index from GameMode
 	virtual void UpdateBatchIndex(const int32 ServerBatchIndex);
 	
@@ -180,6 +206,19 @@ protected:
 	// Properties of representation of an 'agent' used by AI navigation/pathfinding.
 	FNavAgentProperties NavAgentProperties;
 
+	// Server only, owned by the GameMode.
+	const FFlowFieldService* FlowFields = nullptr;
+
+	// Server only, owned by the GameMode. Checked before every path request.
+	FNavPathCache* PathCache = nullptr;
+
+	// Waypoint whose flow field we steer by, nullptr when we follow NavPointArray.
+	const UObject* FlowFieldOwner = nullptr;
+
+	// Written once per Calc, only valid while bHasFlowFieldDirection.
+	FVector FlowFieldDirection = FVector::ZeroVector;
+	bool bHasFlowFieldDirection = false;
+
 //------------------------------------------------------------------------------
 // Components: Physics
 //------------------------------------------------------------------------------
@@ -384,6 +423,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "Movement | Navigation")
 	float NavWalkingSearchHeightScale = 0.5f;
 
+	// Closer than this to FormationLocation, we stop steering by the flow field and head straight there.
+	UPROPERTY(EditAnywhere, Category = "Movement | Navigation", meta = (ClampMin = "0", Units = "cm"))
+	float FlowFieldExitDistance = 1500.f;
+
 	//---------------------------------------------
 	// TargetData
 	//---------------------------------------------
@@ -402,6 +445,39 @@ protected:
 
 	// We use a DeltaTimer for functions that need a Realtime Delay.
 	float DeltaTimer;
+
+	//---------------------------------------------
+	// Sleep
+	//---------------------------------------------
+	UPROPERTY(EditAnywhere, Category = "Sleep")
+	bool bCanSleep = true;
+
+	// Seconds we have to be idle before we sleep.
+	UPROPERTY(EditAnywhere, Category = "Sleep", meta = (EditCondition = "bCanSleep", ClampMin = "0", Units = "s"))
+	float TimeBeforeSleep = 2.f;
+
+	// Slower than this counts as standing still.
+	UPROPERTY(EditAnywhere, Category = "Sleep", meta = (EditCondition = "bCanSleep", ClampMin = "0", Units = "CentimetersPerSecond"))
+	float SleepSpeedThreshold = 1.f;
+
+	// How far we can be pushed while sleeping before we wake up.
+	UPROPERTY(EditAnywhere, Category = "Sleep", meta = (EditCondition = "bCanSleep", ClampMin = "0", Units = "cm"))
+	float WakeDisplacement = 20.f;
+
+	// Armed turrets rotate, which has to replicate.
+	UPROPERTY()
+	TArray<TObjectPtr<UTurretWeaponComponent>> TurretComponents;
+
+	bool bServerSleeping = false;
+	float IdleTime = 0.f;
+	FVector SleepLocation = FVector::ZeroVector;
+
+	bool CanSleep() const;
+	bool HasArmedTurret() const;
+	void ServerSleep();
+
+	UFUNCTION()
+	void OnPhysicsWake(UPrimitiveComponent* WakingComponent, FName BoneName);
 	
 	//---------------------------------------------
 	// Navigation Data
@@ -587,6 +663,12 @@ protected:
 	// Execute AsyncPath
 	void OnRequestPathAsyncComplete(uint32 RequestID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
 
+	// Fills NavPointArray from the path cache, false on a miss.
+	bool FindCachedPath(const ANavigationData* NavData, const FVector& StartPos, const FVector& EndPos);
+
+	// Joins the group path of our first waypoint, or requests our own path to FormationLocation.
+	void RequestFormationPath();
+
 //------------------------------------------------------------------------------
 // Legacy stuff (Deprecated)
 //------------------------------------------------------------------------------
@@ -4,10 +4,43 @@
 
 #include "CoreMinimal.h"
 #include "EDU_CORE_SelectableEntity.h"
+#include "EDU_CORE_QuantizedMovement.h"
 #include "EDU_CORE_PhysicsEntity.generated.h"
 
 class UPrimitiveComponent;
 
+/*------------------------------------------------------------------------------
+  How often the local client updates an entity, bucketed by the
+  PlayerController every SignificanceUpdateInterval.
+------------------------------------------------------------------------------*/
+UENUM(BlueprintType)
+enum class EEDU_CORE_ClientSignificance : uint8
+{
+	// Close and on screen, every frame.
+	Full		UMETA(DisplayName = "Full"),
+
+	// On screen but far away, every ReducedUpdateInterval frames.
+	Reduced		UMETA(DisplayName = "Reduced"),
+
+	// Off screen or past FrozenDistance, not updated.
+	Frozen		UMETA(DisplayName = "Frozen"),
+
+	// Hidden by the fog of war, not updated. Snaps to the snapshot buffer when revealed.
+	Hidden		UMETA(DisplayName = "Hidden"),
+};
+
+// Written by ClientPhysicsCalc on a worker thread, applied by ClientPhysicsExec on the game thread.
+struct FClientPhysicsTransform
+{
+	FVector Location;
+	FQuat Rotation;
+	FVector Scale;
+
+	// Nothing is applied when both are false.
+	bool bMoved = false;
+	bool bScaled = false;
+};
+
 /*------------------------------------------------------------------------------
   Abstract SUPER Class intended to be inherited from.
 --------------------------------------------------------------------------------
@@ -31,8 +64,14 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Removes the entity from the aggregated tick
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Override GetLifetimeReplicatedProps
 	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Only relevant to connections whose team sees us, see bTeamNetRelevancy.
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
 	
 //------------------------------------------------------------------------------
 // Components
@@ -52,6 +91,11 @@ public:
 	//--------------------------------------------------------------
 
 	FORCEINLINE TObjectPtr<UPrimitiveComponent> GetPhysicsComponent() const { return PhysicsComponent; };
+
+	// Client only, effects and animations should update as often as this allows.
+	UFUNCTION(BlueprintPure, Category = "Replicated, Client - Sided, Physics tick")
+	FORCEINLINE EEDU_CORE_ClientSignificance GetClientSignificance() const { return ClientSignificance; }
+	FORCEINLINE void SetClientSignificance(const EEDU_CORE_ClientSignificance Significance) { ClientSignificance = Significance; }
 	
 	//--------------------------------------------------------------
 	// Server Aggregated Tick
@@ -85,49 +129,90 @@ public:
 		meta = (DisplayName = "Linear Interpolation for scale",
 		ToolTip = "Smooths sale client-side, inbetween server updates. Only turn this on if you expect this entity's hitbox to change scale or shape during play."))
 	bool bLerpScale;
+
+	UPROPERTY(EditDefaultsOnly,
+		Category = "Line of Sight",
+		meta = (DisplayName = "Blocks Line of Sight",
+		ToolTip = "Large entities that hide others, like vehicles or walls. Cached LOS answers near the entity are dropped when it moves, spawns or is destroyed."))
+	bool bBlocksLineOfSight = false;
+
+	// How far a blocking entity moves before cached LOS answers around it are dropped.
+	UPROPERTY(EditDefaultsOnly, Category = "Line of Sight", meta = (EditCondition = "bBlocksLineOfSight", ClampMin = "0"))
+	float LineOfSightInvalidationDistance = 200.f;
 	
-	// Interpolate towards the replicated transform.
-	FVector StartLocation;
-	FRotator StartRotation;
-	FVector StartScale;
-	
-	float BlendDuration_Location = 0.f;
-	float BlendDuration_Rotation = 0.f;
-	float BlendDuration_Scale = 0.f;
-
-	// Elapsed time since the blend started.
-	float ElapsedTime_Location = 0.f;	
-	float ElapsedTime_Rotation = 0.f;
-	float ElapsedTime_Scale = 0.f;
-	
-	FQuat StartQuat;
-	FQuat TargetQuat;
+	UPROPERTY(EditDefaultsOnly,
+		Category = "Replicated, Client - Sided, Physics tick",
+		meta = (DisplayName = "Team based network relevancy",
+		ToolTip = "Only replicates this entity to connections whose team currently sees it. Hidden enemies are never sent, which saves bandwidth and keeps their positions from cheaters."))
+	bool bTeamNetRelevancy = true;
 
-	// Called by PlayerController on the client.
-	void ClientLerpLocation(float DeltaTime);
-	void ClientLerpRotation(float DeltaTime);
-	void ClientLerpScale(float DeltaTime);
+	// How far the entity has to move before the server sends a new transform.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (ClampMin = "0", Units = "cm"))
+	float ReplicatedLocationThreshold = 2.f;
 
-private:
-	// Variables to replicate
-	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedLocation)
-	FVector_NetQuantize10 Rep_Location;
+	// How far the entity has to turn before the server sends a new transform.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (ClampMin = "0", Units = "deg"))
+	float ReplicatedRotationThreshold = 0.5f;
+
+	// How much any axis has to scale before the server sends a new transform.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (ClampMin = "0"))
+	float ReplicatedScaleThreshold = 0.01f;
+
+	// Seconds an entity stays relevant after the team lost sight of it, on top of the VisibilityTimer.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (EditCondition = "bTeamNetRelevancy", ClampMin = "0"))
+	float NetRelevancyGracePeriod = 2.f;
+
+	// Where cached LOS answers were last dropped for this entity.
+	FVector LastLineOfSightLocation = FVector::ZeroVector;
+
+	// Server only, drops cached LOS answers around Location.
+	void InvalidateLineOfSight(const FVector& Location) const;
 	
-	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedRotation)
-	FRotator Rep_Rotation;
+	// How far behind the server clients render, should cover two updates so there's always a snapshot ahead.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (ClampMin = "0", Units = "s"))
+	float InterpolationDelay = 0.2f;
 
-	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedScale)
-	FVector_NetQuantize10 Rep_Scale;
+	// How long clients keep moving along the last known velocity when snapshots are late.
+	UPROPERTY(EditDefaultsOnly, Category = "Replicated, Client - Sided, Physics tick", meta = (ClampMin = "0", Units = "s"))
+	float MaxExtrapolationTime = 0.25f;
 
-	// On Replication
-	UFUNCTION()
-	void OnRep_ReplicatedLocation();
+	//--------------------------------------------------------------
+	// Client Aggregated Tick, see AEDU_CORE_PlayerController::PlayerTick
+	//--------------------------------------------------------------
 
-	UFUNCTION()
-	void OnRep_ReplicatedRotation();
+	// Thread safe, samples the snapshot buffer. Hidden entities and entities already at their target are skipped.
+	void ClientPhysicsCalc(double ServerTime, FClientPhysicsTransform& OutTransform) const;
+
+	// Game thread, applies what ClientPhysicsCalc changed.
+	void ClientPhysicsExec(const FClientPhysicsTransform& Transform);
+
+private:
+	// Push model, only written when the transform moved past the Replicated thresholds.
+	// <!> Only compared when dirty with net.IsPushModelEnabled and bWithPushModel, see DefaultEngine.ini and the targets.
+	UPROPERTY(ReplicatedUsing = OnRep_ReplicatedMovement)
+	FQuantizedMovement Rep_Movement;
+
+	// Client only, written by the PlayerController.
+	EEDU_CORE_ClientSignificance ClientSignificance = EEDU_CORE_ClientSignificance::Full;
+
+	// Server only, whether the last Rep_Movement was restamped after the entity stopped.
+	bool bRepMovementAtRest = false;
 
+	// Adds the new transform to the snapshot buffer.
 	UFUNCTION()
-	void OnRep_ReplicatedScale();
+	void OnRep_ReplicatedMovement();
+
+	/*--------------------------- Snapshot Buffer ---------------------------------
+	  The last replicated transforms, oldest first, ordered by ServerTime.
+	  Clients render InterpolationDelay behind the server, between the two
+	  snapshots around that time. When the newest snapshot is older than that,
+	  they extrapolate from the newest two for at most MaxExtrapolationTime.
+	------------------------------------------------------------------------------*/
+	static constexpr int32 SnapshotCapacity = 8;
+	TArray<FQuantizedMovement, TInlineAllocator<SnapshotCapacity>> Snapshots;
+
+	// Blend between Snapshots[OutFrom] and Snapshots[OutTo], OutAlpha past 1 extrapolates.
+	bool FindSnapshots(double ServerTime, int32& OutFrom, int32& OutTo, float& OutAlpha) const;
 	
 //------------------------------------------------------------------------------
 // Functionality
@@ -0,0 +1,55 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EDU_CORE_QuantizedMovement.generated.h"
+
+/*------------------------------------------------------------------------------
+  Quantized Movement
+--------------------------------------------------------------------------------
+  The replicated transform of a PhysicsEntity, one property instead of three,
+  with a custom NetSerialize:
+
+	Location:	Whole centimeters from the world origin, packed to the bits
+				the magnitude needs.
+	Rotation:	Smallest three, the largest quaternion component is dropped
+				and rebuilt from the other three, 2 + 3 x 10 bits.
+	Scale:		One bit when it's (1, 1, 1), which it almost always is.
+	ServerTime:	World time on the server when the transform was taken.
+
+  The server only writes it when the transform moved past the entity's
+  thresholds, so jitter never dirties the property.
+------------------------------------------------------------------------------*/
+
+USTRUCT()
+struct EDU_CORE_API FQuantizedMovement
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FQuat Rotation = FQuat::Identity;
+
+	UPROPERTY()
+	FVector Scale = FVector::OneVector;
+
+	UPROPERTY()
+	float ServerTime = 0.f;
+
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	// Bits per smallest three component.
+	static constexpr int32 RotationBits = 10;
+};
+
+template<>
+struct TStructOpsTypeTraits<FQuantizedMovement> : public TStructOpsTypeTraitsBase2<FQuantizedMovement>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -44,6 +44,9 @@ public:
 
 	virtual void BeginPlay() override;
 
+	// Releases the ServerEntityID
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 //---------------------------------------------------------------
 // Get/Set
 //--------------------------------------------------------------
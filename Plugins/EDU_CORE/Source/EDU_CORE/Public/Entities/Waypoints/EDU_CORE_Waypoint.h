@@ -4,12 +4,14 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "AI/Navigation/NavigationTypes.h"
 
 #include "Framework/Data/DataTypes/EDU_CORE_DataTypes.h"
 #include "Entities/EDU_CORE_SelectableEntity.h"
 #include "EDU_CORE_Waypoint.generated.h"
 
 class AEDU_CORE_SelectableEntity;
+class AEDU_CORE_MobileEntity;
 
 /*------------------------------------------------------------------------------
   Abstract SUPER Class intended to be inherited from.
@@ -50,6 +52,27 @@ public:
 	// Notifies a listener in the ListenerArray that they need to save this waypoint in their WaypointArray.
 	void NotifyListeners();
 
+	/*------------------------------- Group Path ----------------------------------
+	  NotifyListeners asks the NavSystem for one path, from the centroid of the
+	  listeners to the waypoint, instead of one per listener. MobileEntities
+	  that start within GroupPathJoinRadius of the centroid offset that
+	  corridor towards their FormationLocation, see
+	  AEDU_CORE_MobileEntity::FollowGroupPath. The corridor is planned for the
+	  agent of the first MobileEntity listener, members with other agent
+	  properties and everyone else path on their own.
+	------------------------------------------------------------------------------*/
+
+	// Game thread, true if Member gets its path from the corridor, now or once it's found.
+	bool JoinGroupPath(AEDU_CORE_MobileEntity* Member);
+
+	/*------------------------------- Flow Field ----------------------------------
+	  Groups of FlowFieldMinListeners or more, and groups sent at a common
+	  TargetPosition, skip paths altogether and steer by a GameMode flow field
+	  owned by this waypoint. See EDU_CORE_FlowFieldService.h
+	------------------------------------------------------------------------------*/
+
+	FORCEINLINE bool UsesFlowField() const { return bUsesFlowField; }
+
 	// What team does this waypoint belong to?
 	void SetTeam(const EEDU_CORE_Team NewTeam) { Params.WaypointTeam = NewTeam; };
 
@@ -71,6 +94,7 @@ public:
 	// Getters
 	FORCEINLINE FWaypointParams GetWaypointParams()					 const	{ return Params; };
 	FORCEINLINE FGuid GetWaypointID()								 const	{ return WaypointID; };
+	FORCEINLINE EEDU_CORE_Team GetWaypointTeam()					 const	{ return Params.WaypointTeam; };
 	
 	FORCEINLINE bool IsPatrolPoint()								 const	{ return Params.bPatrolPoint; } ;
 	FORCEINLINE FVector GetTargetPosition()							 const	{ return Params.TargetPosition; }
@@ -111,6 +135,43 @@ protected:
 	UPROPERTY(VisibleAnywhere)
 	TArray<TObjectPtr<AEDU_CORE_SelectableEntity>> ListenerArray;
 
+	// Listeners further than this from the centroid path on their own.
+	UPROPERTY(EditDefaultsOnly, Category = "Group Path", meta = (ClampMin = "0", Units = "cm"))
+	float GroupPathJoinRadius = 2500.f;
+
+	// Fewer listeners than this path on their own.
+	UPROPERTY(EditDefaultsOnly, Category = "Group Path", meta = (ClampMin = "1"))
+	int32 GroupPathMinListeners = 2;
+
+	// This many listeners or more steer by a flow field instead of the group path.
+	UPROPERTY(EditDefaultsOnly, Category = "Flow Field", meta = (ClampMin = "1"))
+	int32 FlowFieldMinListeners = 24;
+
+private:
+	// Starts the corridor query, drops any previous corridor.
+	void RequestGroupPath();
+
+	// Hands the corridor to everyone waiting for it, an empty one when the query failed.
+	void OnGroupPathComplete(uint32 RequestID, ENavigationQueryResult::Type Result, FNavPathSharedPtr Path);
+
+	// Centroid first, waypoint last.
+	TArray<FVector> GroupPath;
+	FVector GroupPathStart = FVector::ZeroVector;
+
+	// The agent the corridor was planned for, only equivalent members can join.
+	FNavAgentProperties GroupPathAgent;
+
+	// Set while the query is running, answers to older queries are ignored.
+	uint32 GroupPathRequestID = INVALID_NAVQUERYID;
+
+	// Joined while the query was running.
+	TArray<TWeakObjectPtr<AEDU_CORE_MobileEntity>> GroupPathMembers;
+
+	// Requests our flow field, or releases it when we don't need one.
+	void RequestFlowField();
+
+	bool bUsesFlowField = false;
+
 //------------------------------------------------------------------------------
 // Replication
 //------------------------------------------------------------------------------
@@ -0,0 +1,60 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "EDU_CORE_ScalingBenchmarkCommandlet.generated.h"
+
+class AEDU_CORE_GameMode;
+class AEDU_CORE_MobileEntity;
+
+/*------------------------------------------------------------------------------
+  Headless scaling benchmark for the aggregated tick.
+--------------------------------------------------------------------------------
+  For every unit count, loads the map without rendering, spawns the units
+  split across teams, orders half of each team to move to the center and the
+  other half to attack an enemy, then ticks a fixed number of AsyncedClock
+  seconds and records the frame and every tick lane.
+
+  Results are written as CSV, one row per unit count and channel, so scaling
+  curves can be compared between builds. Lane times only count the frames
+  the lane ran, Ran (%) is how many of them that was.
+
+  Usage:
+	UnrealEditor-Cmd <Project>.uproject -run=EDU_CORE_ScalingBenchmark -nullrhi -unattended
+		-Map=/Game/Maps/Benchmark				(required)
+		-UnitClass=/Game/Units/BP_Unit.BP_Unit_C	(required, an AEDU_CORE_MobileEntity)
+		-GameMode=/Game/Modes/BP_GameMode.BP_GameMode_C	(optional, else the map's GameMode)
+		-Counts=100,500,1000,5000,10000
+		-Teams=2
+		-Seconds=30
+		-Output=<Saved/Profiling/ScalingBenchmark_<Date>.csv>
+------------------------------------------------------------------------------*/
+
+UCLASS()
+class EDU_CORE_API UEDU_CORE_ScalingBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UEDU_CORE_ScalingBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+//------------------------------------------------------------------------------
+// Functionality
+//------------------------------------------------------------------------------
+protected:
+	UWorld* CreateBenchmarkWorld(const FString& MapPath, const FString& GameModePath) const;
+	void DestroyBenchmarkWorld(UWorld* World) const;
+
+	// Spawns the units in one block per team, facing each other across the map origin.
+	void SpawnUnits(UWorld* World, UClass* UnitClass, int32 UnitCount, int32 TeamCount, TArray<TArray<AEDU_CORE_MobileEntity*>>& OutTeams) const;
+
+	// Half of every team moves to the center, the other half attacks the next team.
+	void IssueOrders(AEDU_CORE_GameMode* GameMode, const TArray<TArray<AEDU_CORE_MobileEntity*>>& Teams) const;
+
+	// Ticks the world and appends one CSV row per channel.
+	void RunBenchmark(UWorld* World, AEDU_CORE_GameMode* GameMode, int32 UnitCount, int32 Frames, FString& CSV) const;
+};
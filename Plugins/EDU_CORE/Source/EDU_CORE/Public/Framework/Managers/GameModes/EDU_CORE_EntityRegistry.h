@@ -0,0 +1,182 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+
+/*------------------------------------------------------------------------------
+  Entity Registry
+--------------------------------------------------------------------------------
+  Holds the members of one aggregated tick array. Members are stored densely,
+  so lanes can iterate them without holes or null checks, and every member
+  gets a stable handle that survives other members being removed.
+
+	Add:	O(1), adding an already registered member returns its handle.
+	Remove:	O(1), the last member is swapped into the hole.
+
+  The dense order is not stable, only the handle is. Never unregister from
+  inside a parallel Calc, do it from EndPlay on the game thread.
+
+  While the registry is locked, Remove only queues the member, so an Exec
+  that destroys an actor doesn't swap another member past the lane's index.
+  The queue is applied by Unlock.
+------------------------------------------------------------------------------*/
+
+struct FEntityHandle
+{
+	int32 Slot = INDEX_NONE;
+	uint32 Generation = 0;
+
+	bool IsValid() const { return Slot != INDEX_NONE; }
+
+	bool operator==(const FEntityHandle& Other) const { return Slot == Other.Slot && Generation == Other.Generation; }
+	bool operator!=(const FEntityHandle& Other) const { return !(*this == Other); }
+};
+
+template<typename ElementType>
+class TEntityRegistry
+{
+public:
+	void Reserve(const int32 Number)
+	{
+		Dense.Reserve(Number);
+		DenseToSlot.Reserve(Number);
+		Slots.Reserve(Number);
+		SlotLookup.Reserve(Number);
+	}
+
+	FEntityHandle Add(ElementType* Element)
+	{
+		if(!Element) return FEntityHandle();
+
+		if(const int32* ExistingSlot = SlotLookup.Find(Element))
+		{
+			PendingRemovals.RemoveSwap(Element, EAllowShrinking::No);
+			return FEntityHandle{ *ExistingSlot, Slots[*ExistingSlot].Generation };
+		}
+
+		// Recycle a slot from a removed member, or create a new one
+		const int32 Slot = FreeSlots.Num() > 0 ? FreeSlots.Pop(EAllowShrinking::No) : Slots.AddDefaulted();
+
+		Slots[Slot].DenseIndex = Dense.Add(Element);
+		DenseToSlot.Add(Slot);
+		SlotLookup.Add(Element, Slot);
+
+		return FEntityHandle{ Slot, Slots[Slot].Generation };
+	}
+
+	bool Remove(const ElementType* Element)
+	{
+		const int32* Slot = SlotLookup.Find(Element);
+		if(!Slot) return false;
+
+		if(LockCount > 0)
+		{
+			PendingRemovals.AddUnique(Element);
+			return true;
+		}
+		return RemoveSlot(*Slot);
+	}
+
+	bool Remove(const FEntityHandle& Handle)
+	{
+		return Contains(Handle) ? Remove(Dense[Slots[Handle.Slot].DenseIndex].Get()) : false;
+	}
+
+	// Keeps the dense array stable while a lane iterates it, see above.
+	void Lock() { ++LockCount; }
+
+	void Unlock()
+	{
+		check(LockCount > 0);
+		if(--LockCount > 0) return;
+
+		for(const ElementType* Element : PendingRemovals)
+		{
+			if(const int32* Slot = SlotLookup.Find(Element))
+			{
+				RemoveSlot(*Slot);
+			}
+		}
+		PendingRemovals.Reset();
+	}
+
+	bool Contains(const FEntityHandle& Handle) const
+	{
+		return Slots.IsValidIndex(Handle.Slot)
+			&& Slots[Handle.Slot].Generation == Handle.Generation
+			&& Slots[Handle.Slot].DenseIndex != INDEX_NONE;
+	}
+
+	ElementType* Get(const FEntityHandle& Handle) const
+	{
+		return Contains(Handle) ? Dense[Slots[Handle.Slot].DenseIndex].Get() : nullptr;
+	}
+
+	FEntityHandle FindHandle(const ElementType* Element) const
+	{
+		const int32* Slot = SlotLookup.Find(Element);
+		return Slot ? FEntityHandle{ *Slot, Slots[*Slot].Generation } : FEntityHandle();
+	}
+
+	// Current position in the dense array, changes when other members are removed.
+	int32 GetDenseIndex(const ElementType* Element) const
+	{
+		const int32* Slot = SlotLookup.Find(Element);
+		return Slot ? Slots[*Slot].DenseIndex : INDEX_NONE;
+	}
+
+	int32 Num() const { return Dense.Num(); }
+
+	// Every registered member, no holes, no nullptr.
+	TArray<TObjectPtr<ElementType>>& GetDense() { return Dense; }
+	const TArray<TObjectPtr<ElementType>>& GetDense() const { return Dense; }
+
+	// Keeps members alive for GC, like the UPROPERTY arrays this replaces.
+	void AddReferencedObjects(FReferenceCollector& Collector)
+	{
+		Collector.AddReferencedObjects(Dense);
+	}
+
+private:
+	bool RemoveSlot(const int32 Slot)
+	{
+		const int32 DenseIndex = Slots[Slot].DenseIndex;
+		const int32 LastIndex = Dense.Num() - 1;
+
+		SlotLookup.Remove(Dense[DenseIndex].Get());
+
+		// Move the last member into the hole, and fix up its slot
+		if(DenseIndex != LastIndex)
+		{
+			Dense[DenseIndex] = Dense[LastIndex];
+			DenseToSlot[DenseIndex] = DenseToSlot[LastIndex];
+			Slots[DenseToSlot[DenseIndex]].DenseIndex = DenseIndex;
+		}
+		Dense.Pop(EAllowShrinking::No);
+		DenseToSlot.Pop(EAllowShrinking::No);
+
+		// Invalidate any handle still pointing at this slot
+		Slots[Slot].DenseIndex = INDEX_NONE;
+		++Slots[Slot].Generation;
+		FreeSlots.Add(Slot);
+
+		return true;
+	}
+
+	struct FSlot
+	{
+		int32 DenseIndex = INDEX_NONE;
+		uint32 Generation = 0;
+	};
+
+	TArray<TObjectPtr<ElementType>> Dense;
+	TArray<int32> DenseToSlot;
+	TArray<FSlot> Slots;
+	TArray<int32> FreeSlots;
+	TMap<const ElementType*, int32> SlotLookup;
+
+	TArray<const ElementType*> PendingRemovals;
+	int32 LockCount = 0;
+};
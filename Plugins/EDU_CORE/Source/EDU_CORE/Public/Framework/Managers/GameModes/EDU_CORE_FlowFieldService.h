@@ -0,0 +1,137 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*------------------------------------------------------------------------------
+  Flow Field Service
+--------------------------------------------------------------------------------
+  One path for any number of entities heading to the same place. A cost grid
+  is sampled from the navmesh once at map load, and every destination gets
+  its own field: the direction to the cheapest neighbour on the way to the
+  goal, for every cell of the grid. Entities read the direction of the cell
+  they're in, so the cost of a move doesn't grow with the size of the group.
+
+	Bake:			Game thread, at map load. Cells the navmesh doesn't cover
+					are blocked. Neighbours whose navmesh heights differ by
+					more than MaxSlope allows can't be stepped between, which
+					cuts cliffs and ledges. Cells next to a blocked cell or a
+					cut step cost more, which keeps entities off walls and
+					cliffs.
+	RequestField:	Game thread. The field is built at the next Flush, and
+					kept until its Owner releases it or is destroyed.
+	Flush:			Game thread, once per frame by the GameMode after the
+					lanes. Every requested field is built in parallel.
+	GetDirection:	Any thread between Flushes, usually from a lane Calc.
+
+  <!> Like FTerrainHeightfield, only the navmesh at the time of the bake.
+	  Entities don't block cells, collision avoidance handles them.
+  <!> One navmesh height per cell. Where levels overlap, bridges and the
+	  like, the grid keeps the level closest to the middle of the bounds,
+	  and the height check cuts it off from the other one.
+------------------------------------------------------------------------------*/
+
+class EDU_CORE_API FFlowFieldService
+{
+public:
+	// A byte per cell for the costs and per field for the directions.
+	static constexpr int32 MaxCells = 1024 * 1024;
+
+	// Game thread. Returns false if Bounds is empty, needs more than MaxCells, or the navmesh covers none of it.
+	bool Bake(const UWorld* World, const FBox& Bounds, float NewCellSize, float MaxSlope);
+
+	void Reset();
+
+	bool IsValid() const { return Costs.Num() > 0; }
+
+	// Game thread. False if Goal is outside the grid or blocked. A field with the same goal cell is kept.
+	bool RequestField(const UObject* Owner, const FVector& Goal);
+
+	// Game thread.
+	void ReleaseField(const UObject* Owner);
+
+	// Game thread. Builds every requested field, and drops the ones whose Owner is gone.
+	void Flush();
+
+	// Thread safe between Flushes. False until the field is built, on its goal cell, and where the goal can't be reached.
+	bool GetDirection(const UObject* Owner, const FVector& Location, FVector& OutDirection) const;
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	float GetCellSize() const { return CellSize; }
+	int32 GetNumFields() const { return Fields.Num(); }
+	int32 GetLastBuiltFields() const { return LastBuiltFields; }
+
+private:
+	static constexpr uint8 BlockedCost = 255;
+	static constexpr uint8 NoDirection = 255;
+
+	struct FField
+	{
+		TWeakObjectPtr<const UObject> Owner;
+		int32 GoalCell = INDEX_NONE;
+		bool bBuilt = false;
+
+		// Per cell, index into the neighbour offsets, or NoDirection.
+		TArray<uint8> Directions;
+	};
+
+	struct FOpenCell
+	{
+		float Cost;
+		int32 Cell;
+
+		bool operator<(const FOpenCell& Other) const { return Cost < Other.Cost; }
+	};
+
+	// Integration buffers of a build, pooled so there is one per build running at once, not one per field.
+	struct FBuildScratch
+	{
+		TArray<float> Integration;
+		TArray<FOpenCell> Open;
+	};
+
+	// Thread safe, integrates from the goal outwards and points every cell downhill.
+	void BuildField(FField& Field) const;
+
+	TUniquePtr<FBuildScratch> AcquireScratch() const;
+	void ReleaseScratch(TUniquePtr<FBuildScratch>&& Scratch) const;
+
+	// INDEX_NONE outside the grid.
+	int32 GetCellIndex(const FVector& Location) const
+	{
+		const int32 CellX = FMath::FloorToInt32((Location.X - Origin.X) * InvCellSize);
+		const int32 CellY = FMath::FloorToInt32((Location.Y - Origin.Y) * InvCellSize);
+		return IsValidCell(CellX, CellY) ? CellY * SizeX + CellX : INDEX_NONE;
+	}
+
+	bool IsValidCell(const int32 CellX, const int32 CellY) const
+	{
+		return CellX >= 0 && CellY >= 0 && CellX < SizeX && CellY < SizeY;
+	}
+
+	bool CanStep(const int32 Cell, const int32 Neighbour) const
+	{
+		return (StepMasks[Cell] >> Neighbour) & 1;
+	}
+
+	// Row major, SizeX * SizeY
+	TArray<uint8> Costs;
+
+	// Per cell, a bit per neighbour that can be stepped to. Diagonal steps can't cut the corner of a blocked cell or step.
+	TArray<uint8> StepMasks;
+
+	mutable FCriticalSection ScratchLock;
+	mutable TArray<TUniquePtr<FBuildScratch>> FreeScratch;
+
+	TMap<const UObject*, FField> Fields;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+	float CellSize = 400.f;
+	float InvCellSize = 1.f / 400.f;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+
+	int32 LastBuiltFields = 0;
+};
@@ -0,0 +1,92 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TeamVisibility.h"
+#include <atomic>
+
+class FTerrainHeightfield;
+
+/*------------------------------------------------------------------------------
+  Fog of War Grid
+--------------------------------------------------------------------------------
+  A raster over the map, every cell holds a bitmask of the teams that see it.
+  SenseComponents stamp their field of view into it from the parallel sight
+  lane, and entity visibility becomes a lookup of the cell under the entity,
+  so the cost grows with the number of observers, not observers x targets.
+
+	Stamp:		Any thread. Sets the team bit in every cell of the shape that
+				the eye can see over the terrain heightfield. Cells the team
+				already sees this cycle skip the terrain walk.
+	Refresh:	Game thread, between lanes. Starts a new stamping cycle, a cell
+				goes dark after a full cycle without stamps.
+	Lookup:		Any thread, reads the current and the last cycle.
+
+	TargetHeight:	A cell counts as seen if the eye can see this far above
+					its ground, roughly the height of an entity.
+
+  <!> Server side. Clients can be sent GetTeamRaster for the minimap.
+------------------------------------------------------------------------------*/
+
+class EDU_CORE_API FFogOfWarGrid
+{
+public:
+	using FTeamMask = FTeamVisibility::FTeamMask;
+
+	// Two masks per cell, stamping and lookups stay cache friendly well below this.
+	static constexpr int32 MaxCells = 2048 * 2048;
+
+	// Game thread. Terrain may be nullptr, then nothing blocks sight. False if Bounds is empty, or needs more than MaxCells.
+	bool Init(const FBox& Bounds, float NewCellSize, float NewTargetHeight, const FTerrainHeightfield* NewTerrain);
+
+	void Reset();
+
+	bool IsValid() const { return NumCells > 0; }
+
+	// Thread safe. Every cell within Radius of Center.
+	void StampCircle(const FVector& Eye, const FVector& Center, float Radius, EEDU_CORE_Team Team);
+
+	// Thread safe. Every cell within Radius of the segment, a capsule seen from above.
+	void StampCapsule(const FVector& Eye, const FVector& SegmentStart, const FVector& SegmentEnd, float Radius, EEDU_CORE_Team Team);
+
+	// Game thread.
+	void Refresh();
+
+	// Teams that see the cell under Location, 0 outside the grid.
+	FTeamMask GetVisibleTeams(const FVector& Location) const;
+
+	bool IsVisibleToTeam(const FVector& Location, const EEDU_CORE_Team Team) const
+	{
+		return FTeamVisibility::IsValidTeam(Team) && (GetVisibleTeams(Location) & FTeamVisibility::GetTeamBit(Team)) != 0;
+	}
+
+	// One bit per cell, row major, SizeX * SizeY.
+	void GetTeamRaster(EEDU_CORE_Team Team, TBitArray<>& OutVisible) const;
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	float GetCellSize() const { return CellSize; }
+	FVector2D GetOrigin() const { return Origin; }
+
+private:
+	// Calls CellFilter(CellCenter) for every cell in the XY box, and stamps those that pass.
+	template<typename CellFilterType>
+	void Stamp(const FVector& Eye, const FVector2D& BoxMin, const FVector2D& BoxMax, EEDU_CORE_Team Team, CellFilterType&& CellFilter);
+
+	int32 GetCellIndex(const FVector& Location) const;
+
+	// Stamped this cycle, and last cycle.
+	TUniquePtr<std::atomic<FTeamMask>[]> CurrentCells;
+	TUniquePtr<std::atomic<FTeamMask>[]> PreviousCells;
+
+	const FTerrainHeightfield* Terrain = nullptr;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+	float CellSize = 500.f;
+	float InvCellSize = 1.f / 500.f;
+	float TargetHeight = 100.f;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	int32 NumCells = 0;
+};
@@ -0,0 +1,70 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/*------------------------------------------------------------------------------
+  Frame Time Recorder
+--------------------------------------------------------------------------------
+  Keeps the last Capacity samples of each channel (frame time, tick lanes) in
+  a ring buffer, so we can look at tail latencies instead of an average.
+
+  Recording is lock-free and does no allocation or string formatting: each
+  channel has a single writer (the game thread), and readers copy the buffer
+  before sorting it. A reader racing the writer may see a sample from the
+  next lap, which is harmless for percentiles.
+------------------------------------------------------------------------------*/
+
+class EDU_CORE_API FFrameTimeRecorder
+{
+public:
+	// Samples kept per channel, must be a power of two.
+	static constexpr uint32 Capacity = 4096;
+
+	struct FSummary
+	{
+		int32 SampleCount = 0;
+		float P50 = 0.f;
+		float P95 = 0.f;
+		float P99 = 0.f;
+		float Max = 0.f;
+	};
+
+	// Setup only, not thread safe. Returns the channel index.
+	int32 AddChannel(const FName& Name);
+
+	// Game thread, every frame.
+	void Record(const int32 Channel, const float Milliseconds)
+	{
+		FChannel& Target = *Channels[Channel];
+		const uint32 Index = Target.WriteIndex.load(std::memory_order_relaxed);
+		Target.Samples[Index & (Capacity - 1)] = Milliseconds;
+		Target.WriteIndex.store(Index + 1, std::memory_order_release);
+	}
+
+	int32 GetNumChannels() const { return Channels.Num(); }
+	FName GetChannelName(const int32 Channel) const { return Channels[Channel]->Name; }
+
+	// Sorts a copy of the channel, keep it off the hot path.
+	FSummary GetSummary(int32 Channel) const;
+
+	// Percentiles and a histogram of every channel.
+	bool WriteCSV(const FString& FilePath) const;
+
+	void Reset();
+
+private:
+	// Copies the valid samples of a channel, oldest first.
+	void CopySamples(int32 Channel, TArray<float>& OutSamples) const;
+
+	struct FChannel
+	{
+		FName Name;
+		std::atomic<uint32> WriteIndex { 0 };
+		float Samples[Capacity] = {};
+	};
+
+	TArray<TUniquePtr<FChannel>> Channels;
+};
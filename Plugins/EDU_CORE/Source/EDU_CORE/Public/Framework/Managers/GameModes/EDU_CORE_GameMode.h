@@ -3,6 +3,16 @@
 #pragma once
 
 #include "Framework/Data/DataTypes/EDU_CORE_DataTypes.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+#include "Framework/Managers/GameModes/EDU_CORE_EntityRegistry.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TeamVisibility.h"
+#include "Framework/Managers/GameModes/EDU_CORE_SpatialGrid.h"
+#include "Framework/Managers/GameModes/EDU_CORE_LineOfSightService.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TerrainHeightfield.h"
+#include "Framework/Managers/GameModes/EDU_CORE_FlowFieldService.h"
+#include "Framework/Managers/GameModes/EDU_CORE_NavPathCache.h"
+#include "Framework/Managers/GameModes/EDU_CORE_FogOfWarGrid.h"
+#include "Framework/Managers/GameModes/EDU_CORE_FrameTimeRecorder.h"
 
 #include "CoreMinimal.h"
 
@@ -40,88 +50,6 @@ class UEngagementComponent;
   where the player is expected to interact with entities.
 ------------------------------------------------------------------------------*/
 
-// Struct to hold the visibility arrays for each team
-USTRUCT(BlueprintType)
-struct FVisibilityStruct
-{
-	GENERATED_BODY()
-
-	//------------------------------------------------------------------------------
-	// Visibility arrays, used to skip actors during FOV checks.
-	//------------------------------------------------------------------------------
-
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_0_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_1_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_2_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_3_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_4_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_5_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_6_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_7_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_8_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_9_VisibleActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visible Actors")
-	TArray<AActor*> Team_10_VisibleActors;
-	
-	//------------------------------------------------------------------------------
-	// Hidden actor arrays, used to skip actors during Weapon Checks.
-	//------------------------------------------------------------------------------
-	
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_0_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_1_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_2_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_3_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_4_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_5_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_6_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_7_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_8_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_9_HiddenActors;
-		
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hidden Actors")
-	TArray<AActor*> Team_10_HiddenActors;
-
-};
-
 UCLASS(Abstract)
 class EDU_CORE_API AEDU_CORE_GameMode : public AGameModeBase
 {
@@ -139,20 +67,50 @@ public:
 	virtual void Tick(float DeltaTime) override;
 
 	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// The registries are not UPROPERTYs, so their members are reported to GC here.
+	static void AddReferencedObjects(UObject* InThis, FReferenceCollector& Collector);
+
+	// Declares the Period, BatchSize and Calc/Exec pair of every aggregated array.
+	virtual void RegisterTickLanes();
+
+	// Binds an aggregated array to a new lane, see EDU_CORE_TickLane.h
+	template<typename ElementType, typename CalcFunctionType, typename ExecFunctionType>
+	FTickLane& RegisterTickLane(const FTickLaneSettings& Settings, TArray<TObjectPtr<ElementType>>& Array, CalcFunctionType Calc, ExecFunctionType Exec)
+	{
+		return *TickLanes.Add_GetRef(MakeUnique<TTickLane<ElementType, CalcFunctionType, ExecFunctionType>>(Settings, Array, Calc, Exec));
+	}
+
+	template<typename ElementType, typename CalcFunctionType, typename ExecFunctionType>
+	FTickLane& RegisterTickLane(const FTickLaneSettings& Settings, TEntityRegistry<ElementType>& Registry, CalcFunctionType Calc, ExecFunctionType Exec)
+	{
+		return RegisterTickLane(Settings, Registry.GetDense(), Calc, Exec);
+	}
 	
 //------------------------------------------------------------------------------
 // Get/Set
 //------------------------------------------------------------------------------
 public:
-	// Aggregated Tick Arrays
-	void AddToAbstractEntityArray(AEDU_CORE_AbstractEntity* AbstractEntity);
-	void AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity);
-	void AddToMobileEntityArray(AEDU_CORE_MobileEntity* MobileEntity);
-	void AddToSightComponentArray(USenseComponent* SightComponent);
-	void AddToStatusComponentArray(UStatusComponent* StatusComponent);
-	void AddToTurretComponentArray(UTurretWeaponComponent* TurretComponent);
-	void AddToFixedWeaponComponentArray(UFixedWeaponComponent* FixedWeaponComponent);
-	void AddToEngagementComponentArray(UEngagementComponent* EngagementComponent);
+	// Aggregated Tick Arrays, Add is called from BeginPlay and Remove from EndPlay.
+	FEntityHandle AddToAbstractEntityArray(AEDU_CORE_AbstractEntity* AbstractEntity);
+	FEntityHandle AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity);
+	FEntityHandle AddToMobileEntityArray(AEDU_CORE_MobileEntity* MobileEntity);
+	FEntityHandle AddToSightComponentArray(USenseComponent* SightComponent);
+	FEntityHandle AddToStatusComponentArray(UStatusComponent* StatusComponent);
+	FEntityHandle AddToTurretComponentArray(UTurretWeaponComponent* TurretComponent);
+	FEntityHandle AddToFixedWeaponComponentArray(UFixedWeaponComponent* FixedWeaponComponent);
+	FEntityHandle AddToEngagementComponentArray(UEngagementComponent* EngagementComponent);
+
+	void RemoveFromAbstractEntityArray(const AEDU_CORE_AbstractEntity* AbstractEntity);
+	void RemoveFromPhysicsEntityArray(const AEDU_CORE_PhysicsEntity* PhysicsEntity);
+	void RemoveFromMobileEntityArray(const AEDU_CORE_MobileEntity* MobileEntity);
+	void RemoveFromSightComponentArray(const USenseComponent* SightComponent);
+	void RemoveFromStatusComponentArray(const UStatusComponent* StatusComponent);
+	void RemoveFromTurretComponentArray(const UTurretWeaponComponent* TurretComponent);
+	void RemoveFromFixedWeaponComponentArray(const UFixedWeaponComponent* FixedWeaponComponent);
+	void RemoveFromEngagementComponentArray(const UEngagementComponent* EngagementComponent);
 
 	// Used when checking if a Unit Order came from the right Team.
 	void AddActorToTeamArray(AActor* Actor, EEDU_CORE_Team TeamArray = EEDU_CORE_Team::None);
@@ -161,6 +119,88 @@ public:
 	// Used to keep track of entities that are visible to other teams, mainly to skip them in visual checks.
 	void AddActorToTeamVisibleActorsArray(AActor* Actor, EEDU_CORE_Team TeamArray = EEDU_CORE_Team::None);
 	void RemoveActorFromTeamVisibleActorsArray(AActor* Actor, EEDU_CORE_Team TeamArray = EEDU_CORE_Team::None);
+
+	// Called when an actor leaves play, removes it from the Visible and Hidden arrays of every team.
+	void RemoveActorFromAllVisibilityArrays(AActor* Actor);
+
+	// One bit per team that currently sees the actor, see EDU_CORE_TeamVisibility.h
+	FTeamVisibility::FTeamMask GetSeenByTeams(const AActor* Actor) const { return TeamVisibility.GetSeenByTeams(Actor); }
+	bool IsActorVisibleToTeam(const AActor* Actor, EEDU_CORE_Team TeamArray) const { return TeamVisibility.IsVisibleToTeam(Actor, TeamArray); }
+
+	/*-------------------------- Visibility Expiry ---------------------------------
+	  StatusComponents store when each team last saw them, and queue a wake up
+	  here instead of counting down every tick. Due entries are handed back to
+	  UStatusComponent::UpdateVisibilityExpiry before the lanes run.
+	------------------------------------------------------------------------------*/
+
+	void ScheduleVisibilityExpiry(UStatusComponent* StatusComponent, EEDU_CORE_Team TeamArray, float DueAt);
+
+	FORCEINLINE float GetAsyncedClock() const { return AsyncedClock; }
+
+	/*-------------------------------- Sleep ---------------------------------------
+	  Idle MobileEntities leave the MobileEntity and PhysicsEntity lanes for the
+	  sleeping lane, which only checks if they should wake, and go net dormant.
+	  Lanes iterate the registries, so the move is applied after the lanes,
+	  from whatever state the entity is in by then.
+	  See AEDU_CORE_MobileEntity::ServerSleep
+	------------------------------------------------------------------------------*/
+
+	void RequestSleepStateChange(AEDU_CORE_MobileEntity* MobileEntity);
+
+	/*----------------------------- Spatial Grid -----------------------------------
+	  Entity queries that never touch the physics scene, safe to call from a
+	  parallel Calc. Results are appended to OutActors, teams and actors are
+	  skipped by the Filter of the querying TeamArray, and entities of another
+	  ObjectType are skipped like in OverlapMultiByObjectType.
+	  See EDU_CORE_SpatialGrid.h
+	------------------------------------------------------------------------------*/
+	
+	void QueryEntitiesInRadius(const FVector& Center, float Radius, EEDU_CORE_Team TeamArray, ETeamQueryFilter Filter, ECollisionChannel ObjectType, TArray<AActor*>& OutActors) const;
+	
+	FORCEINLINE const FSpatialGrid& GetSpatialGrid() const { return SpatialGrid; }
+
+	/*--------------------------- Line of Sight ------------------------------------
+	  Lanes request traces during Calc, the GameMode traces them in one batch
+	  after the lanes, and the callbacks run before the next Exec.
+	  See EDU_CORE_LineOfSightService.h
+	------------------------------------------------------------------------------*/
+
+	FORCEINLINE FLineOfSightService& GetLineOfSightService() { return LineOfSightService; }
+
+	// Call when a dynamic blocker moves, spawns or is destroyed, cached answers through the area are dropped.
+	UFUNCTION(BlueprintCallable, Category = "Line of Sight")
+	void InvalidateLineOfSight(const FVector& Location, float Radius) { LineOfSightService.InvalidateArea(Location, Radius); }
+
+	// Terrain only, no physics, safe to call from a parallel Calc. See EDU_CORE_TerrainHeightfield.h
+	bool IsTerrainBlockingLineOfSight(const FVector& Start, const FVector& End) const { return TerrainHeightfield.IsBlocked(Start, End); }
+
+	FORCEINLINE const FTerrainHeightfield& GetTerrainHeightfield() const { return TerrainHeightfield; }
+
+	/*---------------------------- Flow Fields ------------------------------------
+	  Waypoints request a field for large groups, MobileEntities read their
+	  direction from it during Calc. See EDU_CORE_FlowFieldService.h
+	------------------------------------------------------------------------------*/
+
+	FORCEINLINE FFlowFieldService& GetFlowFields() { return FlowFields; }
+	FORCEINLINE const FFlowFieldService& GetFlowFields() const { return FlowFields; }
+
+	/*---------------------------- Path Cache -------------------------------------
+	  MobileEntities check it before asking the NavSystem for a path.
+	  See EDU_CORE_NavPathCache.h
+	------------------------------------------------------------------------------*/
+
+	FORCEINLINE FNavPathCache& GetPathCache() { return PathCache; }
+
+	/*---------------------------- Fog of War -------------------------------------
+	  SenseComponents stamp what they see, entities are visible if their cell
+	  is, safe to call from a parallel Calc. See EDU_CORE_FogOfWarGrid.h
+	------------------------------------------------------------------------------*/
+
+	FORCEINLINE bool IsFogOfWarEnabled() const { return FogOfWar.IsValid(); }
+	FORCEINLINE FFogOfWarGrid& GetFogOfWar() { return FogOfWar; }
+	FORCEINLINE const FFogOfWarGrid& GetFogOfWar() const { return FogOfWar; }
+
+	bool IsLocationVisibleToTeam(const FVector& Location, EEDU_CORE_Team TeamArray) const { return FogOfWar.IsVisibleToTeam(Location, TeamArray); }
 	
 	// For other Actors to see what friendly actors are on their team.
 	TArray<AActor*>& GetTeamArray(EEDU_CORE_Team TeamArray = EEDU_CORE_Team::None);
@@ -173,10 +213,14 @@ public:
 	
 	// For Entities and Actors to register across instances.
 	void AddToGuidActorMap(FGuid GUID, AActor* Actor);
+	void RemoveFromGuidActorMap(FGuid GUID);
 
 	// Exchanges a GUID that works across instances for a pointer of the same Entity on the server
 	TObjectPtr<AActor> FindActorInMap(FGuid GUID) const;
 
+	// Aggregated tick lanes, in tick order.
+	FORCEINLINE const TArray<TUniquePtr<FTickLane>>& GetTickLanes() const { return TickLanes; }
+
 	// Waypoint Management
 	TObjectPtr<AEDU_CORE_Waypoint> GetFreshWaypointFromPool(EEDU_CORE_Team Team = EEDU_CORE_Team::None, const FVector& WorldLocation = FVector::ZeroVector, const FRotator& WorldRotation = FRotator::ZeroRotator);
 	
@@ -246,11 +290,167 @@ protected:
 	TArray<AActor*> Team_10_Array;
 
 	//------------------------------------------------------------------------------
-	// Visibility arrays, used to skip actors during FOV checks.
+	// Visibility sets, used to skip actors during FOV and Weapon checks.
+	//	<!> Not a UPROPERTY, reported to GC in AddReferencedObjects.
 	//------------------------------------------------------------------------------
 
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Visibility")
-	FVisibilityStruct VisibilityStruct;
+	FTeamVisibility TeamVisibility;
+
+	/*----------------------------- Spatial Grid -----------------------------------
+	  Rebuilt from the StatusComponentRegistry at the start of every Tick, so
+	  every entity with a team can be found by location.
+	------------------------------------------------------------------------------*/
+	
+	// Override per map, should be close to the typical sight and weapon range.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Spatial Grid", meta = (ClampMin = "100"))
+	float SpatialGridCellSize = 2000.f;
+
+	FSpatialGrid SpatialGrid;
+
+	void UpdateSpatialGrid();
+
+	// Teams a query from TeamArray visits
+	static FTeamVisibility::FTeamMask GetQueryTeamMask(EEDU_CORE_Team TeamArray, ETeamQueryFilter Filter);
+
+	void RemoveIgnoredQueryResults(int32 FirstResult, EEDU_CORE_Team TeamArray, ETeamQueryFilter Filter, TArray<AActor*>& OutActors) const;
+
+	// Flushed once per Tick, after the lanes.
+	FLineOfSightService LineOfSightService;
+
+	// Size of the XY cells LOS answers are cached by.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight", meta = (ClampMin = "100"))
+	float LineOfSightCacheCellSize = 500.f;
+
+	// Height of the bands LOS answers are cached by.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight", meta = (ClampMin = "50"))
+	float LineOfSightCacheHeightBand = 250.f;
+
+	// Seconds a cached LOS answer stays valid, 0 traces every request.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight", meta = (ClampMin = "0"))
+	float LineOfSightCacheTimeToLive = 2.f;
+
+	/*------------------------------------ Map ------------------------------------
+	  The playable area every map-sized grid is laid over: the terrain
+	  heightfield, Fog of War and flow fields.
+	------------------------------------------------------------------------------*/
+
+	// Set it, the level bounds used when it's empty include every actor, and usually exceed the grids' MaxCells.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Map")
+	FBox TerrainBounds = FBox(ForceInit);
+
+	// TerrainBounds, or the bounds of the persistent level with a warning when empty.
+	FBox GetMapBounds() const;
+
+	/*--------------------------- Terrain Heightfield ------------------------------
+	  Baked in BeginPlay, LOS traces blocked by terrain never reach physics.
+	  <!> Levels streamed in after BeginPlay are not part of the bake.
+	------------------------------------------------------------------------------*/
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Terrain")
+	bool bBakeTerrainHeightfield = true;
+
+	// One height sample per cell.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Terrain", meta = (ClampMin = "50", EditCondition = "bBakeTerrainHeightfield"))
+	float TerrainCellSize = 200.f;
+
+	// Rasterize static meshes into the heightfield as occluders, not just the ground.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Terrain", meta = (EditCondition = "bBakeTerrainHeightfield"))
+	bool bTerrainIncludesStaticMeshes = true;
+
+	// How far terrain has to rise above a line to block it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Terrain", meta = (ClampMin = "0", EditCondition = "bBakeTerrainHeightfield"))
+	float TerrainClearance = 25.f;
+
+	// Lines clear of terrain count as in sight without a physics trace. Faster, but entities never block sight.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Terrain", meta = (EditCondition = "bBakeTerrainHeightfield"))
+	bool bTerrainOnlyLineOfSight = false;
+
+	FTerrainHeightfield TerrainHeightfield;
+
+	void BakeTerrainHeightfield();
+
+	/*---------------------------- Flow Fields ------------------------------------
+	  The cost grid is baked from the navmesh in BeginPlay, over GetMapBounds.
+	  <!> Navmesh changes after BeginPlay are not part of the bake.
+	------------------------------------------------------------------------------*/
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Flow Field")
+	bool bUseFlowFields = true;
+
+	// One cost per cell, smaller cells fit narrower passages but every field gets bigger.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Flow Field", meta = (ClampMin = "50", EditCondition = "bUseFlowFields"))
+	float FlowFieldCellSize = 400.f;
+
+	// Steepest slope between two cells, in degrees. Steeper steps are cut, which keeps fields off cliffs and ledges.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Flow Field", meta = (ClampMin = "1", ClampMax = "89", EditCondition = "bUseFlowFields"))
+	float FlowFieldMaxSlope = 45.f;
+
+	// Flushed once per Tick, after the lanes.
+	FFlowFieldService FlowFields;
+
+	void BakeFlowFields();
+
+	/*---------------------------- Path Cache -------------------------------------
+	  Paths are dropped when the navigation system dirties an area they cross.
+	------------------------------------------------------------------------------*/
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Path Cache")
+	bool bUsePathCache = true;
+
+	// Paths kept, the least recently used one is dropped when full.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Path Cache", meta = (ClampMin = "1", EditCondition = "bUsePathCache"))
+	int32 PathCacheCapacity = 512;
+
+	// How far from a path a dirtied area still drops it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Navigation|Path Cache", meta = (ClampMin = "0", Units = "cm", EditCondition = "bUsePathCache"))
+	float PathCacheInvalidationMargin = 200.f;
+
+	FNavPathCache PathCache;
+
+	/*---------------------------- Fog of War -------------------------------------
+	  Replaces the per target LOS trace of SenseComponents with a lookup, see
+	  EDU_CORE_FogOfWarGrid.h. Uses the terrain heightfield for occlusion.
+	------------------------------------------------------------------------------*/
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Fog of War")
+	bool bUseFogOfWar = false;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Fog of War", meta = (ClampMin = "100", EditCondition = "bUseFogOfWar"))
+	float FogOfWarCellSize = 500.f;
+
+	// How far above the ground of a cell the eye has to see, roughly the height of an entity.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Fog of War", meta = (ClampMin = "0", EditCondition = "bUseFogOfWar"))
+	float FogOfWarTargetHeight = 100.f;
+
+	// AsyncedClock seconds per stamping cycle, should match the SightComponent lane period.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Line of Sight|Fog of War", meta = (ClampMin = "0.1", EditCondition = "bUseFogOfWar"))
+	float FogOfWarRefreshPeriod = 1.f;
+
+	FFogOfWarGrid FogOfWar;
+	float NextFogOfWarRefresh = 0.f;
+
+	/*-------------------------- Visibility Expiry ---------------------------------
+	  Min-heap on DueAt. A component has at most one entry per team, stale
+	  entries of destroyed components are dropped when they come up.
+	------------------------------------------------------------------------------*/
+
+	struct FVisibilityExpiry
+	{
+		float DueAt = 0.f;
+		TWeakObjectPtr<UStatusComponent> StatusComponent;
+		EEDU_CORE_Team Team = EEDU_CORE_Team::None;
+
+		bool operator<(const FVisibilityExpiry& Other) const { return DueAt < Other.DueAt; }
+	};
+
+	TArray<FVisibilityExpiry> VisibilityExpiryQueue;
+
+	void ProcessVisibilityExpiry();
+
+	// MobileEntities that went to sleep or woke up since the lanes last ran.
+	TArray<TWeakObjectPtr<AEDU_CORE_MobileEntity>> PendingSleepStateChanges;
+
+	void ProcessSleepStateChanges();
 	
 	/*---------------------- Server ID for MP communication  -----------------------
 	  Pointers are local, so we can't use them to send information to the server.
@@ -269,31 +469,33 @@ protected:
 	/*---------------------- Server-Side Aggregated Tick ---------------------------
 	  This tick function allows us to aggregate ticks server-side. These are
 	  excellent for batch executions, such as blending occasional Server updates.
+
+	  Every aggregated array is a registry, members are added on BeginPlay and
+	  swap-removed on EndPlay, removals during the lanes wait until they're done.
+	  See EDU_CORE_EntityRegistry.h
 	------------------------------------------------------------------------------*/
 	
-	UPROPERTY()
-	TArray<TObjectPtr<AEDU_CORE_AbstractEntity>> AbstractEntityArray;
+	TEntityRegistry<AEDU_CORE_AbstractEntity> AbstractEntityRegistry;
 	
-	UPROPERTY()
-	TArray<TObjectPtr<AEDU_CORE_PhysicsEntity>> PhysicsEntityArray;
+	TEntityRegistry<AEDU_CORE_PhysicsEntity> PhysicsEntityRegistry;
 
-	UPROPERTY()
-	TArray<TObjectPtr<AEDU_CORE_MobileEntity>> MobileEntityArray;
+	TEntityRegistry<AEDU_CORE_MobileEntity> MobileEntityRegistry;
 
-	UPROPERTY()
-	TArray<TObjectPtr<USenseComponent>> SightComponentArray;
+	// Idle MobileEntities, not in the MobileEntity or PhysicsEntity registries.
+	TEntityRegistry<AEDU_CORE_MobileEntity> SleepingMobileEntityRegistry;
+
+	TEntityRegistry<USenseComponent> SightComponentRegistry;
 	
-	UPROPERTY()
-	TArray<TObjectPtr<UStatusComponent>> StatusComponentArray;
+	TEntityRegistry<UStatusComponent> StatusComponentRegistry;
 
-	UPROPERTY()
-	TArray<TObjectPtr<UTurretWeaponComponent>> TurretComponentArray;
+	TEntityRegistry<UTurretWeaponComponent> TurretComponentRegistry;
 
-	UPROPERTY()
-	TArray<TObjectPtr<UFixedWeaponComponent>> FixedWeaponComponentArray;
+	TEntityRegistry<UFixedWeaponComponent> FixedWeaponComponentRegistry;
 	
-	UPROPERTY()
-	TArray<TObjectPtr<UEngagementComponent>> EngagementComponentArray;
+	TEntityRegistry<UEngagementComponent> EngagementComponentRegistry;
+
+	// While locked, Remove is queued so the dense arrays stay stable for the lanes.
+	void SetRegistriesLocked(bool bLocked);
 
 	/*------------------------------ BatchIndex ------------------------------------
 	  BatchIndex allows us to pass tick groups to our array members, so only
@@ -317,21 +519,16 @@ protected:
 	TScriptInterface<IEDU_CORE_CommandInterface> CommandInterface;
 	// IEDU_CORE_CommandInterface* CommandInterface;
 
-	int32 MobileEntityBatchIndex;
-	int32 SightComponentBatchIndex;
-	int32 StatusComponentBatchIndex;
-	int32 TurretComponentBatchIndex;
-	int32 FixedWeaponComponentBatchIndex;
-	int32 EngagementComponentBatchIndex;
+	/*------------------------------ Tick Lanes ------------------------------------
+	  Each lane owns the BatchIndex and cycle time of one aggregated array, and
+	  is ticked in registration order.
+	------------------------------------------------------------------------------*/
 	
-	float LastMobilEntityBatchTime;
-	float LastStatusComponentTime;
-	float LastEngagementComponentTime;
-	float LastSightComponentTime;
-	float LastFixedWeaponComponentTime;
+	TArray<TUniquePtr<FTickLane>> TickLanes;
 
-	float LastTurretComponentAnimationTime;
-	float LastTurretComponentEvaluationTime;
+	// Periodic lanes size their batches from a ms budget instead of a fixed BatchSize.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Aggregated Tick")
+	bool bUseTickLaneBudgets = true;
 	
 	UPROPERTY()
 	float AsyncedClock = 0;
@@ -353,13 +550,12 @@ protected:
 // Components > Debug
 //------------------------------------------------------------------------------
 	
-	FColor DeltaTimeDisplayColor;
-
-	int32 CurrentFrameTime = 0;
-	float FPSCounter = 0;
-	float FPSTotal = 0;
+	// Frame time and the time of every tick lane, see FrameTimes()
+	FFrameTimeRecorder FrameTimeRecorder;
 
-	int32 FrameTimeCounter;
+	// Writes the frame time percentiles and histogram to Saved/Profiling on EndPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Debug")
+	bool bDumpFrameTimesOnMatchEnd = false;
 	
 //------------------------------------------------------------------------------
 // Console Commands
@@ -369,5 +565,9 @@ protected:
 	// Server only: change team
 	UFUNCTION(Exec)
 	void ChangeTeamCommand(const int32 NewTeam) const;
+
+	// Prints p50/p95/p99/max of the frame and every tick lane.
+	UFUNCTION(Exec)
+	void FrameTimes() const;
 	
 };
\ No newline at end of file
@@ -0,0 +1,258 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+
+class FTerrainHeightfield;
+
+/*------------------------------------------------------------------------------
+  Line of Sight Service
+--------------------------------------------------------------------------------
+  Collects line of sight requests from the tick lanes, and traces them all at
+  once. Sensing and weapons often ask for the same observer and target in the
+  same frame, so requests are deduplicated by (Observer, Target, Channel) and
+  the line, with Start and End rounded to TraceQuantum, and every unique line
+  is traced once. Visibility checks use ECC_Visibility, so they can share.
+
+	Request:	Any thread, usually from a lane Calc.
+	Flush:		Game thread, once per frame by the GameMode after the lanes.
+				Unique traces run in a ParallelFor, then the callbacks run on
+				the game thread, before the next frame's Exec.
+
+  A request holds a list of targets in priority order, and the callback gets
+  the index of the first target in sight, or INDEX_NONE. Callbacks are
+  skipped if the Requester was destroyed in the meantime.
+
+	AcceptRadius:	0 requires the trace to hit the target itself, otherwise a
+					hit within AcceptRadius of the target counts as well.
+
+  Cache:
+	Terrain dominates our maps, so most answers stay valid for seconds. Every
+	answer is cached by (observer cell, target, target cell, channel), where a
+	cell is the XY cell plus a height band. A fresh cached answer skips the
+	trace, and once a cached answer is in sight, later targets aren't traced.
+
+	Answers are bucketed by the XY cell of the observer, and every bucket
+	keeps the bounds of its lines, so an invalidation only walks the entries
+	of the buckets it overlaps.
+
+	TimeToLive:		Seconds an answer stays valid, 0 disables the cache.
+	InvalidateArea:	Forgets every answer whose line passes near the area,
+					called when a dynamic blocker moves, spawns or is destroyed.
+
+  Terrain:
+	With a baked FTerrainHeightfield, every trace first walks the heightfield,
+	and lines blocked by terrain never reach the physics scene. With
+	bTerrainOnly, lines clear of terrain count as in sight without a physics
+	trace too, ignoring entities and anything spawned after the bake.
+------------------------------------------------------------------------------*/
+
+struct FLineOfSightTarget
+{
+	const AActor* Target = nullptr;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+};
+
+class EDU_CORE_API FLineOfSightService
+{
+public:
+	using FFirstVisibleCallback = TFunction<void(int32 FirstVisibleIndex)>;
+
+	// Thread safe. Callback runs on the game thread after the next Flush.
+	void RequestFirstVisible(const UObject* Requester, const AActor* Observer, ECollisionChannel Channel, float AcceptRadius,
+		TArray<FLineOfSightTarget>&& Targets, FFirstVisibleCallback&& Callback);
+
+	// Thread safe. Single target version of RequestFirstVisible.
+	void RequestLineOfSight(const UObject* Requester, const AActor* Observer, ECollisionChannel Channel, float AcceptRadius,
+		const FLineOfSightTarget& Target, TFunction<void(bool bHasLineOfSight)>&& Callback);
+
+	// Game thread. Traces everything requested since the last Flush, and delivers the results.
+	void Flush(const UWorld* World);
+
+	// Game thread. Clears the cache.
+	void SetCacheSettings(float NewCellSize, float NewHeightBand, float NewTimeToLive);
+
+	// Thread safe. Applied at the start of the next Flush.
+	void InvalidateArea(const FVector& Center, float Radius);
+
+	// Game thread. Terrain must outlive the service, nullptr traces everything.
+	void SetTerrain(const FTerrainHeightfield* NewTerrain, bool bNewTerrainOnly);
+
+	// Requested, unique and cached traces in the last Flush
+	int32 GetLastRequestedTraces() const { return LastRequestedTraces; }
+	int32 GetLastUniqueTraces() const { return LastUniqueTraces; }
+	int32 GetLastCachedTraces() const { return LastCachedTraces; }
+	int32 GetLastTerrainTraces() const { return LastTerrainTraces; }
+	int32 GetCacheNum() const { return NumCacheEntries; }
+
+private:
+	// Lines closer than this share a trace.
+	static constexpr float TraceQuantum = 10.f;
+
+	struct FTraceKey
+	{
+		const AActor* Observer = nullptr;
+		const AActor* Target = nullptr;
+		ECollisionChannel Channel = ECC_Visibility;
+
+		// Start and End in TraceQuantum units
+		FIntVector Start = FIntVector::ZeroValue;
+		FIntVector End = FIntVector::ZeroValue;
+
+		bool operator==(const FTraceKey& Other) const
+		{
+			return Observer == Other.Observer && Target == Other.Target && Channel == Other.Channel
+				&& Start == Other.Start && End == Other.End;
+		}
+
+		friend uint32 GetTypeHash(const FTraceKey& Key)
+		{
+			const uint32 ActorHash = HashCombineFast(HashCombineFast(GetTypeHash(Key.Observer), GetTypeHash(Key.Target)), GetTypeHash(static_cast<uint8>(Key.Channel)));
+			return HashCombineFast(ActorHash, HashCombineFast(GetTypeHash(Key.Start), GetTypeHash(Key.End)));
+		}
+	};
+
+	static FIntVector QuantizeTracePoint(const FVector& Location)
+	{
+		return FIntVector(
+			FMath::RoundToInt32(Location.X / TraceQuantum),
+			FMath::RoundToInt32(Location.Y / TraceQuantum),
+			FMath::RoundToInt32(Location.Z / TraceQuantum));
+	}
+
+	struct FCacheKey
+	{
+		// XY cell and height band
+		FIntVector ObserverCell = FIntVector::ZeroValue;
+		FIntVector TargetCell = FIntVector::ZeroValue;
+		ECollisionChannel Channel = ECC_Visibility;
+
+		// A line is only clear if it reaches this target, others in the cell may be behind it.
+		const AActor* Target = nullptr;
+
+		// Near hits count for some requests, so they get their own answers.
+		bool bAcceptNearHits = false;
+
+		bool operator==(const FCacheKey& Other) const
+		{
+			return ObserverCell == Other.ObserverCell && TargetCell == Other.TargetCell && Target == Other.Target
+				&& Channel == Other.Channel && bAcceptNearHits == Other.bAcceptNearHits;
+		}
+
+		friend uint32 GetTypeHash(const FCacheKey& Key)
+		{
+			const uint32 CellHash = HashCombineFast(GetTypeHash(Key.ObserverCell), GetTypeHash(Key.TargetCell));
+			return HashCombineFast(HashCombineFast(CellHash, GetTypeHash(Key.Target)),
+				GetTypeHash(static_cast<uint8>(Key.Channel) << 1 | static_cast<uint8>(Key.bAcceptNearHits)));
+		}
+	};
+
+	struct FCacheEntry
+	{
+		double ExpireTime = 0.0;
+		bool bHasLineOfSight = false;
+	};
+
+	// Every answer from one observer XY cell.
+	struct FCacheBucket
+	{
+		TMap<FCacheKey, FCacheEntry> Entries;
+
+		// Covers every line in Entries, only grows until the bucket is emptied.
+		FBox LineBounds = FBox(ForceInit);
+		double LatestExpireTime = 0.0;
+	};
+
+	struct FTrace
+	{
+		FTraceKey Key;
+		FVector Start = FVector::ZeroVector;
+		FVector End = FVector::ZeroVector;
+
+		// Filled by Flush
+		bool bHit = false;
+		bool bAnsweredByTerrain = false;
+		const AActor* HitActor = nullptr;
+		FVector ImpactPoint = FVector::ZeroVector;
+	};
+
+	struct FRequestTarget
+	{
+		// INDEX_NONE if answered by the cache
+		int32 TraceIndex = INDEX_NONE;
+		bool bCachedLineOfSight = false;
+
+		FVector Location = FVector::ZeroVector;
+		FCacheKey CacheKey;
+	};
+
+	struct FRequest
+	{
+		TWeakObjectPtr<const UObject> Requester;
+		float AcceptRadius = 0.f;
+		TArray<FRequestTarget> Targets;
+		FFirstVisibleCallback Callback;
+
+		// Filled by Flush
+		int32 FirstVisibleIndex = INDEX_NONE;
+	};
+
+	FIntVector GetCacheCell(const FVector& Location) const
+	{
+		return FIntVector(
+			FMath::FloorToInt32(Location.X * InvCacheCellSize),
+			FMath::FloorToInt32(Location.Y * InvCacheCellSize),
+			FMath::FloorToInt32(Location.Z * InvCacheHeightBand));
+	}
+
+	static FIntPoint GetCacheBucket(const FCacheKey& Key)
+	{
+		return FIntPoint(Key.ObserverCell.X, Key.ObserverCell.Y);
+	}
+
+	const FCacheEntry* FindCacheEntry(const FCacheKey& Key) const;
+	void AddCacheEntry(const FCacheKey& Key, const FCacheEntry& Entry);
+
+	FVector GetCacheCellCenter(const FIntVector& Cell) const
+	{
+		return FVector((Cell.X + 0.5f) * CacheCellSize, (Cell.Y + 0.5f) * CacheCellSize, (Cell.Z + 0.5f) * CacheHeightBand);
+	}
+
+	// Under RequestLock, drops expired answers and the ones crossing an invalidated area.
+	// Only buckets whose lines overlap an area are walked, unless expired answers are due.
+	void PurgeCache();
+
+	void ResetCache();
+
+	// Guards everything below, requests arrive from worker threads.
+	FCriticalSection RequestLock;
+
+	TMap<FTraceKey, int32> TraceLookup;
+	TArray<FTrace> Traces;
+	TArray<FRequest> Requests;
+	int32 RequestedTraces = 0;
+	int32 CachedTraces = 0;
+
+	TMap<FIntPoint, FCacheBucket> Cache;
+	int32 NumCacheEntries = 0;
+	TArray<FSphere> PendingInvalidations;
+	double CurrentTime = 0.0;
+	double NextPurgeTime = 0.0;
+
+	float CacheCellSize = 500.f;
+	float InvCacheCellSize = 1.f / 500.f;
+	float CacheHeightBand = 250.f;
+	float InvCacheHeightBand = 1.f / 250.f;
+	float CacheTimeToLive = 2.f;
+
+	int32 LastRequestedTraces = 0;
+	int32 LastUniqueTraces = 0;
+	int32 LastCachedTraces = 0;
+	int32 LastTerrainTraces = 0;
+
+	const FTerrainHeightfield* Terrain = nullptr;
+	bool bTerrainOnly = false;
+};
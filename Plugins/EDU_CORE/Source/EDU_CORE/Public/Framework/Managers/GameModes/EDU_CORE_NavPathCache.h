@@ -0,0 +1,108 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AI/Navigation/NavigationTypes.h"
+#include "Containers/LruCache.h"
+
+class ANavigationData;
+class UNavigationSystemV1;
+struct FNavigationPath;
+
+/*------------------------------------------------------------------------------
+  Nav Path Cache
+--------------------------------------------------------------------------------
+  Remembers the paths MobileEntities found, so patrols and evasions that ask
+  for the same way again don't run another pathfinding query. Paths are keyed
+  by the navmesh polygons of their start and end, and the agent that asked.
+
+	Capacity:			The least recently used path is dropped when full.
+	InvalidationMargin:	When the navigation system dirties an area, the tiles
+						under it get rebuilt and their polygons change. Every
+						path whose bounds, grown by the margin, touch the area
+						is dropped, and again once the rebuild is done.
+
+  Nothing is added while the navmesh is building, or if the path was found
+  before the last rebuild finished, those paths ran on the old tiles.
+
+  Game thread only, RequestPath and RequestPathAsync already run there.
+
+  <!> Partial paths are never cached, the goal might be reachable next time.
+------------------------------------------------------------------------------*/
+
+struct FNavPathCacheKey
+{
+	NavNodeRef StartPoly = INVALID_NAVNODEREF;
+	NavNodeRef EndPoly = INVALID_NAVNODEREF;
+	uint32 AgentHash = 0;
+
+	bool operator==(const FNavPathCacheKey& Other) const
+	{
+		return StartPoly == Other.StartPoly && EndPoly == Other.EndPoly && AgentHash == Other.AgentHash;
+	}
+
+	friend uint32 GetTypeHash(const FNavPathCacheKey& Key)
+	{
+		return HashCombineFast(HashCombineFast(GetTypeHash(Key.StartPoly), GetTypeHash(Key.EndPoly)), Key.AgentHash);
+	}
+};
+
+class EDU_CORE_API FNavPathCache
+{
+public:
+	// Game thread. Binds to the navigation system of World, so dirtied areas drop the paths through them.
+	void Init(UWorld* World, int32 NewCapacity, float NewInvalidationMargin);
+
+	// Game thread. Unbinds and forgets every path.
+	void Reset();
+
+	bool IsValid() const { return Capacity > 0; }
+
+	// False if Start or End is off the navmesh.
+	bool MakeKey(const ANavigationData* NavData, const FVector& Start, const FVector& End, const FNavAgentProperties& Agent, FNavPathCacheKey& OutKey) const;
+
+	// Every point of the path, start and end included. nullptr on a miss.
+	const TArray<FVector>* Find(const FNavPathCacheKey& Key);
+
+	// Keyed by the polygons of its first and last point. Skipped while the navmesh builds, or if Path is older than the last rebuild.
+	void Add(const FNavigationPath& Path, const FNavAgentProperties& Agent);
+
+	// Drops the paths through Area now, and again when the tiles under it are rebuilt.
+	void InvalidateArea(const FBox& Area);
+
+	int32 GetNum() const { return Cache.Num(); }
+	int32 GetHits() const { return Hits; }
+	int32 GetMisses() const { return Misses; }
+
+private:
+	static uint32 GetAgentHash(const FNavAgentProperties& Agent);
+
+	void RemoveIntersecting(const FBox& Area);
+
+	// Once the build is done, drops the paths found on the old tiles. False while still building.
+	bool UpdateBuildState();
+
+	struct FEntry
+	{
+		TArray<FVector> PathPoints;
+		FBox Bounds = FBox(ForceInit);
+	};
+
+	TLruCache<FNavPathCacheKey, FEntry> Cache;
+
+	TWeakObjectPtr<UNavigationSystemV1> NavSystem;
+	FDelegateHandle NavigationDirtiedHandle;
+
+	// Dirtied since the last finished build.
+	TArray<FBox> PendingAreas;
+
+	// World time of the last dirty area or finished build, older paths aren't added.
+	double LastInvalidationTime = 0.0;
+
+	int32 Capacity = 0;
+	float InvalidationMargin = 200.f;
+
+	int32 Hits = 0;
+	int32 Misses = 0;
+};
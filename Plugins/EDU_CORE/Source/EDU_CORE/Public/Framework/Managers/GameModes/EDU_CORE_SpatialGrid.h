@@ -0,0 +1,81 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TeamVisibility.h"
+
+/*------------------------------------------------------------------------------
+  Spatial Grid
+--------------------------------------------------------------------------------
+  A uniform hash grid over the XY plane, holding the location and team of
+  every entity. The GameMode rebuilds it once per frame before the tick lanes
+  run, so lanes can query it from their parallel Calc without locks.
+
+  Every cell keeps one bucket per team, so a query only visits the teams it
+  asks for, and never touches the physics scene. Entries also carry the object
+  type of their root primitive, so callers can filter like an object overlap.
+  Entities without a primitive root pass every object type filter.
+
+	CellSize:	Should be close to the typical query radius, too small and a
+				query visits many empty cells, too large and it tests many
+				entities outside the radius.
+
+  <!> Entities are points, a query tests the actor location, not its bounds.
+------------------------------------------------------------------------------*/
+
+class EDU_CORE_API FSpatialGrid
+{
+public:
+	using FTeamMask = FTeamVisibility::FTeamMask;
+
+	void SetCellSize(float NewCellSize);
+	float GetCellSize() const { return CellSize; }
+
+	// Empties the occupied cells only, and keeps their allocations for the next rebuild.
+	void Reset();
+
+	void Add(AActor* Actor, const FVector& Location, EEDU_CORE_Team Team, ECollisionChannel ObjectType = ECC_MAX);
+
+	int32 Num() const { return NumEntries; }
+
+	// Every entity of a team in TeamMask, and an object type in ObjectTypeMask (ECC_TO_BITFIELD), within Radius of Center.
+	void QueryRadius(const FVector& Center, float Radius, FTeamMask TeamMask, TArray<AActor*>& OutActors, uint32 ObjectTypeMask = MAX_uint32) const;
+
+private:
+	struct FEntry
+	{
+		AActor* Actor = nullptr;
+		FVector Location = FVector::ZeroVector;
+
+		// ECC_TO_BITFIELD of the root primitive, 0 when it has none.
+		uint32 ObjectTypeBit = 0;
+	};
+
+	struct FCell
+	{
+		// Teams with at least one entity in this cell
+		FTeamMask OccupiedTeams = 0;
+
+		TArray<FEntry> TeamEntries[FTeamVisibility::NumTeams];
+	};
+
+	FIntPoint GetCellCoordinates(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+	}
+
+	// Calls Visitor for every entry of TeamMask in the cells overlapping the circle.
+	template<typename VisitorType>
+	void ForEachEntryInRadius(const FVector& Center, float Radius, FTeamMask TeamMask, VisitorType&& Visitor) const;
+
+	TMap<FIntPoint, FCell> Cells;
+
+	// Cells with at least one entry since the last Reset, so Reset doesn't walk every cell ever touched.
+	TArray<FIntPoint> OccupiedCells;
+
+	float CellSize = 2000.f;
+	float InvCellSize = 1.f / 2000.f;
+	int32 NumEntries = 0;
+};
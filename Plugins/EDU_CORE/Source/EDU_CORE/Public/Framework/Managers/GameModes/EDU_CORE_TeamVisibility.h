@@ -0,0 +1,227 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/GCObject.h"
+#include "Framework/Data/DataTypes/EDU_CORE_DataTypes.h"
+
+/*------------------------------------------------------------------------------
+  Team Visibility
+--------------------------------------------------------------------------------
+  Keeps track of which teams have seen which actors. Every actor carries a
+  "seen-by-teams" bitmask, one bit per team, and every team has a dense set of
+  Visible and Hidden actors.
+
+	Visible:	Actors the team currently sees, skipped during FOV checks.
+	Hidden:		Actors the team has seen, but lost, skipped during Weapon checks.
+
+  Membership updates are O(1), the sets swap-remove and keep an index map,
+  so visibility flips don't scan arrays of hundreds of actors.
+
+  The sets stay plain TArray<AActor*>, since FCollisionQueryParams
+  AddIgnoredActors takes a const TArray<AActor*>&.
+
+  Team queries:
+	The team of every actor is kept here as well, so overlap results can be
+	rejected by team ID and bitmask in O(1), see ShouldIgnore, instead of
+	copying whole team arrays into the query as ignore lists.
+------------------------------------------------------------------------------*/
+
+// Which actors a team query rejects.
+enum class ETeamQueryFilter : uint8
+{
+	None		= 0,
+
+	// Actors on the querying team
+	Friendly	= 1 << 0,
+
+	// Actors the querying team currently sees
+	Visible		= 1 << 1,
+
+	// Actors the querying team has seen, but lost
+	Hidden		= 1 << 2,
+};
+ENUM_CLASS_FLAGS(ETeamQueryFilter);
+
+// Dense set of actors, O(1) Add, Remove and Contains.
+class FTeamActorSet
+{
+public:
+	void Reserve(const int32 Number)
+	{
+		Actors.Reserve(Number);
+		ActorIndices.Reserve(Number);
+	}
+
+	bool Add(AActor* Actor)
+	{
+		if(ActorIndices.Contains(Actor)) return false;
+
+		ActorIndices.Add(Actor, Actors.Add(Actor));
+		return true;
+	}
+
+	bool Remove(const AActor* Actor)
+	{
+		int32 Index;
+		if(!ActorIndices.RemoveAndCopyValue(Actor, Index)) return false;
+
+		// Move the last actor into the hole, and fix up its index
+		const int32 LastIndex = Actors.Num() - 1;
+		if(Index != LastIndex)
+		{
+			Actors[Index] = Actors[LastIndex];
+			ActorIndices[Actors[Index]] = Index;
+		}
+		Actors.Pop(EAllowShrinking::No);
+		return true;
+	}
+
+	bool Contains(const AActor* Actor) const { return ActorIndices.Contains(Actor); }
+
+	int32 Num() const { return Actors.Num(); }
+
+	TArray<AActor*>& GetActors() { return Actors; }
+	const TArray<AActor*>& GetActors() const { return Actors; }
+
+	void AddReferencedObjects(FReferenceCollector& Collector)
+	{
+		Collector.AddReferencedObjects(Actors);
+	}
+
+private:
+	TArray<AActor*> Actors;
+	TMap<const AActor*, int32> ActorIndices;
+};
+
+class FTeamVisibility
+{
+public:
+	// None and Team_1 to Team_10, Spectators see everything.
+	static constexpr int32 NumTeams = static_cast<int32>(EEDU_CORE_Team::Team_10) + 1;
+
+	using FTeamMask = uint16;
+	static_assert(NumTeams <= sizeof(FTeamMask) * 8, "FTeamMask can't hold a bit for every team.");
+
+	static bool IsValidTeam(const EEDU_CORE_Team Team) { return static_cast<int32>(Team) < NumTeams; }
+	static FTeamMask GetTeamBit(const EEDU_CORE_Team Team) { return static_cast<FTeamMask>(1u << static_cast<uint32>(Team)); }
+
+	void Reserve(const int32 Number)
+	{
+		ActorEntries.Reserve(Number);
+		for(int32 TeamIndex = 0; TeamIndex < NumTeams; ++TeamIndex)
+		{
+			Visible[TeamIndex].Reserve(Number);
+			Hidden[TeamIndex].Reserve(Number);
+		}
+	}
+
+	// Returns false if the team already saw the actor.
+	bool SetVisible(AActor* Actor, const EEDU_CORE_Team Team)
+	{
+		if(!Actor || !IsValidTeam(Team)) return false;
+
+		FTeamMask& Mask = ActorEntries.FindOrAdd(Actor).SeenByTeams;
+		const FTeamMask TeamBit = GetTeamBit(Team);
+		if(Mask & TeamBit) return false;
+
+		Mask |= TeamBit;
+		Visible[static_cast<int32>(Team)].Add(Actor);
+		Hidden[static_cast<int32>(Team)].Remove(Actor);
+		return true;
+	}
+
+	// Moves the actor from the team's Visible set to its Hidden set.
+	void SetHidden(AActor* Actor, const EEDU_CORE_Team Team)
+	{
+		if(!Actor || !IsValidTeam(Team)) return;
+
+		if(FActorEntry* Entry = ActorEntries.Find(Actor))
+		{
+			Entry->SeenByTeams &= ~GetTeamBit(Team);
+		}
+		Visible[static_cast<int32>(Team)].Remove(Actor);
+		Hidden[static_cast<int32>(Team)].Add(Actor);
+	}
+
+	// Forgets the actor for every team.
+	void RemoveActor(const AActor* Actor)
+	{
+		if(!Actor) return;
+
+		ActorEntries.Remove(Actor);
+		for(int32 TeamIndex = 0; TeamIndex < NumTeams; ++TeamIndex)
+		{
+			Visible[TeamIndex].Remove(Actor);
+			Hidden[TeamIndex].Remove(Actor);
+		}
+	}
+
+	// Called whenever the actor joins a team array.
+	void SetTeam(const AActor* Actor, const EEDU_CORE_Team Team)
+	{
+		if(Actor)
+		{
+			ActorEntries.FindOrAdd(Actor).Team = Team;
+		}
+	}
+
+	EEDU_CORE_Team GetTeam(const AActor* Actor) const
+	{
+		const FActorEntry* Entry = ActorEntries.Find(Actor);
+		return Entry ? Entry->Team : EEDU_CORE_Team::Max;
+	}
+
+	FTeamMask GetSeenByTeams(const AActor* Actor) const
+	{
+		const FActorEntry* Entry = ActorEntries.Find(Actor);
+		return Entry ? Entry->SeenByTeams : 0;
+	}
+
+	bool IsVisibleToTeam(const AActor* Actor, const EEDU_CORE_Team Team) const
+	{
+		return IsValidTeam(Team) && (GetSeenByTeams(Actor) & GetTeamBit(Team)) != 0;
+	}
+
+	// True if a query from Team should skip the actor, one map lookup and a bit test.
+	bool ShouldIgnore(const AActor* Actor, const EEDU_CORE_Team Team, const ETeamQueryFilter Filter) const
+	{
+		if(!Actor) return true;
+
+		const FActorEntry* Entry = ActorEntries.Find(Actor);
+		if(!Entry) return false;
+
+		if(EnumHasAnyFlags(Filter, ETeamQueryFilter::Friendly) && Entry->Team == Team) return true;
+		if(!IsValidTeam(Team)) return false;
+
+		if(EnumHasAnyFlags(Filter, ETeamQueryFilter::Visible) && (Entry->SeenByTeams & GetTeamBit(Team))) return true;
+		if(EnumHasAnyFlags(Filter, ETeamQueryFilter::Hidden) && Hidden[static_cast<int32>(Team)].Contains(Actor)) return true;
+
+		return false;
+	}
+
+	FTeamActorSet& GetVisible(const EEDU_CORE_Team Team) { return Visible[static_cast<int32>(Team)]; }
+	FTeamActorSet& GetHidden(const EEDU_CORE_Team Team) { return Hidden[static_cast<int32>(Team)]; }
+
+	void AddReferencedObjects(FReferenceCollector& Collector)
+	{
+		for(int32 TeamIndex = 0; TeamIndex < NumTeams; ++TeamIndex)
+		{
+			Visible[TeamIndex].AddReferencedObjects(Collector);
+			Hidden[TeamIndex].AddReferencedObjects(Collector);
+		}
+	}
+
+private:
+	struct FActorEntry
+	{
+		FTeamMask SeenByTeams = 0;
+		EEDU_CORE_Team Team = EEDU_CORE_Team::Max;
+	};
+	
+	TMap<const AActor*, FActorEntry> ActorEntries;
+
+	FTeamActorSet Visible[NumTeams];
+	FTeamActorSet Hidden[NumTeams];
+};
@@ -0,0 +1,78 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*------------------------------------------------------------------------------
+  Terrain Heightfield
+--------------------------------------------------------------------------------
+  A height raster of the map, baked once at map load by tracing down on a
+  regular XY grid. Answers "does terrain block this line?" with a grid walk
+  over the cells under the line, plain data, no physics scene and no locks,
+  so any worker thread can ask.
+
+	CellSize:				One height sample per cell, at its center. Smaller
+							cells catch narrower ridges, but bake slower.
+	bIncludeStaticMeshes:	Static meshes hit by the bake trace are rasterized
+							in as columns, otherwise only the ground counts.
+	Clearance:				Terrain has to rise this far above the line to block
+							it, keeps gentle slopes from blocking units on them.
+
+  The cells of Start and End are skipped, an entity standing on a slope is
+  always partially "below" its own cell.
+
+  Bounds should be the playable area, the level bounds include every actor
+  (skyboxes, far off kill volumes) and easily run past MaxCells.
+
+  <!> Only static occluders. Entities, and anything that moves or spawns after
+	  the bake, still need a physics trace.
+------------------------------------------------------------------------------*/
+
+class EDU_CORE_API FTerrainHeightfield
+{
+public:
+	// 64MB of heights, a bake this size already takes seconds.
+	static constexpr int32 MaxCells = 4096 * 4096;
+
+	// Game thread. Returns false if Bounds is empty, or needs more than MaxCells.
+	bool Bake(const UWorld* World, const FBox& Bounds, float NewCellSize, bool bIncludeStaticMeshes);
+
+	void Reset();
+
+	bool IsValid() const { return Heights.Num() > 0; }
+
+	void SetClearance(const float NewClearance) { Clearance = FMath::Max(NewClearance, 0.f); }
+
+	// Height of the cell under Location, or the bottom of the baked bounds outside of it.
+	float GetHeight(const FVector& Location) const;
+
+	// True if terrain blocks the line, OutBlockLocation is where it enters the terrain.
+	bool IsBlocked(const FVector& Start, const FVector& End, FVector* OutBlockLocation = nullptr) const;
+
+	int32 GetSizeX() const { return SizeX; }
+	int32 GetSizeY() const { return SizeY; }
+	float GetCellSize() const { return CellSize; }
+
+private:
+	bool IsValidCell(const int32 CellX, const int32 CellY) const
+	{
+		return CellX >= 0 && CellY >= 0 && CellX < SizeX && CellY < SizeY;
+	}
+
+	float GetCellHeight(const int32 CellX, const int32 CellY) const
+	{
+		return IsValidCell(CellX, CellY) ? Heights[CellY * SizeX + CellX] : MinHeight;
+	}
+
+	// Row major, SizeX * SizeY
+	TArray<float> Heights;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+	float CellSize = 200.f;
+	float InvCellSize = 1.f / 200.f;
+	int32 SizeX = 0;
+	int32 SizeY = 0;
+	float MinHeight = 0.f;
+	float Clearance = 25.f;
+};
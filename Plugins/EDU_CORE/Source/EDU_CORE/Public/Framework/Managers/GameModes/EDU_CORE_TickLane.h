@@ -0,0 +1,260 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Async.h"
+#include "Stats/Stats.h"
+#include "Async/ParallelFor.h"
+#include "Trace/Trace.h"
+#include <atomic>
+
+/*------------------------------------------------------------------------------
+  Aggregated Tick Lanes
+--------------------------------------------------------------------------------
+  A TickLane schedules one aggregated array in the GameMode. Instead of copying
+  the batch logic for every component type, each lane declares:
+
+	Period:		AsyncedClock seconds between full cycles, 0 runs every frame.
+	BatchSize:	Array members processed per frame, 0 processes the whole array.
+	Calc:		Member function run in a ParallelFor, must be thread safe.
+	Exec:		Member function run sequentially on the game thread.
+
+  The array is expected to be dense, see EDU_CORE_EntityRegistry.h, so
+  members are not null checked.
+
+  Calc and Exec may be nullptr, and may have the signature (), (float) or
+  (float, int32), where float is the lane DeltaTime and int32 is the
+  CurrentBatchIndex_10 of the GameMode.
+
+  Budgeted mode:
+	A periodic lane with a BudgetMs measures its own cost per member, and sizes
+	each batch to finish a cycle within TargetCycleLatency without spending
+	more than BudgetMs per frame. If the budget can't keep up, the cycle gets
+	longer rather than the frame. ParallelFor chunks are sized from the same
+	measurement, so small batches don't pay for dispatching to worker threads.
+
+  Game thread callbacks from Calc should use TickLaneAsyncTask, so they are
+  attributed to the lane in the profiler.
+
+  Example:
+	RegisterTickLane({ TEXT("Sight"), 1.f, 20 }, SightComponentRegistry,
+		&USenseComponent::ServerSightCalc, &USenseComponent::ServerSightExec);
+------------------------------------------------------------------------------*/
+
+// Which DeltaTime the lane passes to its members.
+enum class ETickLaneClock : uint8
+{
+	// Real frame DeltaTime
+	Frame,
+
+	// Normalized AsyncDeltaTime, see AEDU_CORE_GameMode::Tick
+	Async,
+};
+
+struct FTickLaneSettings
+{
+	// Used for debugging and profiling
+	FName Name = NAME_None;
+
+	// AsyncedClock seconds between the start of each full cycle, 0 runs every frame.
+	float Period = 0.f;
+
+	// Members processed per frame, 0 processes the whole array in one frame.
+	int32 BatchSize = 0;
+
+	ETickLaneClock Clock = ETickLaneClock::Frame;
+
+	// Budgeted mode: milliseconds per frame this lane may spend, 0 uses the fixed BatchSize.
+	float BudgetMs = 0.f;
+
+	// Budgeted mode: AsyncedClock seconds a full cycle should take, 0 uses Period.
+	float TargetCycleLatency = 0.f;
+};
+
+// Handed to every lane once per frame by the GameMode.
+struct FTickLaneContext
+{
+	float DeltaTime = 0.f;
+	float AsyncDeltaTime = 0.f;
+	float AsyncedClock = 0.f;
+	int32 CurrentBatchIndex = 0;
+
+	// AsyncedClock seconds that passed this frame
+	float AsyncedClockDelta = 0.f;
+
+	// Lanes with a BudgetMs size their own batches
+	bool bUseBudgets = true;
+};
+
+//------------------------------------------------------------------------------
+// Profiling
+//	<!> "stat EDU_TickLanes" in the console, or the EDU_TickLane channel in
+//		Unreal Insights (-trace=cpu,stats,EDU_TickLane).
+//------------------------------------------------------------------------------
+
+DECLARE_STATS_GROUP(TEXT("EDU Aggregated Tick"), STATGROUP_EDU_TickLanes, STATCAT_Advanced);
+
+UE_TRACE_CHANNEL_EXTERN(EDU_TickLaneChannel, EDU_CORE_API);
+
+//------------------------------------------------------------------------------
+// Lane base, owns the time-slicing
+//------------------------------------------------------------------------------
+
+class EDU_CORE_API FTickLane
+{
+public:
+	explicit FTickLane(const FTickLaneSettings& InSettings);
+	virtual ~FTickLane() = default;
+
+	void Tick(const FTickLaneContext& Context);
+
+	const FTickLaneSettings& GetSettings() const { return Settings; }
+
+	// Members processed this frame
+	int32 GetItemsThisFrame() const { return ItemsThisFrame; }
+
+	// AsyncedClock seconds the last full cycle took
+	float GetLastCycleLatency() const { return LastCycleLatency; }
+
+	// Calc + Exec wall time this frame
+	float GetLastFrameMs() const { return LastFrameMs; }
+
+	/*----------------------- Game thread callbacks --------------------------------
+	  Counts AsyncTasks queued to the game thread. Lanes tick one at a time, so
+	  the difference before and after a lane is what that lane produced.
+	------------------------------------------------------------------------------*/
+	
+	static inline std::atomic<int32> AsyncTaskCounter { 0 };
+
+protected:
+	virtual int32 GetNum() const = 0;
+	virtual void ProcessCalc(int32 StartIndex, int32 EndIndex, const FTickLaneContext& Context) = 0;
+	virtual void ProcessExec(int32 StartIndex, int32 EndIndex, const FTickLaneContext& Context) = 0;
+
+	float GetLaneDeltaTime(const FTickLaneContext& Context) const
+	{
+		return Settings.Clock == ETickLaneClock::Async ? Context.AsyncDeltaTime : Context.DeltaTime;
+	}
+
+	//------------------------------------------------------------------------------
+	// Budgeted mode
+	//------------------------------------------------------------------------------
+	
+	int32 CalculateBatchSize(int32 Num, const FTickLaneContext& Context) const;
+	void UpdateParallelChunking(int32 ItemCount);
+	void RecordCost(double CalcSeconds, double ExecSeconds, int32 ItemCount);
+
+	FTickLaneSettings Settings;
+
+	int32 BatchIndex = 0;
+	float LastCycleTime = 0.f;
+
+	// Measured wall time per member
+	double CalcCostPerItemMs = 0.0;
+	double ExecCostPerItemMs = 0.0;
+	double CostPerItemMs = 0.0;
+
+	// ParallelFor chunking for the Calc phase
+	int32 ParallelMinBatchSize = 1;
+	EParallelForFlags ParallelFlags = EParallelForFlags::None;
+
+	//------------------------------------------------------------------------------
+	// Profiling
+	//------------------------------------------------------------------------------
+	
+	int32 ItemsThisFrame = 0;
+	float LastCycleLatency = 0.f;
+	float LastFrameMs = 0.f;
+
+	// Cached, so the trace scopes don't build strings every frame.
+	FString CalcScopeName;
+	FString ExecScopeName;
+	
+#if STATS
+	TStatId CalcStatId;
+	TStatId ExecStatId;
+	TStatId ItemsStatId;
+	TStatId CycleLatencyStatId;
+	TStatId AsyncTaskStatId;
+#endif
+};
+
+// Drop-in for AsyncTask(ENamedThreads::GameThread, ...) that is counted by the lane profiler.
+template<typename FunctionType>
+void TickLaneAsyncTask(FunctionType&& Function)
+{
+	FTickLane::AsyncTaskCounter.fetch_add(1, std::memory_order_relaxed);
+	AsyncTask(ENamedThreads::GameThread, Forward<FunctionType>(Function));
+}
+
+//------------------------------------------------------------------------------
+// Typed lane, binds an aggregated array to its Calc/Exec member functions
+//------------------------------------------------------------------------------
+
+template<typename ElementType, typename CalcFunctionType, typename ExecFunctionType>
+class TTickLane final : public FTickLane
+{
+public:
+	TTickLane(const FTickLaneSettings& InSettings, TArray<TObjectPtr<ElementType>>& InArray, CalcFunctionType InCalc, ExecFunctionType InExec)
+	: FTickLane(InSettings), Array(InArray), Calc(InCalc), Exec(InExec)
+	{}
+
+protected:
+	virtual int32 GetNum() const override { return Array.Num(); }
+
+	// Parallel batch processing of Calc
+	virtual void ProcessCalc(const int32 StartIndex, const int32 EndIndex, const FTickLaneContext& Context) override
+	{
+		if constexpr (!std::is_same_v<CalcFunctionType, std::nullptr_t>)
+		{
+			const float LaneDeltaTime = GetLaneDeltaTime(Context);
+			const int32 CurrentBatchIndex = Context.CurrentBatchIndex;
+			
+			ParallelFor(TEXT("TickLane Calc"), EndIndex - StartIndex, ParallelMinBatchSize, [this, StartIndex, LaneDeltaTime, CurrentBatchIndex](const int32 LocalIndex)
+			{
+				Invoke(Array[StartIndex + LocalIndex], Calc, LaneDeltaTime, CurrentBatchIndex);
+			}, ParallelFlags);
+		}
+	}
+
+	// Sequential batch processing of Exec
+	virtual void ProcessExec(const int32 StartIndex, const int32 EndIndex, const FTickLaneContext& Context) override
+	{
+		if constexpr (!std::is_same_v<ExecFunctionType, std::nullptr_t>)
+		{
+			const float LaneDeltaTime = GetLaneDeltaTime(Context);
+			
+			// The registries are locked while lanes tick, re-check Num() anyway in case an Exec adds or the array was not a registry.
+			for(int32 Index = StartIndex; Index < EndIndex && Index < Array.Num(); ++Index)
+			{
+				Invoke(Array[Index], Exec, LaneDeltaTime, Context.CurrentBatchIndex);
+			}
+		}
+	}
+
+private:
+	template<typename FunctionType>
+	static FORCEINLINE void Invoke(ElementType* Element, FunctionType Function, const float DeltaTime, const int32 CurrentBatchIndex)
+	{
+		// Destroyed this frame, its removal is queued until the registries unlock.
+		if(!IsValid(Element)) return;
+		
+		if constexpr (std::is_invocable_v<FunctionType, ElementType*, float, int32>)
+		{
+			(Element->*Function)(DeltaTime, CurrentBatchIndex);
+		}
+		else if constexpr (std::is_invocable_v<FunctionType, ElementType*, float>)
+		{
+			(Element->*Function)(DeltaTime);
+		}
+		else
+		{
+			(Element->*Function)();
+		}
+	}
+
+	TArray<TObjectPtr<ElementType>>& Array;
+	CalcFunctionType Calc;
+	ExecFunctionType Exec;
+};
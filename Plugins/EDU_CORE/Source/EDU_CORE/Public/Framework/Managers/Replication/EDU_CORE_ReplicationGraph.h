@@ -0,0 +1,188 @@
+﻿// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TeamVisibility.h"
+#include "EDU_CORE_ReplicationGraph.generated.h"
+
+class UStatusComponent;
+class AEDU_CORE_Waypoint;
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+
+/*------------------------------------------------------------------------------
+  Replication Graph
+--------------------------------------------------------------------------------
+  Replaces the default net driver relevancy walk, which tests every
+  replicated actor against every connection, with nodes that hand each
+  connection prebuilt actor lists.
+
+	Team:			Waypoints, and entities with a StatusComponent. A team's list
+					holds its own entities and waypoints, wherever they are.
+					Built at most once per frame per team, shared by every
+					connection on that team.
+	TeamGrid:		The same entities, on one 2D grid per team. An entity is in
+					a team's grid while that enemy team sees it, see
+					UStatusComponent::IsNetRelevantForTeam, so enemies are
+					culled by distance like any other actor. Spectators use a
+					grid that holds every entity.
+	Grid:			Everything else that moves, spatialized on a 2D grid, and
+					static actors, which are only revisited when they wake from
+					dormancy.
+	AlwaysRelevant:	GameState and other infos, plus the connection's own
+					PlayerController and camera.
+
+  <!> IsNetRelevantFor isn't called by the graph, the team and team grid
+	  nodes apply the same rules as AEDU_CORE_PhysicsEntity::IsNetRelevantFor,
+	  and the grids add the cull distance on top.
+
+  Enabled in DefaultEngine.ini, ReplicationDriverClassName.
+------------------------------------------------------------------------------*/
+
+UENUM()
+enum class EEDU_CORE_ReplicationNode : uint8
+{
+	NotRouted,
+	AlwaysRelevant,
+	Team,
+	TeamEntity,
+	Spatialize_Static,
+	Spatialize_Dynamic,
+	Spatialize_Dormancy,
+};
+
+UCLASS(Transient, Config = Engine)
+class EDU_CORE_API UEDU_CORE_ReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* ConnectionManager) override;
+
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+
+	// Size of a grid cell, should be around the distance a connection cares about.
+	UPROPERTY(Config)
+	float GridCellSize = 10000.f;
+
+	// Lowest world XY of the grid, actors below it are clamped into the first cells.
+	UPROPERTY(Config)
+	FVector2D GridSpatialBias = FVector2D(-200000.f, -200000.f);
+
+protected:
+	EEDU_CORE_ReplicationNode GetNodeFor(const AActor* Actor) const;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	UPROPERTY()
+	TObjectPtr<class UEDU_CORE_ReplicationGraphNode_Team> TeamNode;
+
+	UPROPERTY()
+	TObjectPtr<class UEDU_CORE_ReplicationGraphNode_TeamGrid> TeamGridNode;
+};
+
+/*------------------------------------------------------------------------------
+  Team Node
+--------------------------------------------------------------------------------
+  Holds every team entity once, and builds the list of one team on the
+  first gather of a frame that asks for it. The cost is entities x teams
+  in play, not entities x connections. Enemies come from the TeamGrid node.
+------------------------------------------------------------------------------*/
+
+UCLASS()
+class EDU_CORE_API UEDU_CORE_ReplicationGraphNode_Team : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UEDU_CORE_ReplicationGraphNode_Team();
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
+
+private:
+	struct FTeamEntity
+	{
+		AActor* Actor = nullptr;
+
+		// Entities, nullptr for waypoints.
+		UStatusComponent* StatusComponent = nullptr;
+		AEDU_CORE_Waypoint* Waypoint = nullptr;
+	};
+
+	void BuildTeamList(EEDU_CORE_Team Team, uint32 FrameNum);
+
+	TArray<FTeamEntity> TeamEntities;
+
+	// Per team, rebuilt once per frame. Spectators get every waypoint, and entities from the TeamGrid node.
+	FActorRepListRefView TeamLists[FTeamVisibility::NumTeams];
+	uint32 TeamListFrames[FTeamVisibility::NumTeams];
+	FActorRepListRefView AllWaypoints;
+};
+
+/*------------------------------------------------------------------------------
+  Team Grid Node
+--------------------------------------------------------------------------------
+  One spatialization grid per team, holding the enemy entities that team
+  sees. Membership is synced once per frame in PrepareForReplication, an
+  entity is added to a team's grid when the team starts seeing it, and
+  removed once IsNetRelevantForTeam lets it go. Connections gather from the
+  grid of their team, around their viewers, like the Grid node.
+------------------------------------------------------------------------------*/
+
+UCLASS()
+class EDU_CORE_API UEDU_CORE_ReplicationGraphNode_TeamGrid : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	UEDU_CORE_ReplicationGraphNode_TeamGrid();
+
+	void InitGrids(float CellSize, const FVector2D& SpatialBias);
+
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+
+	virtual void PrepareForReplication() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	virtual void LogNode(FReplicationGraphDebugInfo& DebugInfo, const FString& NodeName) const override;
+
+private:
+	struct FGridEntity
+	{
+		AActor* Actor = nullptr;
+		UStatusComponent* StatusComponent = nullptr;
+		float GracePeriod = 0.f;
+		bool bDynamic = true;
+
+		// Teams whose grid holds the entity, the spectator grid always does.
+		FTeamVisibility::FTeamMask InTeamGrids = 0;
+	};
+
+	void AddToGrid(int32 GridIndex, const FGridEntity& Entity) const;
+	void RemoveFromGrid(int32 GridIndex, const FGridEntity& Entity) const;
+
+	TArray<FGridEntity> Entities;
+
+	// One per team, the last one is for spectators.
+	static constexpr int32 SpectatorGrid = FTeamVisibility::NumTeams;
+
+	UPROPERTY()
+	TArray<TObjectPtr<UReplicationGraphNode_GridSpatialization2D>> Grids;
+};
@@ -4,6 +4,9 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/PlayerController.h"
+#include "Entities/EDU_CORE_PhysicsEntity.h"
+#include "Framework/Managers/GameModes/EDU_CORE_TickLane.h"
+#include "Framework/Managers/GameModes/EDU_CORE_FrameTimeRecorder.h"
 #include "EDU_CORE_PlayerController.generated.h"
 
 struct FInputActionValue;
@@ -79,6 +82,7 @@ public:
 	// Adds entity to the Local PlayerController Tick, running only on a client.
 	void AddToAbstractEntityArray(AEDU_CORE_AbstractEntity* TickingEntity);
 	void AddToPhysicsEntityArray(AEDU_CORE_PhysicsEntity* MobileEntity);
+	void RemoveFromPhysicsEntityArray(AEDU_CORE_PhysicsEntity* PhysicsEntity);
 	
 	virtual void SetMappingContext(EEDU_CORE_MappingContext Context);
 	
@@ -119,6 +123,79 @@ protected:
 	int32 PhysicsEntityBatch = 100;
 	int32 PhysicsEntityIndex = 0;
 
+	/*------------------------- Client Physics Lane --------------------------------
+	  A client-side tick lane over PhysicsEntityArray, see EDU_CORE_TickLane.h.
+	  ClientPhysicsCalc samples every entity in a ParallelFor into
+	  ClientPhysicsTransforms, index for index, then ClientPhysicsExec moves
+	  only the entities that changed. Entities are skipped on the frames their
+	  significance doesn't update.
+
+	  Like the server lanes it shows up in "stat EDU_TickLanes", can run on a
+	  budget, and is recorded, see ClientFrameTimes().
+	------------------------------------------------------------------------------*/
+	friend class FClientPhysicsLane;
+	
+	void ClientPhysicsTick(float DeltaTime);
+
+	// Calc and Exec of the lane, over [StartIndex, EndIndex) of PhysicsEntityArray.
+	void ClientPhysicsCalc(int32 StartIndex, int32 EndIndex, int32 MinBatchSize, EParallelForFlags Flags);
+	void ClientPhysicsExec(int32 StartIndex, int32 EndIndex);
+
+	TUniquePtr<FTickLane> ClientPhysicsLane;
+	
+	TArray<FClientPhysicsTransform> ClientPhysicsTransforms;
+
+	// Sampled once per frame before the lane, entities render behind it.
+	double ClientPhysicsServerTime = 0.0;
+
+	// Seconds between full passes, 0 updates every entity every frame.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Physics", meta = (ClampMin = "0", Units = "s"))
+	float ClientPhysicsPeriod = 0.f;
+
+	// With a Period, milliseconds per frame the lane may spend, 0 processes the whole array each pass.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Physics", meta = (ClampMin = "0"))
+	float ClientPhysicsBudgetMs = 0.f;
+
+	// Entities per ParallelFor task in the significance pass, bucketing one is too cheap to dispatch alone.
+	UPROPERTY(EditDefaultsOnly)
+	int32 ClientPhysicsMinBatchSize = 64;
+
+	// Frame time and the client physics lane, channel 0 and 1.
+	FFrameTimeRecorder ClientFrameTimeRecorder;
+
+	// Prints p50/p95/p99/max of the frame and the client physics lane.
+	UFUNCTION(Exec)
+	void ClientFrameTimes() const;
+
+	/*------------------------- Client Significance --------------------------------
+	  Buckets every PhysicsEntity by the view of the local player, see
+	  EEDU_CORE_ClientSignificance. Zoomed out, most entities are far away or
+	  off screen and don't need an update every frame.
+	------------------------------------------------------------------------------*/
+	void UpdateClientSignificance();
+
+	// Seconds between bucketing passes.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Significance", meta = (ClampMin = "0", Units = "s"))
+	float SignificanceUpdateInterval = 0.25f;
+
+	// On screen entities closer than this to the camera update every frame.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Significance", meta = (ClampMin = "0", Units = "cm"))
+	float FullUpdateDistance = 15000.f;
+
+	// Entities further than this from the camera aren't updated.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Significance", meta = (ClampMin = "0", Units = "cm"))
+	float FrozenDistance = 300000.f;
+
+	// Frames between updates of Reduced entities, staggered so they don't all land on the same frame.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Significance", meta = (ClampMin = "1"))
+	int32 ReducedUpdateInterval = 4;
+
+	// Added to the entity bounds in the frustum test, so entities at the screen edge are in place before they enter it.
+	UPROPERTY(EditDefaultsOnly, Category = "Client Significance", meta = (ClampMin = "0", Units = "cm"))
+	float SignificanceFrustumMargin = 1000.f;
+
+	float NextSignificanceUpdate = 0.f;
+
 	
 //------------------------------------------------------------------------------
 // Functionality: Utility
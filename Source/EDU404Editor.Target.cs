@@ -11,5 +11,8 @@ public class EDU404EditorTarget : TargetRules
 		DefaultBuildSettings = BuildSettingsVersion.V5;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_4;
 		ExtraModuleNames.Add("EDU404");
+
+		// Push based properties, like the team visibility of StatusComponent, are only compared after they are marked dirty.
+		bWithPushModel = true;
 	}
 }